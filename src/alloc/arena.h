@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <new>
+
+#include "common.h"
+#include "pages.h"
+#include "types.h"
+
+namespace Relax {
+
+#pragma region TArena
+
+    //////////////////////////////////////////////////////////////////
+    struct TArenaStats {
+        // chunks requested from the system
+        std::atomic<uint64_t> m_system_allocs = 0;
+
+        // bytes of chunks held by all arenas
+        std::atomic<uint64_t> m_reserved = 0;
+    };
+
+    //--------------------------------------------------------------//
+    inline TArenaStats& ArenaStats() {
+        static TArenaStats stats;
+        return stats;
+    }
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Arena of small objects, single owner (not thread-safe).
+     *  * Objects are cut from contiguous chunks by bump pointer, chunk size doubles up to m_max_chunk
+     *  * Freed object goes to free list of its size class (m_granularity bytes each), next allocation
+     *    of the class takes it first
+     *  * release - frees all chunks in O(chunks), objects are not destroyed
+     * Pages - chunk source (THeapPages, THugePages), chunk sizes are rounded up to its granularity
+     */
+    template<class Pages = THeapPages>
+    class TArena {
+        struct Chunk {
+            Chunk* m_next;
+
+            size_t m_size;
+        };
+
+        struct FreeNode {
+            FreeNode* m_next;
+        };
+
+    public:
+        static constexpr size_t m_granularity = 16;
+
+        // larger objects are not served by arena
+        static constexpr size_t m_max_size = 256;
+
+        static constexpr size_t m_min_chunk = 4096;
+
+        static constexpr size_t m_max_chunk = 1 << 20;
+
+    public:
+        TArena() = default;
+        ~TArena();
+
+        TArena(const TArena& other) = delete;
+        TArena(TArena&& other) noexcept = delete;
+        TArena& operator=(const TArena& other) = delete;
+        TArena& operator=(TArena&& other) noexcept = delete;
+
+        // size <= m_max_size, alignment <= m_granularity
+        void* allocate(size_t size);
+
+        void deallocate(void* ptr, size_t size) noexcept;
+
+        void release() noexcept;
+
+        // bytes of chunks held by arena
+        size_t reserved() const noexcept;
+
+    private:
+        static inline size_t sizeClass(size_t size) noexcept;
+
+        // new chunk for object of size bytes: the rest of current chunk is lost
+        void grow(size_t size);
+
+    private:
+        std::array<FreeNode*, m_max_size / m_granularity> m_free = {};
+
+        char* m_cursor = nullptr;
+
+        char* m_end = nullptr;
+
+        Chunk* m_chunks = nullptr;
+
+        size_t m_next_chunk = m_min_chunk;
+
+        size_t m_reserved = 0;
+
+        static constexpr size_t m_header_size = (sizeof(Chunk) + m_granularity - 1) / m_granularity * m_granularity;
+    };
+
+    //--------------------------------------------------------------//
+    template<class P>
+    inline TArena<P>::~TArena() {
+        release();
+    }
+
+    //--------------------------------------------------------------//
+    template<class P>
+    inline size_t TArena<P>::sizeClass(size_t size) noexcept {
+        assert(0 < size && size <= m_max_size);
+        return (size - 1) / m_granularity;
+    }
+
+    //--------------------------------------------------------------//
+    template<class P>
+    inline void* TArena<P>::allocate(size_t size) {
+        FreeNode*& free = m_free[sizeClass(size)];
+        if (nullptr != free) {
+            FreeNode* const node = free;
+            free = node->m_next;
+            return node;
+        }
+
+        const size_t rounded = (sizeClass(size) + 1) * m_granularity;
+        if (static_cast<size_t>(m_end - m_cursor) < rounded)
+            grow(rounded);
+
+        void* const ptr = m_cursor;
+        m_cursor += rounded;
+        return ptr;
+    }
+
+    //--------------------------------------------------------------//
+    template<class P>
+    inline void TArena<P>::deallocate(void* ptr, size_t size) noexcept {
+        FreeNode*& free = m_free[sizeClass(size)];
+        free = new (ptr) FreeNode{free};
+    }
+
+    //--------------------------------------------------------------//
+    template<class P>
+    inline void TArena<P>::grow(size_t size) {
+        const size_t min_size = std::max(m_next_chunk, m_header_size + size);
+        const size_t chunk_size = (min_size + P::m_granularity - 1) / P::m_granularity * P::m_granularity;
+        char* const memory = static_cast<char*>(P::allocate(chunk_size, m_granularity));
+
+        m_chunks = new (memory) Chunk{m_chunks, chunk_size};
+        m_cursor = memory + m_header_size;
+        m_end = memory + chunk_size;
+
+        m_next_chunk = std::min(m_next_chunk * 2, m_max_chunk);
+        m_reserved += chunk_size;
+
+        TArenaStats& stats = ArenaStats();
+        stats.m_system_allocs.fetch_add(1, std::memory_order_relaxed);
+        stats.m_reserved.fetch_add(chunk_size, std::memory_order_relaxed);
+    }
+
+    //--------------------------------------------------------------//
+    template<class P>
+    inline void TArena<P>::release() noexcept {
+        while (nullptr != m_chunks) {
+            Chunk* const chunk = m_chunks;
+            m_chunks = chunk->m_next;
+            P::deallocate(chunk, chunk->m_size, m_granularity);
+        }
+
+        ArenaStats().m_reserved.fetch_sub(m_reserved, std::memory_order_relaxed);
+
+        m_free.fill(nullptr);
+        m_cursor = nullptr;
+        m_end = nullptr;
+        m_next_chunk = m_min_chunk;
+        m_reserved = 0;
+    }
+
+    //--------------------------------------------------------------//
+    template<class P>
+    inline size_t TArena<P>::reserved() const noexcept {
+        return m_reserved;
+    }
+
+#pragma endregion TArena
+
+#pragma region ArenaAllocator
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Allocator facade of TArena: single small objects from arena, the rest from std::allocator.
+     * Default constructed allocator owns new arena, copies and rebinds share it.
+     * Arena is not thread-safe: container serializes allocations (e.g. by its lock).
+     * Pages - chunk source of arena, e.g. THugePages for large trees: fewer TLB misses on lookups.
+     */
+    template<class T, class Pages = THeapPages>
+    class ArenaAllocator {
+        template<class U, class P>
+        friend class ArenaAllocator;
+
+        typedef TArena<Pages> arena_type;
+
+    public:
+        typedef T value_type;
+        typedef size_t size_type;
+        typedef std::false_type is_always_equal;
+
+        // freed objects stay readable until release: objects larger than arena's are not served by it
+        typedef std::bool_constant<sizeof(T) <= arena_type::m_max_size && alignof(T) <= arena_type::m_granularity>
+            is_type_stable;
+
+        template<class U>
+        struct rebind {
+            typedef ArenaAllocator<U, Pages> other;
+        };
+
+    public:
+        ArenaAllocator()
+          : m_arena(std::make_shared<arena_type>()) { }
+
+        template<class U>
+        ArenaAllocator(const ArenaAllocator<U, Pages>& other) noexcept
+          : m_arena(other.m_arena) { }
+
+        T* allocate(size_type n) {
+            if (fromArena(n))
+                return static_cast<T*>(m_arena->allocate(sizeof(T)));
+            return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T* ptr, size_type n) noexcept {
+            if (fromArena(n))
+                m_arena->deallocate(ptr, sizeof(T));
+            else
+                std::allocator<T>().deallocate(ptr, n);
+        }
+
+        // frees memory of all objects allocated from arena at once: they must be already destroyed
+        void release() noexcept { m_arena->release(); }
+
+        template<class U>
+        bool operator==(const ArenaAllocator<U, Pages>& other) const noexcept {
+            return m_arena == other.m_arena;
+        }
+
+        template<class U>
+        bool operator!=(const ArenaAllocator<U, Pages>& other) const noexcept {
+            return m_arena != other.m_arena;
+        }
+
+    private:
+        static constexpr bool fromArena(size_type n) noexcept {
+            return 1 == n && sizeof(T) <= arena_type::m_max_size && alignof(T) <= arena_type::m_granularity;
+        }
+
+    private:
+        std::shared_ptr<arena_type> m_arena;
+    };
+
+#pragma endregion ArenaAllocator
+
+}  // namespace Relax
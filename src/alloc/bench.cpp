@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include "node_pool.h"
+#include "queue/intrusive_queue.h"
+#include "test/test.h"
+
+namespace Test {
+    //////////////////////////////////////////////////////////////////
+    class BenchObjectPool : public ::testing::Test {
+    public:
+        using value_t = uint64_t;
+
+        struct Message : Relax::TChainableBase<Message> {
+            Message(value_t value)
+              : m_value(value) { }
+
+            value_t m_value;
+            value_t m_payload[6] = {};
+        };
+
+        //--------------------------------------------------------------//
+        struct NewDeletePool {
+            static Message* create(value_t value) { return new Message(value); }
+
+            static void destroy(Message* message) noexcept { delete message; }
+        };
+
+        //--------------------------------------------------------------//
+        // messages in flight between producers and consumers
+        struct TCrossThread {
+            Relax::IntrusiveMutexFreeQueue<Message> m_queue;
+
+            std::atomic<uint64_t> m_npopped = 0;
+        };
+
+        BenchObjectPool() { }
+
+        BenchObjectPool(const BenchObjectPool& other) = delete;
+        BenchObjectPool(BenchObjectPool&& other) noexcept = delete;
+        BenchObjectPool& operator=(const BenchObjectPool& other) = delete;
+        BenchObjectPool& operator=(BenchObjectPool&& other) noexcept = delete;
+
+        // even threads create and push messages, odd threads pop and destroy them
+        template<class Pool>
+        static std::pair<Duration, Duration> benchCrossThread(uint64_t sample_size,
+                                                              uint32_t nthreads,
+                                                              uint32_t niterations);
+
+        static void report(std::pair<Duration, Duration> lfstat, std::pair<Duration, Duration> std_stat);
+
+    public:
+        static constexpr uint32_t m_sample_size = 1000000;
+
+        static constexpr uint32_t m_nsamples = 5;
+
+        static constexpr std::array<uint32_t, 4> m_nthread_modes = {2, 8, 32, 1024};
+    };
+
+    //--------------------------------------------------------------//
+    template<class Pool>
+    std::pair<Duration, Duration> BenchObjectPool::benchCrossThread(uint64_t sample_size,
+                                                                    uint32_t nthreads,
+                                                                    uint32_t niterations) {
+        return BenchThreads<TCrossThread>(
+            nthreads,
+            niterations,
+            [](uint32_t thread_id, uint32_t nthreads, TCrossThread& bench, uint64_t sample_size) -> int {
+                const uint64_t per_producer = sample_size / (nthreads / 2);
+
+                if (0 == thread_id % 2) {
+                    for (uint64_t i = 0; i < per_producer; ++i) {
+                        bench.m_queue.push(Pool::create(i));
+                    }
+
+                    return 0;
+                }
+
+                while (bench.m_npopped.load(std::memory_order_relaxed) < sample_size) {
+                    Message* const message = bench.m_queue.pop();
+                    if (nullptr == message) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    bench.m_npopped.fetch_add(1, std::memory_order_relaxed);
+                    Pool::destroy(message);
+                }
+
+                return 0;
+            },
+            sample_size);
+    }
+
+    //--------------------------------------------------------------//
+    void BenchObjectPool::report(std::pair<Duration, Duration> lfstat, std::pair<Duration, Duration> std_stat) {
+        std::cout << std::fixed << std::setprecision(2) << std::setw(6);
+        const auto width = std::setw(15);
+
+        const double lf_time_μs = (double)lfstat.first.Microseconds();
+        const double std_time_μs = (double)std_stat.first.Microseconds();
+        const double std_diff = ((std_time_μs / lf_time_μs) - 1) * 100;
+
+        std::cout << "Pool  time: " << width << lfstat.first.StrMilli() << "   dev: " << width
+                  << lfstat.second.StrMilli() << std::endl;
+        std::cout << "New   time: " << width << std_stat.first.StrMilli() << "   dev: " << width
+                  << std_stat.second.StrMilli() << width << " rel imp: " << (std_diff > 0 ? '+' : ' ')
+                  << std::setprecision(2) << std_diff << "%" << std::endl;
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(BenchObjectPool, cross_thread) {
+        for (uint32_t nthreads : m_nthread_modes) {
+            std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
+            const uint64_t size = m_sample_size - (m_sample_size % (nthreads / 2));
+
+            const uint64_t start = Relax::NodePoolStats().m_system_allocs.load(std::memory_order_relaxed);
+            auto lfstat = benchCrossThread<Relax::ObjectPool<Message>>(size, nthreads, m_nsamples);
+            const uint64_t nallocs = Relax::NodePoolStats().m_system_allocs.load(std::memory_order_relaxed) - start;
+
+            auto std_stat = benchCrossThread<NewDeletePool>(size, nthreads, m_nsamples);
+
+            report(lfstat, std_stat);
+            std::cout << "Pool system allocs per message: " << (double)nallocs / (size * m_nsamples) << std::endl;
+        }
+    }
+
+}  // namespace Test
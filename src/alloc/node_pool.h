@@ -0,0 +1,486 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "common.h"
+#include "pages.h"
+#include "stack/intrusive_stack.h"
+#include "types.h"
+
+namespace Relax {
+
+#pragma region TNodePool
+
+    //////////////////////////////////////////////////////////////////
+    struct TNodePoolStats {
+        // chunks requested from the system
+        std::atomic<uint64_t> m_system_allocs = 0;
+
+        // full magazines returned to depot by threads with overfull cache
+        std::atomic<uint64_t> m_batch_returns = 0;
+
+        // magazines allocated when empty depot is exhausted (heap allocations besides chunks)
+        std::atomic<uint64_t> m_magazine_allocs = 0;
+    };
+
+    //--------------------------------------------------------------//
+    inline TNodePoolStats& NodePoolStats() {
+        static TNodePoolStats stats;
+        return stats;
+    }
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Pool of fixed-size nodes.
+     *  * Thread-local cache of two magazines (arrays of free nodes) serves allocate/deallocate WO atomics
+     *  * Both magazines full: one full magazine goes to global depot, cache takes empty one
+     *  * Both magazines empty: cache takes full magazine from depot, allocates new chunk if depot is empty
+     *  * Depots of full and empty magazines are IntrusiveMutexFreeStack: single CAS per magazine exchange
+     *  * deallocate never allocates: node goes to global free list if no empty magazine can be allocated,
+     *    refill drains the list
+     *  * After thread-local cache is destroyed (static objects after exit of main thread) nodes go to
+     *    the free list and are taken from it or from depots directly
+     *  * Memory is never returned to the system (type-stable)
+     *  * Pages - chunk source (THeapPages, THugePages): pools of different sources do not share nodes
+     */
+    template<size_t Size, size_t Align, class Pages = THeapPages>
+    class TNodePool {
+        struct Chunk {
+            Chunk* m_next;
+        };
+
+        // node freed WO magazine
+        struct FreeNode {
+            FreeNode* m_next;
+        };
+
+        struct Magazine;
+
+        // magazines are taken on first allocate/deallocate: nullptr until then and after destruction
+        struct Cache {
+            Cache() = default;
+            ~Cache();
+
+            // allocate/deallocate work here
+            Magazine* m_loaded = nullptr;
+
+            // second magazine: keeps cache from bouncing magazines on alloc/free boundary
+            Magazine* m_previous = nullptr;
+        };
+
+    public:
+        static constexpr size_t m_align = std::max({Align, alignof(Chunk), alignof(FreeNode)});
+
+        static constexpr size_t m_node_size =
+            (std::max({Size, sizeof(Chunk), sizeof(FreeNode)}) + m_align - 1) / m_align * m_align;
+
+        // whole huge page per chunk for huge page source
+        static constexpr size_t m_chunk_nodes =
+            std::max<size_t>(64, std::max<size_t>(16384, Pages::m_granularity) / m_node_size);
+
+        // nodes per magazine
+        static constexpr size_t m_batch_size = 128;
+
+    private:
+        struct Magazine : TChainableBase<Magazine> {
+            size_t m_size = 0;
+            void* m_nodes[m_batch_size];
+
+            inline bool full() const noexcept { return m_batch_size == m_size; }
+        };
+
+    public:
+        TNodePool(const TNodePool& other) = delete;
+        TNodePool(TNodePool&& other) noexcept = delete;
+        TNodePool& operator=(const TNodePool& other) = delete;
+        TNodePool& operator=(TNodePool&& other) noexcept = delete;
+
+        static void* allocate();
+
+        static void deallocate(void* ptr) noexcept;
+
+    private:
+        TNodePool() = default;
+
+        // never destroyed: nodes may be freed by static objects after exit
+        static TNodePool& instance();
+
+        // takes two empty magazines into cache, false - out of memory or cache is destroyed
+        bool load(Cache& cache) noexcept;
+
+        // allocate WO cache: free list, then depots
+        void* allocateUncached();
+
+        // replaces empty loaded magazine of cache by full one
+        void refill(Cache& cache);
+
+        // replaces full loaded magazine of cache by empty one, false - out of memory
+        bool flush(Cache& cache) noexcept;
+
+        // fills first by nodes of new chunk, the rest of chunk goes to full depot
+        void carve(Magazine* first);
+
+        // magazines are never freed: popped magazine may be read by concurrent pop
+        Magazine* takeEmpty();
+
+        // nullptr - out of memory
+        Magazine* tryTakeEmpty() noexcept;
+
+        // empty magazine to empty depot, other to full depot
+        void release(Magazine* magazine) noexcept;
+
+    private:
+        // not empty magazines
+        IntrusiveMutexFreeStack<Magazine> m_full;
+
+        IntrusiveMutexFreeStack<Magazine> m_empty;
+
+        IntrusiveMutexFreeStack<Chunk> m_chunks;
+
+        // nodes freed when no empty magazine could be allocated
+        IntrusiveMutexFreeStack<FreeNode> m_free_nodes;
+
+        static thread_local Cache m_cache;
+
+        // trivial: readable after m_cache destruction
+        static thread_local bool m_cache_destroyed;
+    };
+
+    //--------------------------------------------------------------//
+    template<size_t Size, size_t Align, class Pages>
+    thread_local typename TNodePool<Size, Align, Pages>::Cache TNodePool<Size, Align, Pages>::m_cache;
+
+    //--------------------------------------------------------------//
+    template<size_t Size, size_t Align, class Pages>
+    thread_local bool TNodePool<Size, Align, Pages>::m_cache_destroyed = false;
+
+    //--------------------------------------------------------------//
+    template<size_t Size, size_t Align, class Pages>
+    TNodePool<Size, Align, Pages>::Cache::~Cache() {
+        // later allocate/deallocate of this thread see nullptr and bypass the cache
+        m_cache_destroyed = true;
+        if (nullptr == m_loaded)
+            return;
+
+        TNodePool& pool = instance();
+        pool.release(m_loaded);
+        pool.release(m_previous);
+        m_loaded = nullptr;
+        m_previous = nullptr;
+    }
+
+    //--------------------------------------------------------------//
+    template<size_t Size, size_t Align, class Pages>
+    TNodePool<Size, Align, Pages>& TNodePool<Size, Align, Pages>::instance() {
+        static TNodePool* const pool = new TNodePool();
+        return *pool;
+    }
+
+    //--------------------------------------------------------------//
+    template<size_t Size, size_t Align, class Pages>
+    inline void* TNodePool<Size, Align, Pages>::allocate() {
+        Cache& cache = m_cache;
+
+        if (nullptr == cache.m_loaded) {
+            TNodePool& pool = instance();
+            if (m_cache_destroyed)
+                return pool.allocateUncached();
+
+            if (!pool.load(cache))
+                throw std::bad_alloc();
+        }
+
+        if (0 == cache.m_loaded->m_size)
+            instance().refill(cache);
+
+        return cache.m_loaded->m_nodes[--cache.m_loaded->m_size];
+    }
+
+    //--------------------------------------------------------------//
+    template<size_t Size, size_t Align, class Pages>
+    inline void TNodePool<Size, Align, Pages>::deallocate(void* ptr) noexcept {
+        if (nullptr == ptr)
+            return;
+
+        Cache& cache = m_cache;
+
+        if (nullptr == cache.m_loaded || cache.m_loaded->full()) {
+            TNodePool& pool = instance();
+            const bool has_room = (nullptr == cache.m_loaded) ? pool.load(cache) : pool.flush(cache);
+            if (!has_room) {
+                pool.m_free_nodes.push(new (ptr) FreeNode{nullptr});
+                return;
+            }
+        }
+
+        cache.m_loaded->m_nodes[cache.m_loaded->m_size++] = ptr;
+    }
+
+    //--------------------------------------------------------------//
+    template<size_t Size, size_t Align, class Pages>
+    bool TNodePool<Size, Align, Pages>::load(Cache& cache) noexcept {
+        // magazines of destroyed cache would never be released
+        if (m_cache_destroyed)
+            return false;
+
+        Magazine* const loaded = tryTakeEmpty();
+        if (nullptr == loaded)
+            return false;
+
+        Magazine* const previous = tryTakeEmpty();
+        if (nullptr == previous) {
+            m_empty.push(loaded);
+            return false;
+        }
+
+        cache.m_loaded = loaded;
+        cache.m_previous = previous;
+        return true;
+    }
+
+    //--------------------------------------------------------------//
+    template<size_t Size, size_t Align, class Pages>
+    void* TNodePool<Size, Align, Pages>::allocateUncached() {
+        FreeNode* const node = m_free_nodes.pop();
+        if (nullptr != node)
+            return node;
+
+        Magazine* magazine = m_full.pop();
+        if (nullptr == magazine) {
+            magazine = takeEmpty();
+            try {
+                carve(magazine);
+            }
+            catch (...) {
+                release(magazine);
+                throw;
+            }
+        }
+
+        void* const result = magazine->m_nodes[--magazine->m_size];
+        release(magazine);
+        return result;
+    }
+
+    //--------------------------------------------------------------//
+    template<size_t Size, size_t Align, class Pages>
+    void TNodePool<Size, Align, Pages>::refill(Cache& cache) {
+        if (0 != cache.m_previous->m_size) {
+            std::swap(cache.m_loaded, cache.m_previous);
+            return;
+        }
+
+        Magazine* const loaded = cache.m_loaded;
+        while (!loaded->full()) {
+            FreeNode* const node = m_free_nodes.pop();
+            if (nullptr == node)
+                break;
+
+            loaded->m_nodes[loaded->m_size++] = node;
+        }
+
+        if (0 != loaded->m_size)
+            return;
+
+        Magazine* const full = m_full.pop();
+        if (nullptr != full) {
+            m_empty.push(cache.m_previous);
+            cache.m_previous = cache.m_loaded;
+            cache.m_loaded = full;
+            return;
+        }
+
+        carve(cache.m_loaded);
+    }
+
+    //--------------------------------------------------------------//
+    template<size_t Size, size_t Align, class Pages>
+    bool TNodePool<Size, Align, Pages>::flush(Cache& cache) noexcept {
+        if (!cache.m_previous->full()) {
+            std::swap(cache.m_loaded, cache.m_previous);
+            return true;
+        }
+
+        // both full
+        Magazine* const empty = tryTakeEmpty();
+        if (nullptr == empty)
+            return false;
+
+        m_full.push(cache.m_previous);
+        NodePoolStats().m_batch_returns.fetch_add(1, std::memory_order_relaxed);
+
+        cache.m_previous = cache.m_loaded;
+        cache.m_loaded = empty;
+        return true;
+    }
+
+    //--------------------------------------------------------------//
+    template<size_t Size, size_t Align, class Pages>
+    void TNodePool<Size, Align, Pages>::carve(Magazine* const first) {
+        char* const memory = static_cast<char*>(Pages::allocate(m_node_size * m_chunk_nodes, m_align));
+        NodePoolStats().m_system_allocs.fetch_add(1, std::memory_order_relaxed);
+
+        // first node - chunk header, the rest fill magazines
+        m_chunks.push(new (memory) Chunk{nullptr});
+
+        Magazine* magazine = first;
+        for (size_t i = 1; i < m_chunk_nodes; ++i) {
+            if (magazine->full()) {
+                if (magazine != first)
+                    m_full.push(magazine);
+                magazine = takeEmpty();
+            }
+
+            magazine->m_nodes[magazine->m_size++] = memory + i * m_node_size;
+        }
+
+        if (magazine != first)
+            m_full.push(magazine);
+    }
+
+    //--------------------------------------------------------------//
+    template<size_t Size, size_t Align, class Pages>
+    typename TNodePool<Size, Align, Pages>::Magazine* TNodePool<Size, Align, Pages>::takeEmpty() {
+        Magazine* const magazine = tryTakeEmpty();
+        if (nullptr == magazine)
+            throw std::bad_alloc();
+
+        return magazine;
+    }
+
+    //--------------------------------------------------------------//
+    template<size_t Size, size_t Align, class Pages>
+    typename TNodePool<Size, Align, Pages>::Magazine* TNodePool<Size, Align, Pages>::tryTakeEmpty() noexcept {
+        Magazine* const magazine = m_empty.pop();
+        if (nullptr != magazine)
+            return magazine;
+
+        Magazine* const allocated = new (std::nothrow) Magazine();
+        if (nullptr != allocated)
+            NodePoolStats().m_magazine_allocs.fetch_add(1, std::memory_order_relaxed);
+
+        return allocated;
+    }
+
+    //--------------------------------------------------------------//
+    template<size_t Size, size_t Align, class Pages>
+    void TNodePool<Size, Align, Pages>::release(Magazine* magazine) noexcept {
+        if (0 == magazine->m_size)
+            m_empty.push(magazine);
+        else
+            m_full.push(magazine);
+    }
+
+#pragma endregion TNodePool
+
+#pragma region NodePoolAllocator
+
+    //////////////////////////////////////////////////////////////////
+    // Allocator facade of TNodePool: single objects from pool of Pages chunks, arrays from std::allocator
+    template<class T, class Pages = THeapPages>
+    class NodePoolAllocator {
+        typedef TNodePool<sizeof(T), alignof(T), Pages> pool_type;
+
+    public:
+        typedef T value_type;
+        typedef size_t size_type;
+
+        // freed nodes stay readable forever
+        typedef std::true_type is_type_stable;
+
+        template<class U>
+        struct rebind {
+            typedef NodePoolAllocator<U, Pages> other;
+        };
+
+    public:
+        NodePoolAllocator() noexcept = default;
+
+        template<class U>
+        NodePoolAllocator(const NodePoolAllocator<U, Pages>& other) noexcept {
+            (void)other;
+        }
+
+        T* allocate(size_type n) {
+            if (1 == n)
+                return static_cast<T*>(pool_type::allocate());
+            return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T* ptr, size_type n) noexcept {
+            if (1 == n)
+                pool_type::deallocate(ptr);
+            else
+                std::allocator<T>().deallocate(ptr, n);
+        }
+
+        template<class U>
+        bool operator==(const NodePoolAllocator<U, Pages>& other) const noexcept {
+            (void)other;
+            return true;
+        }
+
+        template<class U>
+        bool operator!=(const NodePoolAllocator<U, Pages>& other) const noexcept {
+            (void)other;
+            return false;
+        }
+    };
+
+#pragma endregion NodePoolAllocator
+
+#pragma region ObjectPool
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Recycles T objects through TNodePool magazines: allocation-free steady state.
+     * Object may be destroyed by any thread, e.g. message created by producer and destroyed by consumer.
+     * Shares nodes with NodePoolAllocator of the same size and alignment.
+     */
+    template<class T>
+    class ObjectPool {
+        typedef TNodePool<sizeof(T), alignof(T)> pool_type;
+
+    public:
+        typedef T value_type;
+
+    public:
+        ObjectPool() = delete;
+
+        template<typename... Args>
+        static T* create(Args&&... args);
+
+        static void destroy(T* ptr) noexcept;
+    };
+
+    //--------------------------------------------------------------//
+    template<class T>
+    template<typename... Args>
+    T* ObjectPool<T>::create(Args&&... args) {
+        void* const memory = pool_type::allocate();
+        try {
+            return new (memory) T(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            pool_type::deallocate(memory);
+            throw;
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class T>
+    void ObjectPool<T>::destroy(T* ptr) noexcept {
+        if (nullptr == ptr)
+            return;
+
+        ptr->~T();
+        pool_type::deallocate(ptr);
+    }
+
+#pragma endregion ObjectPool
+
+}  // namespace Relax
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "common.h"
+
+#if LIN
+    #include <sys/mman.h>
+#endif
+
+namespace Relax {
+
+#pragma region PageSource
+
+    //////////////////////////////////////////////////////////////////
+    struct TPageStats {
+        // chunks of explicit huge pages (MAP_HUGETLB)
+        std::atomic<uint64_t> m_hugetlb_chunks = 0;
+
+        // chunks of normal pages advised to be backed by transparent huge pages
+        std::atomic<uint64_t> m_advised_chunks = 0;
+
+        // chunks of normal pages only: huge pages are not supported
+        std::atomic<uint64_t> m_fallback_chunks = 0;
+    };
+
+    //--------------------------------------------------------------//
+    inline TPageStats& PageStats() {
+        static TPageStats stats;
+        return stats;
+    }
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Chunk source of node arenas (TArena, TNodePool):
+     *    m_granularity             - chunk sizes are rounded up to it
+     *    allocate(size, align)     - throws std::bad_alloc
+     *    deallocate(ptr, size, align)
+     */
+    struct THeapPages {
+        static constexpr size_t m_granularity = 1;
+
+        static inline void* allocate(size_t size, size_t align) {
+            return ::operator new(size, std::align_val_t(align));
+        }
+
+        static inline void deallocate(void* ptr, size_t size, size_t align) noexcept {
+            (void)size;
+            ::operator delete(ptr, std::align_val_t(align));
+        }
+    };
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Huge page backed chunks: one TLB entry maps m_granularity bytes of nodes instead of 4 KiB.
+     *  * mmap(MAP_HUGETLB) first: needs pages reserved by vm.nr_hugepages
+     *  * else m_granularity aligned mmap + madvise(MADV_HUGEPAGE): THP in "madvise" or "always" mode
+     *  * else (THP disabled, not Linux) normal pages
+     * Chunks are page aligned, any align up to m_granularity is satisfied.
+     */
+    struct THugePages {
+        static constexpr size_t m_granularity = size_t(2) << 20;
+
+        static void* allocate(size_t size, size_t align);
+
+        static void deallocate(void* ptr, size_t size, size_t align) noexcept;
+
+    private:
+        static inline size_t round(size_t size) noexcept {
+            return (size + m_granularity - 1) / m_granularity * m_granularity;
+        }
+    };
+
+    //--------------------------------------------------------------//
+    inline void* THugePages::allocate(size_t size, size_t align) {
+        (void)align;
+        size = round(size);
+        TPageStats& stats = PageStats();
+
+#if LIN
+    #ifdef MAP_HUGETLB
+        void* const huge =
+            mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (MAP_FAILED != huge) {
+            stats.m_hugetlb_chunks.fetch_add(1, std::memory_order_relaxed);
+            return huge;
+        }
+    #endif
+
+        // over-reserve by one huge page to cut aligned range: THP maps only aligned 2 MiB ranges
+        char* const raw = static_cast<char*>(
+            mmap(nullptr, size + m_granularity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (MAP_FAILED == static_cast<void*>(raw))
+            throw std::bad_alloc();
+
+        char* const aligned = reinterpret_cast<char*>(round(reinterpret_cast<uintptr_t>(raw)));
+        if (aligned != raw)
+            munmap(raw, aligned - raw);
+        if (aligned + size != raw + size + m_granularity)
+            munmap(aligned + size, raw + m_granularity - aligned);
+
+    #ifdef MADV_HUGEPAGE
+        if (0 == madvise(aligned, size, MADV_HUGEPAGE)) {
+            stats.m_advised_chunks.fetch_add(1, std::memory_order_relaxed);
+            return aligned;
+        }
+    #endif
+
+        stats.m_fallback_chunks.fetch_add(1, std::memory_order_relaxed);
+        return aligned;
+#else
+        stats.m_fallback_chunks.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size, std::align_val_t(m_granularity));
+#endif
+    }
+
+    //--------------------------------------------------------------//
+    inline void THugePages::deallocate(void* ptr, size_t size, size_t align) noexcept {
+        (void)align;
+#if LIN
+        munmap(ptr, round(size));
+#else
+        (void)size;
+        ::operator delete(ptr, std::align_val_t(m_granularity));
+#endif
+    }
+
+#pragma endregion PageSource
+
+}  // namespace Relax
@@ -0,0 +1,320 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "arena.h"
+#include "node_pool.h"
+#include "queue/intrusive_queue.h"
+#include "test/test.h"
+
+namespace Test {
+    //////////////////////////////////////////////////////////////////
+    class TestObjectPool : public ::testing::Test {
+    public:
+        using value_t = uint64_t;
+
+        struct Message : Relax::TChainableBase<Message> {
+            Message(value_t value, uint32_t thread_id)
+              : m_value(value)
+              , m_thread_id(thread_id) { }
+
+            value_t m_value;
+            uint32_t m_thread_id;
+        };
+
+        TestObjectPool() { }
+
+        TestObjectPool(const TestObjectPool& other) = delete;
+        TestObjectPool(TestObjectPool&& other) noexcept = delete;
+        TestObjectPool& operator=(const TestObjectPool& other) = delete;
+        TestObjectPool& operator=(TestObjectPool&& other) noexcept = delete;
+
+        // producers create messages, consumers destroy them
+        void testCrossThread(uint64_t sample_size, uint32_t nproducers, uint32_t nconsumers);
+
+    public:
+        static constexpr uint32_t m_sample_size = 2000000;
+    };
+
+    //--------------------------------------------------------------//
+    void TestObjectPool::testCrossThread(uint64_t sample_size, uint32_t nproducers, uint32_t nconsumers) {
+        sample_size = sample_size - (sample_size % nproducers);
+        const uint64_t per_producer = sample_size / nproducers;
+
+        Relax::IntrusiveMutexFreeQueue<Message> queue;
+        std::atomic<uint64_t> npopped = 0;
+
+        auto run_result = RunThreads(nproducers + nconsumers,
+                                     [&](uint32_t thread_id, uint32_t nthreads) -> std::vector<value_t> {
+                                         (void)nthreads;
+                                         std::vector<value_t> values;
+
+                                         if (thread_id < nproducers) {
+                                             const uint64_t start = thread_id * per_producer;
+                                             for (uint64_t i = start; i < start + per_producer; ++i) {
+                                                 queue.push(Relax::ObjectPool<Message>::create(i, thread_id));
+                                             }
+
+                                             return values;
+                                         }
+
+                                         while (npopped.load(std::memory_order_relaxed) < sample_size) {
+                                             Message* const message = queue.pop();
+                                             if (nullptr == message) {
+                                                 std::this_thread::yield();
+                                                 continue;
+                                             }
+
+                                             npopped.fetch_add(1, std::memory_order_relaxed);
+                                             values.emplace_back(message->m_value);
+
+                                             // corrupted message: extra value fails the check
+                                             if (message->m_value / per_producer != message->m_thread_id)
+                                                 values.emplace_back(sample_size);
+
+                                             Relax::ObjectPool<Message>::destroy(message);
+                                         }
+
+                                         return values;
+                                     });
+
+        ASSERT_TRUE(queue.empty());
+
+        std::vector<value_t> all_values;
+        for (auto& thread_values : run_result.first) {
+            all_values.insert(all_values.end(), thread_values.begin(), thread_values.end());
+        }
+
+        ASSERT_EQ(sample_size, all_values.size());
+        std::sort(all_values.begin(), all_values.end());
+        for (uint64_t i = 0; i < sample_size; ++i) {
+            ASSERT_EQ(i, all_values[i]);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestObjectPool, CreateDestroy) {
+        Message* const message = Relax::ObjectPool<Message>::create(7, 3);
+        ASSERT_EQ(7u, message->m_value);
+        ASSERT_EQ(3u, message->m_thread_id);
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(message) % alignof(Message));
+
+        // thread cache is LIFO
+        Relax::ObjectPool<Message>::destroy(message);
+        ASSERT_EQ(message, Relax::ObjectPool<Message>::create(8, 4));
+
+        Relax::ObjectPool<Message>::destroy(message);
+        Relax::ObjectPool<Message>::destroy(nullptr);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestObjectPool, CreateThrows) {
+        struct Throwing {
+            Throwing() { throw std::runtime_error("ctor"); }
+
+            uint64_t m_pad[5];
+        };
+
+        using pool_t = Relax::TNodePool<sizeof(Throwing), alignof(Throwing)>;
+
+        void* const memory = pool_t::allocate();
+        pool_t::deallocate(memory);
+
+        ASSERT_THROW(Relax::ObjectPool<Throwing>::create(), std::runtime_error);
+
+        // node returned to pool
+        ASSERT_EQ(memory, pool_t::allocate());
+        pool_t::deallocate(memory);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestObjectPool, SteadyStateNoSystemAllocs) {
+        constexpr size_t batch = 3 * Relax::TNodePool<sizeof(Message), alignof(Message)>::m_batch_size;
+        std::vector<Message*> messages(batch);
+
+        auto round = [&]() {
+            for (size_t i = 0; i < batch; ++i) {
+                messages[i] = Relax::ObjectPool<Message>::create(i, 0);
+            }
+            for (Message* message : messages) {
+                Relax::ObjectPool<Message>::destroy(message);
+            }
+        };
+
+        round();
+
+        const uint64_t start = Relax::NodePoolStats().m_system_allocs.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < 100; ++i) {
+            round();
+        }
+        ASSERT_EQ(start, Relax::NodePoolStats().m_system_allocs.load(std::memory_order_relaxed));
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestObjectPool, DestroyAfterExit) {
+        constexpr size_t batch = Relax::TNodePool<sizeof(Message), alignof(Message)>::m_batch_size;
+
+        // static objects are destroyed after thread-local cache of main thread
+        EXPECT_EXIT(
+            {
+                // constructed first, destroyed last: nodes freed after exit are handed out once
+                struct Checker {
+                    ~Checker() {
+                        std::vector<Message*> messages(4 * batch);
+                        for (size_t i = 0; i < 2 * batch; ++i) {
+                            messages[i] = Relax::ObjectPool<Message>::create(i, 0);
+                        }
+                        std::thread([&messages]() {
+                            for (size_t i = 2 * batch; i < 4 * batch; ++i) {
+                                messages[i] = Relax::ObjectPool<Message>::create(i, 1);
+                            }
+                        }).join();
+
+                        for (size_t i = 0; i < messages.size(); ++i) {
+                            if (i != messages[i]->m_value)
+                                std::_Exit(1);
+                        }
+
+                        std::sort(messages.begin(), messages.end());
+                        if (messages.end() != std::adjacent_find(messages.begin(), messages.end()))
+                            std::_Exit(1);
+                    }
+                };
+
+                struct Container {
+                    ~Container() {
+                        for (Message* message : m_messages) {
+                            Relax::ObjectPool<Message>::destroy(message);
+                        }
+                    }
+
+                    std::vector<Message*> m_messages;
+                };
+
+                static Checker checker;
+                static Container container;
+                for (size_t i = 0; i < 3 * batch; ++i) {
+                    container.m_messages.push_back(Relax::ObjectPool<Message>::create(i, 0));
+                }
+
+                std::exit(0);
+            },
+            ::testing::ExitedWithCode(0), "");
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestObjectPool, MTCrossThread_1_1) {
+        testCrossThread(m_sample_size, 1, 1);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestObjectPool, MTCrossThread_8_8) {
+        testCrossThread(m_sample_size, 8, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestObjectPool, MTCrossThread_32_4) {
+        testCrossThread(m_sample_size, 32, 4);
+    }
+
+
+    //////////////////////////////////////////////////////////////////
+    class TestArena : public ::testing::Test {
+    public:
+        TestArena() { }
+
+        TestArena(const TestArena& other) = delete;
+        TestArena(TestArena&& other) noexcept = delete;
+        TestArena& operator=(const TestArena& other) = delete;
+        TestArena& operator=(TestArena&& other) noexcept = delete;
+    };
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestArena, ReuseFreed) {
+        Relax::TArena<> arena;
+
+        void* const first = arena.allocate(40);
+        void* const second = arena.allocate(48);
+        ASSERT_EQ(static_cast<char*>(first) + 48, second);
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(second) % Relax::TArena<>::m_granularity);
+
+        // free list of size class is LIFO, other classes are not affected
+        arena.deallocate(first, 40);
+        ASSERT_NE(first, arena.allocate(64));
+        ASSERT_EQ(first, arena.allocate(33));
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestArena, ChunksAndRelease) {
+        const Relax::TArenaStats& stats = Relax::ArenaStats();
+        const uint64_t nallocs = stats.m_system_allocs.load();
+
+        Relax::TArena<> arena;
+        constexpr size_t nobjects = 100000;
+        for (size_t i = 0; i < nobjects; ++i) {
+            arena.allocate(32);
+        }
+
+        // chunks grow geometrically: few system allocations
+        const uint64_t nchunks = stats.m_system_allocs.load() - nallocs;
+        ASSERT_LT(0u, nchunks);
+        ASSERT_GE(32u, nchunks);
+        ASSERT_LE(nobjects * 32, arena.reserved());
+
+        arena.release();
+        ASSERT_EQ(0u, arena.reserved());
+
+        // arena is reusable after release
+        arena.allocate(32);
+        ASSERT_EQ(Relax::TArena<>::m_min_chunk, arena.reserved());
+    }
+
+    //--------------------------------------------------------------//
+    // chunk is whole huge page from any of MAP_HUGETLB, THP or fallback path
+    TEST_F(TestArena, HugePages) {
+        const Relax::TPageStats& stats = Relax::PageStats();
+        auto nchunks = [&stats]() {
+            return stats.m_hugetlb_chunks.load() + stats.m_advised_chunks.load() + stats.m_fallback_chunks.load();
+        };
+        const uint64_t start = nchunks();
+
+        Relax::TArena<Relax::THugePages> arena;
+        char* const first = static_cast<char*>(arena.allocate(64));
+        ASSERT_EQ(Relax::THugePages::m_granularity, arena.reserved());
+        ASSERT_EQ(start + 1, nchunks());
+
+        // the whole chunk is used before the next one
+        const size_t nobjects = Relax::THugePages::m_granularity / 64 - 1;
+        for (size_t i = 1; i < nobjects; ++i) {
+            ASSERT_EQ(first + i * 64, arena.allocate(64));
+        }
+        ASSERT_EQ(start + 1, nchunks());
+
+        arena.allocate(64);
+        ASSERT_EQ(2 * Relax::THugePages::m_granularity, arena.reserved());
+
+        arena.release();
+        ASSERT_EQ(0u, arena.reserved());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestArena, AllocatorRebindSharesArena) {
+        Relax::ArenaAllocator<uint64_t> alloc;
+        Relax::ArenaAllocator<uint32_t> rebound(alloc);
+        Relax::ArenaAllocator<uint64_t> other;
+
+        ASSERT_TRUE(alloc == rebound);
+        ASSERT_FALSE(alloc == other);
+
+        // the same size class
+        uint64_t* const value = alloc.allocate(1);
+        alloc.deallocate(value, 1);
+        ASSERT_EQ(reinterpret_cast<uint32_t*>(value), rebound.allocate(1));
+
+        // arrays are not served by arena
+        uint64_t* const array = alloc.allocate(4);
+        alloc.deallocate(array, 4);
+    }
+
+}  // namespace Test
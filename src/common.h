@@ -34,6 +34,20 @@ namespace Relax {
         T* m_next = nullptr;
     };
 
+    template<typename T>
+    concept SharedLockable = requires(T lock) {
+        lock.lock_shared();
+        lock.unlock_shared();
+    };
+
+    // sequence lock: readers validate version instead of locking (see TSeqLock)
+    template<typename T>
+    concept OptimisticLockable = requires(T lock) { lock.read_retry(lock.read_begin()); };
+
+    // allocator keeps memory of freed nodes readable while container is alive (ArenaAllocator, NodePoolAllocator)
+    template<class Alloc>
+    constexpr bool IsTypeStable = requires { requires Alloc::is_type_stable::value; };
+
     template<typename T>
     concept Woody = requires(T value) {
         value.m_parent = &value;
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <mutex>
+
+#include "test/test.h"
+#include "work_stealing_deque.h"
+
+namespace Test {
+    //////////////////////////////////////////////////////////////////
+    template<class T>
+    class SillyMutexDeque {
+    public:
+        typedef T value_type;
+
+        void push(T value) {
+            std::unique_lock<std::mutex> g(m_mutex);
+            m_deque.push_back(value);
+        }
+
+        bool pop(T& ref) {
+            std::unique_lock<std::mutex> g(m_mutex);
+            if (m_deque.empty())
+                return false;
+
+            ref = m_deque.back();
+            m_deque.pop_back();
+            return true;
+        }
+
+        bool steal(T& ref) {
+            std::unique_lock<std::mutex> g(m_mutex);
+            if (m_deque.empty())
+                return false;
+
+            ref = m_deque.front();
+            m_deque.pop_front();
+            return true;
+        }
+
+    private:
+        std::deque<T> m_deque;
+
+        std::mutex m_mutex;
+    };
+
+    //////////////////////////////////////////////////////////////////
+    class BenchWorkStealingDeque : public ::testing::Test {
+    public:
+        using value_t = uint64_t;
+
+        using deque_t = Relax::WorkStealingDeque<value_t>;
+
+        // deque and count of taken values shared by owner and thieves
+        template<class T>
+        struct TShared {
+            T m_deque;
+
+            alignas(CACHELINE_SIZE) std::atomic<uint64_t> m_ntaken = 0;
+        };
+
+        BenchWorkStealingDeque() { }
+
+        BenchWorkStealingDeque(const BenchWorkStealingDeque& other) = delete;
+        BenchWorkStealingDeque(BenchWorkStealingDeque&& other) noexcept = delete;
+        BenchWorkStealingDeque& operator=(const BenchWorkStealingDeque& other) = delete;
+        BenchWorkStealingDeque& operator=(BenchWorkStealingDeque&& other) noexcept = delete;
+
+        // thread 0 - owner: pushes batches of batch_size values and pops half of each, the rest is stolen
+        template<class T>
+        static std::pair<Duration, Duration> benchSteal(uint64_t sample_size,
+                                                        uint32_t nthieves,
+                                                        uint32_t batch_size,
+                                                        uint32_t niterations);
+
+        static void report(std::pair<Duration, Duration> lfstat, std::pair<Duration, Duration> std_stat);
+
+    public:
+        static constexpr uint32_t m_sample_size = 2000000;
+
+        static constexpr uint32_t m_nsamples = 5;
+
+        static constexpr uint32_t m_batch_size = 64;
+
+        static constexpr std::array<uint32_t, 4> m_nthief_modes = {2, 8, 32, 1024};
+    };
+
+    //--------------------------------------------------------------//
+    template<class T>
+    std::pair<Duration, Duration> BenchWorkStealingDeque::benchSteal(uint64_t sample_size,
+                                                                     uint32_t nthieves,
+                                                                     uint32_t batch_size,
+                                                                     uint32_t niterations) {
+        return BenchThreads<TShared<T>>(
+            nthieves + 1,
+            niterations,
+            [](uint32_t thread_id, uint32_t nthreads, TShared<T>& shared, uint64_t sample_size, uint32_t batch_size)
+                -> int {
+                (void)nthreads;
+                value_t value;
+
+                if (0 == thread_id) {
+                    uint64_t ntaken = 0;
+                    for (uint64_t i = 0; i < sample_size; i += batch_size) {
+                        for (uint32_t j = 0; j < batch_size; ++j) {
+                            shared.m_deque.push(i + j);
+                        }
+                        for (uint32_t j = 0; j < batch_size / 2; ++j) {
+                            ntaken += shared.m_deque.pop(value);
+                        }
+                    }
+
+                    while (shared.m_deque.pop(value)) {
+                        ++ntaken;
+                    }
+
+                    shared.m_ntaken.fetch_add(ntaken, std::memory_order_relaxed);
+                    return 0;
+                }
+
+                while (shared.m_ntaken.load(std::memory_order_relaxed) < sample_size) {
+                    if (shared.m_deque.steal(value))
+                        shared.m_ntaken.fetch_add(1, std::memory_order_relaxed);
+                    else
+                        std::this_thread::yield();
+                }
+
+                return 0;
+            },
+            sample_size,
+            batch_size);
+    }
+
+    //--------------------------------------------------------------//
+    void BenchWorkStealingDeque::report(std::pair<Duration, Duration> lfstat,
+                                        std::pair<Duration, Duration> std_stat) {
+        std::cout << std::fixed << std::setprecision(2) << std::setw(6);
+        const auto width = std::setw(15);
+
+        const double lf_time_μs = (double)lfstat.first.Microseconds();
+        const double std_time_μs = (double)std_stat.first.Microseconds();
+        const double std_diff = ((std_time_μs / lf_time_μs) - 1) * 100;
+
+        std::cout << "WS    time: " << width << lfstat.first.StrMilli() << "   dev: " << width
+                  << lfstat.second.StrMilli() << std::endl;
+        std::cout << "Mutex time: " << width << std_stat.first.StrMilli() << "   dev: " << width
+                  << std_stat.second.StrMilli() << width << " rel imp: " << (std_diff > 0 ? '+' : ' ')
+                  << std::setprecision(2) << std_diff << "%" << std::endl;
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(BenchWorkStealingDeque, owner_only) {
+        auto lfstat = benchSteal<deque_t>(m_sample_size, 0, m_batch_size, m_nsamples);
+        auto std_stat = benchSteal<SillyMutexDeque<value_t>>(m_sample_size, 0, m_batch_size, m_nsamples);
+
+        report(lfstat, std_stat);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchWorkStealingDeque, thief_1) {
+        auto lfstat = benchSteal<deque_t>(m_sample_size, 1, m_batch_size, m_nsamples);
+        auto std_stat = benchSteal<SillyMutexDeque<value_t>>(m_sample_size, 1, m_batch_size, m_nsamples);
+
+        report(lfstat, std_stat);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchWorkStealingDeque, thieves_n) {
+        for (uint32_t nthieves : m_nthief_modes) {
+            std::cout << "NThieves: " << std::setw(8) << nthieves << std::endl;
+
+            auto lfstat = benchSteal<deque_t>(m_sample_size, nthieves, m_batch_size, m_nsamples);
+            auto std_stat = benchSteal<SillyMutexDeque<value_t>>(m_sample_size, nthieves, m_batch_size, m_nsamples);
+
+            report(lfstat, std_stat);
+        }
+    }
+
+}  // namespace Test
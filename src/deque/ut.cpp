@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "test/test.h"
+#include "work_stealing_deque.h"
+
+namespace Test {
+    //////////////////////////////////////////////////////////////////
+    class TestWorkStealingDeque : public ::testing::Test {
+    public:
+        using value_t = uint64_t;
+
+        TestWorkStealingDeque() { }
+
+        TestWorkStealingDeque(const TestWorkStealingDeque& other) = delete;
+        TestWorkStealingDeque(TestWorkStealingDeque&& other) noexcept = delete;
+        TestWorkStealingDeque& operator=(const TestWorkStealingDeque& other) = delete;
+        TestWorkStealingDeque& operator=(TestWorkStealingDeque&& other) noexcept = delete;
+
+        // thread 0 - owner: pushes values, pops every pop_period-th push; other threads steal
+        template<size_t InitialCapacity>
+        void testOwnerThieves(uint64_t sample_size, uint32_t nthieves, uint32_t pop_period);
+
+    public:
+        static constexpr uint32_t m_sample_size = 2000000;
+    };
+
+    //--------------------------------------------------------------//
+    template<size_t InitialCapacity>
+    void TestWorkStealingDeque::testOwnerThieves(uint64_t sample_size, uint32_t nthieves, uint32_t pop_period) {
+        Relax::WorkStealingDeque<value_t, InitialCapacity> deque;
+        std::atomic<uint64_t> ntaken = 0;
+
+        auto run_result = RunThreads(nthieves + 1, [&](uint32_t thread_id, uint32_t nthreads) {
+            (void)nthreads;
+            std::vector<value_t> values;
+            value_t value;
+
+            if (0 == thread_id) {
+                for (uint64_t i = 0; i < sample_size; ++i) {
+                    deque.push(i);
+                    if (0 == i % pop_period && deque.pop(value)) {
+                        ntaken.fetch_add(1, std::memory_order_relaxed);
+                        values.emplace_back(value);
+                    }
+                }
+
+                // owner drains what is left
+                while (ntaken.load(std::memory_order_relaxed) < sample_size) {
+                    if (deque.pop(value)) {
+                        ntaken.fetch_add(1, std::memory_order_relaxed);
+                        values.emplace_back(value);
+                    }
+                }
+
+                return values;
+            }
+
+            while (ntaken.load(std::memory_order_relaxed) < sample_size) {
+                if (!deque.steal(value)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                ntaken.fetch_add(1, std::memory_order_relaxed);
+                values.emplace_back(value);
+            }
+
+            return values;
+        });
+
+        ASSERT_TRUE(deque.empty());
+
+        std::vector<value_t> all_values;
+        for (auto& thread_values : run_result.first) {
+            all_values.insert(all_values.end(), thread_values.begin(), thread_values.end());
+        }
+
+        ASSERT_EQ(sample_size, all_values.size());
+        std::sort(all_values.begin(), all_values.end());
+        for (uint64_t i = 0; i < sample_size; ++i) {
+            ASSERT_EQ(i, all_values[i]);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestWorkStealingDeque, PushPopSteal) {
+        Relax::WorkStealingDeque<value_t, 4> deque;
+        value_t value;
+
+        ASSERT_TRUE(deque.empty());
+        ASSERT_FALSE(deque.pop(value));
+        ASSERT_FALSE(deque.steal(value));
+
+        // grows 4 -> 8 -> 16
+        for (value_t i = 0; i < 10; ++i) {
+            deque.push(i);
+        }
+        ASSERT_EQ(10u, deque.size());
+        ASSERT_EQ(16u, deque.capacity());
+
+        // owner - LIFO, thief - FIFO
+        ASSERT_TRUE(deque.pop(value));
+        ASSERT_EQ(9u, value);
+        ASSERT_TRUE(deque.steal(value));
+        ASSERT_EQ(0u, value);
+
+        for (value_t i = 1; i < 9; ++i) {
+            ASSERT_TRUE(deque.steal(value));
+            ASSERT_EQ(i, value);
+        }
+
+        ASSERT_TRUE(deque.empty());
+        ASSERT_FALSE(deque.pop(value));
+        ASSERT_FALSE(deque.steal(value));
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestWorkStealingDeque, Pointers) {
+        std::vector<value_t> values(3);
+        Relax::WorkStealingDeque<value_t*> deque;
+        value_t* ptr;
+
+        for (value_t& value : values) {
+            deque.push(&value);
+        }
+
+        ASSERT_TRUE(deque.pop(ptr));
+        ASSERT_EQ(&values[2], ptr);
+        ASSERT_TRUE(deque.steal(ptr));
+        ASSERT_EQ(&values[0], ptr);
+        ASSERT_EQ(1u, deque.size());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestWorkStealingDeque, MTOwnerThief_1) {
+        testOwnerThieves<1024>(m_sample_size, 1, 2);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestWorkStealingDeque, MTOwnerThieves_8) {
+        testOwnerThieves<1024>(m_sample_size, 8, 2);
+    }
+
+    //--------------------------------------------------------------//
+    // array grows while thieves read it
+    TEST_F(TestWorkStealingDeque, MTOwnerThievesGrow_8) {
+        testOwnerThieves<2>(m_sample_size, 8, 1000);
+    }
+
+    //--------------------------------------------------------------//
+    // deque is mostly of 0-1 values: owner's pop races with thieves for the last one
+    TEST_F(TestWorkStealingDeque, MTOwnerThievesLast_32) {
+        testOwnerThieves<1024>(m_sample_size, 32, 1);
+    }
+
+}  // namespace Test
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+#include "common.h"
+#include "sync/atomic.h"
+#include "types.h"
+
+namespace Relax {
+
+#pragma region WorkStealingDeque
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Chase-Lev work-stealing deque.
+     *  * Owner thread pushes and pops at bottom: no RMW operations, pop takes CAS only for the last value
+     *  * Any thread steals from top by single CAS
+     *  * Growable circular array: owner doubles it when full, old arrays are freed by destructor
+     *    (thieves may still read them)
+     *  * Value (T) - pointer or integer: thieves read it before CAS decides who owns it
+     */
+    template<class T, size_t InitialCapacity = 1024>
+    class WorkStealingDeque {
+        static_assert(0 < InitialCapacity && 0 == (InitialCapacity & (InitialCapacity - 1)),
+                      "InitialCapacity must be power of 2");
+        static_assert(std::is_scalar_v<T>, "values are read racily: pointer or integer only");
+
+        struct Array {
+            explicit Array(size_t capacity);
+
+            inline T* cell(int64_t index) noexcept { return &m_cells[index & m_mask]; }
+
+        public:
+            const int64_t m_mask;
+
+            const std::unique_ptr<T[]> m_cells;
+
+            // retired smaller array
+            Array* m_prev = nullptr;
+        };
+
+    public:
+        typedef T value_type;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef size_t size_type;
+
+    public:
+        WorkStealingDeque();
+        ~WorkStealingDeque();
+
+        WorkStealingDeque(const WorkStealingDeque& other) = delete;
+        WorkStealingDeque(WorkStealingDeque&& other) noexcept = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque& other) = delete;
+        WorkStealingDeque& operator=(WorkStealingDeque&& other) noexcept = delete;
+
+        bool empty() const noexcept;
+
+        size_type size() const noexcept;
+
+        size_type capacity() const noexcept;
+
+        // owner side
+
+        void push(value_type value);
+
+        // LIFO: the last pushed value
+        bool pop(value_type& ref) noexcept;
+
+        // any thread
+
+        // FIFO: the oldest value. false if empty or value is taken by concurrent pop/steal
+        bool steal(value_type& ref) noexcept;
+
+    private:
+        // owner: copies [top, bottom) to twice larger array
+        Array* grow(Array* array, int64_t top, int64_t bottom);
+
+    private:
+        // thieves' line
+        alignas(CACHELINE_SIZE) int64_t m_top;
+
+        // owner's line
+        alignas(CACHELINE_SIZE) int64_t m_bottom;
+
+        Array* m_array;
+    };
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    WorkStealingDeque<T, C>::Array::Array(size_t capacity)
+      : m_mask(capacity - 1)
+      , m_cells(new T[capacity]) { }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    WorkStealingDeque<T, C>::WorkStealingDeque()
+      : m_top(0)
+      , m_bottom(0)
+      , m_array(new Array(C)) { }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    WorkStealingDeque<T, C>::~WorkStealingDeque() {
+        Array* array = m_array;
+        while (nullptr != array) {
+            Array* const prev = array->m_prev;
+            delete array;
+            array = prev;
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline bool WorkStealingDeque<T, C>::empty() const noexcept {
+        return 0 == size();
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline typename WorkStealingDeque<T, C>::size_type WorkStealingDeque<T, C>::size() const noexcept {
+        const int64_t top = NAtomic::load(&m_top, std::memory_order_acquire);
+        const int64_t bottom = NAtomic::load(&m_bottom, std::memory_order_acquire);
+
+        // bottom is decremented by pop before it checks top
+        return (bottom > top) ? bottom - top : 0;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline typename WorkStealingDeque<T, C>::size_type WorkStealingDeque<T, C>::capacity() const noexcept {
+        return NAtomic::load(&m_array, std::memory_order_acquire)->m_mask + 1;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline void WorkStealingDeque<T, C>::push(value_type value) {
+        // bottom and array are written only by owner
+        const int64_t bottom = m_bottom;
+        const int64_t top = NAtomic::load(&m_top, std::memory_order_acquire);
+        Array* array = m_array;
+
+        if (bottom - top > array->m_mask)
+            array = grow(array, top, bottom);
+
+        NAtomic::store(array->cell(bottom), value, std::memory_order_relaxed);
+
+        // value is visible to thief which sees new bottom
+        NAtomic::store(&m_bottom, bottom + 1, std::memory_order_release);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline bool WorkStealingDeque<T, C>::pop(value_type& ref) noexcept {
+        const int64_t bottom = m_bottom - 1;
+        Array* const array = m_array;
+
+        // all stores of bottom are release: thief synchronizes with pushes by any of them
+        NAtomic::store(&m_bottom, bottom, std::memory_order_release);
+
+        // store of bottom before load of top: thief and owner can't both miss each other
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = NAtomic::load(&m_top, std::memory_order_relaxed);
+
+        if (top > bottom) {
+            // empty
+            NAtomic::store(&m_bottom, bottom + 1, std::memory_order_release);
+            return false;
+        }
+
+        ref = NAtomic::load(array->cell(bottom), std::memory_order_relaxed);
+        if (top < bottom)
+            return true;
+
+        // the last value: race with thieves
+        const bool won = NAtomic::compare_exchange_strong(&m_top,
+                                                          &top,
+                                                          top + 1,
+                                                          std::memory_order_seq_cst,
+                                                          std::memory_order_relaxed);
+        NAtomic::store(&m_bottom, bottom + 1, std::memory_order_release);
+        return won;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    bool WorkStealingDeque<T, C>::steal(value_type& ref) noexcept {
+        int64_t top = NAtomic::load(&m_top, std::memory_order_acquire);
+
+        // load of top before load of bottom, pairs with fence of pop
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = NAtomic::load(&m_bottom, std::memory_order_acquire);
+
+        if (top >= bottom)
+            return false;
+
+        // array may be replaced by grow after load: old array still holds values of [top, bottom)
+        Array* const array = NAtomic::load(&m_array, std::memory_order_acquire);
+        const value_type value = NAtomic::load(array->cell(top), std::memory_order_relaxed);
+
+        if (!NAtomic::compare_exchange_strong(&m_top,
+                                              &top,
+                                              top + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed))
+            return false;
+
+        ref = value;
+        return true;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    typename WorkStealingDeque<T, C>::Array* WorkStealingDeque<T, C>::grow(Array* array,
+                                                                          int64_t top,
+                                                                          int64_t bottom) {
+        Array* const larger = new Array(2 * (array->m_mask + 1));
+        for (int64_t i = top; i < bottom; ++i) {
+            const value_type value = NAtomic::load(array->cell(i), std::memory_order_relaxed);
+            NAtomic::store(larger->cell(i), value, std::memory_order_relaxed);
+        }
+
+        larger->m_prev = array;
+        NAtomic::store(&m_array, larger, std::memory_order_release);
+
+        return larger;
+    }
+
+    //--------------------------------------------------------------//
+
+#pragma endregion WorkStealingDeque
+
+}  // namespace Relax
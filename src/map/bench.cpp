@@ -1,6 +1,11 @@
+#include <numeric>
+#include <random>
+#include <shared_mutex>
 #include <unordered_map>
 
 #include "map.h"
+#include "pool/thread_pool.h"
+#include "sharded_map.h"
 #include "test/test.h"
 #include "testgen.h"
 #include "utils/utils.h"
@@ -9,21 +14,30 @@
 #define MAX_KEY 64
 
 namespace Test {
+    //--------------------------------------------------------------//
+    template<class K, class V>
+    using TSTDMap = std::map<K, V, std::less<K>, TCountingAllocator<std::pair<const K, V>>>;
+
     //////////////////////////////////////////////////////////////////
     template<class K, class V>
-    class TMTSTDMap : public std::map<K, V> {
+    class TMTSTDMap : public TSTDMap<K, V> {
     public:
         typedef V value_type;
 
         template<typename... Args>
-        std::pair<typename std::map<K, V>::iterator, bool> emplace(const K& key, Args&&... args) {
+        std::pair<typename TSTDMap<K, V>::iterator, bool> emplace(const K& key, Args&&... args) {
             std::lock_guard<decltype(m_lock)> g(m_lock);
-            return std::map<K, V>::emplace(key, std::forward<Args&&>(args)...);
+            return TSTDMap<K, V>::emplace(key, std::forward<Args&&>(args)...);
         }
 
         size_t erase(K key) {
             std::lock_guard<decltype(m_lock)> g(m_lock);
-            return std::map<K, V>::erase(key);
+            return TSTDMap<K, V>::erase(key);
+        }
+
+        bool contains(const K& key) {
+            std::lock_guard<decltype(m_lock)> g(m_lock);
+            return TSTDMap<K, V>::contains(key);
         }
 
     private:
@@ -75,6 +89,84 @@ namespace Test {
                                });
     }
 
+    //--------------------------------------------------------------//
+    // system allocations made by maps of type T: arena chunks or counted node allocations
+    template<class T>
+    uint64_t NAllocs() {
+        if constexpr (requires { T::allocator_type::nallocs(); })
+            return T::allocator_type::nallocs();
+        else
+            return Relax::ArenaStats().m_system_allocs.load(std::memory_order_relaxed);
+    }
+
+    //--------------------------------------------------------------//
+    // untimed single pass: system allocations per command and RSS growth of map filled by commands
+    template<class T>
+    std::pair<double, int64_t> MeasureMapMemory(const std::vector<TestCommand>& commands,
+                                                std::vector<typename T::mapped_type>& values) {
+        TrimHeap();
+        const uint64_t start_allocs = NAllocs<T>();
+        const uint64_t start_rss = ResidentKiB();
+
+        auto map = std::make_unique<T>();
+        for (const TestCommand& cmd : commands) {
+            if (cmd.m_is_add)
+                map->emplace(cmd.m_key, values[cmd.m_key]);
+            else
+                map->erase(cmd.m_key);
+        }
+
+        const int64_t rss = (int64_t)ResidentKiB() - (int64_t)start_rss;
+        return {(double)(NAllocs<T>() - start_allocs) / commands.size(), rss};
+    }
+
+    //--------------------------------------------------------------//
+    /*
+     * Read-mostly load: map is prefilled by even keys, each thread makes one write (emplace or erase of odd key)
+     * per read_ratio operations, the rest are lookups of random keys
+     */
+    template<class T>
+    std::pair<Duration, Duration> BenchReadMostlyTemplate(const std::vector<typename T::key_type>& keys,
+                                                          uint32_t nthreads,
+                                                          uint32_t niterations,
+                                                          uint32_t read_ratio) {
+        std::vector<Duration> samples;
+        for (uint32_t iter = 0; iter < niterations; ++iter) {
+            T map;
+            for (auto key : keys) {
+                if (0 == key % 2)
+                    map.emplace(key, key);
+            }
+
+            auto worker = [&keys, &map, read_ratio](uint32_t thread_id, uint32_t nthreads) -> uint64_t {
+                const size_t per_thread = keys.size() / nthreads;
+                const auto* start_key = &keys[thread_id * per_thread];
+
+                uint64_t nfound = 0;
+                for (size_t i = 0; i < per_thread; ++i) {
+                    const auto key = start_key[i];
+                    if (0 != i % read_ratio)
+                        nfound += map.contains(key);
+                    else if (0 == (i / read_ratio) % 2)
+                        map.emplace(key | 1, key);
+                    else
+                        map.erase(key | 1);
+                }
+
+                return nfound;
+            };
+
+            samples.emplace_back(RunThreads(nthreads, worker).second);
+        }
+
+        uint64_t e = 0;
+        for (const auto& sample : samples) {
+            e += sample.Microseconds();
+        }
+
+        return {Duration(e / samples.size()), (1 < niterations) ? Deviation(samples) : Duration()};
+    }
+
     //////////////////////////////////////////////////////////////////
     class BenchMap : public ::testing::Test {
     public:
@@ -83,6 +175,9 @@ namespace Test {
         using key_t = uint32_t;
         using value_t = TestValue*;
 
+        template<class Lock>
+        using sharded_map_t = Relax::ShardedMap<key_t, value_t, Lock>;
+
     public:
         BenchMap() { }
 
@@ -91,34 +186,119 @@ namespace Test {
         BenchMap& operator=(const BenchMap& other) = delete;
         BenchMap& operator=(BenchMap&& other) noexcept = delete;
 
+        struct TMapStat {
+            std::pair<Duration, Duration> m_time;
+
+            // system allocations per command
+            double m_allocs;
+
+            // RSS growth of filled map
+            int64_t m_rss_kib;
+        };
+
+        template<class T>
+        static TMapStat bench(const std::vector<TestCommand>& commands,
+                              std::vector<value_t>& values,
+                              uint32_t nthreads,
+                              uint32_t niterations);
+
         void report(uint64_t sample_size,
                     Duration gen_time,
-                    std::pair<Duration, Duration> intrusive_map_stat,
-                    std::pair<Duration, Duration> std_map_stat);
+                    const TMapStat& intrusive_map_stat,
+                    const TMapStat& new_map_stat,
+                    const TMapStat& std_map_stat,
+                    const TMapStat& sharded_map_stat);
 
         void run(TestGeneratorBucketed generator, uint32_t sample_size, uint32_t nthreads, uint32_t niterations);
+
+        // lookups under shared lock vs exclusive lock vs optimistic (seqlock) vs std::map under mutex
+        void runReadMostly(uint32_t sample_size, uint32_t nthreads, uint32_t niterations);
+
+        // scans of key range [lo, lo + width) from random lo: visitor and iterators of Map vs std::map
+        void runRangeScan(uint32_t sample_size, uint32_t nscans, uint32_t width);
+
+        // startup load of sorted records: insert per record vs linear build vs parallel build vs std::map
+        void runBuild(uint32_t sample_size, uint32_t niterations);
+
+        // lookups in tree of nodes cut from arena of Pages chunks
+        using lookup_node_t = Relax::Map<uint64_t, uint64_t>::Node;
+
+        struct TLookupStat {
+            Duration m_time;
+
+            // -1: hardware counter is not available
+            int64_t m_tlb_misses;
+
+            // memory of process backed by transparent huge pages while tree is alive
+            uint64_t m_huge_kib;
+        };
+
+        template<class Pages>
+        static TLookupStat benchLookup(const std::vector<uint64_t>& keys, const std::vector<uint64_t>& lookups);
+
+        static void reportLookup(const TLookupStat& stat, uint64_t nlookups, const char* name);
+
+    public:
+        // lookups per write of read-mostly bench: 95% reads
+        static constexpr uint32_t m_read_ratio = 20;
+
+        // ~480 MiB of nodes: far beyond reach of 4 KiB page TLB
+        static constexpr uint64_t m_lookup_tree_size = 10000000;
     };
 
+    //--------------------------------------------------------------//
+    template<class T>
+    BenchMap::TMapStat BenchMap::bench(const std::vector<TestCommand>& commands,
+                                       std::vector<value_t>& values,
+                                       uint32_t nthreads,
+                                       uint32_t niterations) {
+        const auto time = BenchMapTemplate<T>(commands, values, nthreads, niterations);
+        const auto [allocs, rss_kib] = MeasureMapMemory<T>(commands, values);
+        return {time, allocs, rss_kib};
+    }
+
     //--------------------------------------------------------------//
     void BenchMap::report(uint64_t sample_size,
                           Duration gen_time,
-                          std::pair<Duration, Duration> intrusive_map_stat,
-                          std::pair<Duration, Duration> std_map_stat) {
+                          const TMapStat& intrusive_map_stat,
+                          const TMapStat& new_map_stat,
+                          const TMapStat& std_map_stat,
+                          const TMapStat& sharded_map_stat) {
         (void)sample_size;
         std::cout << std::fixed << std::setprecision(2) << std::setw(6);
         const auto width = std::setw(15);
 
         std::cout << "Gen time:      " << width << static_cast<double>(gen_time.Milliseconds()) << std::endl;
 
-        const double map_time = (double)intrusive_map_stat.first.Microseconds();
-        const double origin_time = (double)std_map_stat.first.Microseconds();
+        const double map_time = (double)intrusive_map_stat.m_time.first.Microseconds();
+        const double new_time = (double)new_map_stat.m_time.first.Microseconds();
+        const double origin_time = (double)std_map_stat.m_time.first.Microseconds();
+        const double new_diff = ((new_time / map_time) - 1) * 100;
         const double origin_diff = ((origin_time / map_time) - 1) * 100;
-
-        std::cout << "IntMap time:   " << width << intrusive_map_stat.first.Str() << "   dev: " << width
-                  << intrusive_map_stat.second.Str() << std::endl;
-        std::cout << "std::map time: " << width << std_map_stat.first.Str() << "   dev: " << width
-                  << std_map_stat.second.Str() << width << " rel imp: " << (origin_diff > 0 ? '+' : ' ')
+        const double sharded_time = (double)sharded_map_stat.m_time.first.Microseconds();
+        const double sharded_diff = ((sharded_time / map_time) - 1) * 100;
+
+        std::cout << "IntMap time:   " << width << intrusive_map_stat.m_time.first.Str() << "   dev: " << width
+                  << intrusive_map_stat.m_time.second.Str() << std::endl;
+        std::cout << "IntMap new:    " << width << new_map_stat.m_time.first.Str() << "   dev: " << width
+                  << new_map_stat.m_time.second.Str() << width << " rel imp: " << (new_diff > 0 ? '+' : ' ')
+                  << std::setprecision(2) << new_diff << "%" << std::endl;
+        std::cout << "std::map time: " << width << std_map_stat.m_time.first.Str() << "   dev: " << width
+                  << std_map_stat.m_time.second.Str() << width << " rel imp: " << (origin_diff > 0 ? '+' : ' ')
                   << std::setprecision(2) << origin_diff << "%" << std::endl;
+        std::cout << "Sharded time:  " << width << sharded_map_stat.m_time.first.Str() << "   dev: " << width
+                  << sharded_map_stat.m_time.second.Str() << width << " rel imp: " << (sharded_diff > 0 ? '+' : ' ')
+                  << std::setprecision(2) << sharded_diff << "%" << std::endl;
+
+        auto report_memory = [&width](const char* name, const TMapStat& stat) {
+            std::cout << name << " allocs/op: " << std::setprecision(4) << width << stat.m_allocs
+                      << "   RSS: " << width << stat.m_rss_kib << " KiB" << std::endl;
+        };
+
+        report_memory("IntMap    ", intrusive_map_stat);
+        report_memory("IntMap new", new_map_stat);
+        report_memory("std::map  ", std_map_stat);
+        report_memory("Sharded   ", sharded_map_stat);
 
 #if CHECK_UNO
         const double unordered_speed = (double)sample_size / unordered_time.Milliseconds();
@@ -145,14 +325,25 @@ namespace Test {
             gen_time += (Timestamp::Now() - start);
         }
 
+        using new_alloc_t = TCountingAllocator<value_t>;
+
         auto intrusive_map_stat =
+            (1 == nthreads) ? bench<map_t<key_t, value_t>>(sample, values, nthreads, niterations)
+                            : bench<map_t<key_t, value_t, std::mutex>>(sample, values, nthreads, niterations);
+
+        auto new_map_stat =
             (1 == nthreads)
-                ? BenchMapTemplate<map_t<key_t, value_t>>(sample, values, nthreads, niterations)
-                : BenchMapTemplate<map_t<key_t, value_t, std::mutex>>(sample, values, nthreads, niterations);
+                ? bench<map_t<key_t, value_t, Relax::FakeLock, new_alloc_t>>(sample, values, nthreads, niterations)
+                : bench<map_t<key_t, value_t, std::mutex, new_alloc_t>>(sample, values, nthreads, niterations);
 
         auto std_map_stat =
-            (1 == nthreads) ? BenchMapTemplate<std::map<key_t, value_t>>(sample, values, nthreads, niterations)
-                            : BenchMapTemplate<TMTSTDMap<key_t, value_t>>(sample, values, nthreads, niterations);
+            (1 == nthreads) ? bench<TSTDMap<key_t, value_t>>(sample, values, nthreads, niterations)
+                            : bench<TMTSTDMap<key_t, value_t>>(sample, values, nthreads, niterations);
+
+        // writers of different shards do not contend
+        auto sharded_map_stat =
+            (1 == nthreads) ? bench<sharded_map_t<Relax::FakeLock>>(sample, values, nthreads, niterations)
+                            : bench<sharded_map_t<std::mutex>>(sample, values, nthreads, niterations);
 
 #if CHECK_UNO
         unordered_time +=
@@ -163,10 +354,232 @@ namespace Test {
 
         KillValues(values);
 
-        report(sample_size, gen_time, intrusive_map_stat, std_map_stat);
+        report(sample_size, gen_time, intrusive_map_stat, new_map_stat, std_map_stat, sharded_map_stat);
     }
 
     //--------------------------------------------------------------//
+    void BenchMap::runReadMostly(uint32_t sample_size, uint32_t nthreads, uint32_t niterations) {
+        std::vector<key_t> keys(sample_size);
+        std::mt19937 random(sample_size);
+        for (key_t& key : keys) {
+            key = random() % (2 * sample_size);
+        }
+
+        using shared_map_t = map_t<key_t, key_t, std::shared_mutex>;
+        using mutex_map_t = map_t<key_t, key_t, std::mutex>;
+        using seq_map_t = map_t<key_t, key_t, Relax::TSeqLock<>>;
+
+        const auto shared_time = BenchReadMostlyTemplate<shared_map_t>(keys, nthreads, niterations, m_read_ratio);
+        const auto mutex_time = BenchReadMostlyTemplate<mutex_map_t>(keys, nthreads, niterations, m_read_ratio);
+        const auto seq_time = BenchReadMostlyTemplate<seq_map_t>(keys, nthreads, niterations, m_read_ratio);
+        const auto std_time =
+            BenchReadMostlyTemplate<TMTSTDMap<key_t, key_t>>(keys, nthreads, niterations, m_read_ratio);
+
+        std::cout << std::fixed << std::setprecision(2);
+        const auto width = std::setw(15);
+
+        auto report_time = [&width, &shared_time](const char* name, const std::pair<Duration, Duration>& time) {
+            const double diff = ((double)time.first.Microseconds() / shared_time.first.Microseconds() - 1) * 100;
+            std::cout << name << " time: " << width << time.first.Str() << "   dev: " << width << time.second.Str()
+                      << width << " rel imp: " << (diff > 0 ? '+' : ' ') << diff << "%" << std::endl;
+        };
+
+        report_time("IntMap shared", shared_time);
+        report_time("IntMap mutex ", mutex_time);
+        report_time("IntMap seq   ", seq_time);
+        report_time("std::map     ", std_time);
+    }
+
+    //--------------------------------------------------------------//
+    void BenchMap::runRangeScan(uint32_t sample_size, uint32_t nscans, uint32_t width) {
+        // even keys: half of bounds are not present
+        std::vector<key_t> keys(sample_size);
+        for (key_t i = 0; i < sample_size; ++i) {
+            keys[i] = 2 * i;
+        }
+
+        std::mt19937 random(sample_size);
+        std::shuffle(keys.begin(), keys.end(), random);
+
+        map_t<key_t, key_t> map;
+        std::map<key_t, key_t> origin;
+        for (key_t key : keys) {
+            map.emplace(key, key);
+            origin.emplace(key, key);
+        }
+
+        std::vector<key_t> los(nscans);
+        for (key_t& lo : los) {
+            lo = random() % (2 * sample_size);
+        }
+
+        auto measure = [&los, width](auto&& scan) {
+            uint64_t sum = 0;
+            const Timestamp start = Timestamp::Now();
+            for (key_t lo : los) {
+                sum += scan(lo, lo + width);
+            }
+
+            return std::pair<Duration, uint64_t>(Timestamp::Now() - start, sum);
+        };
+
+        const auto visitor_stat = measure([&map](key_t lo, key_t hi) {
+            uint64_t sum = 0;
+            map.for_each_in_range(lo, hi, [&sum](const key_t&, const key_t& value) { sum += value; });
+            return sum;
+        });
+
+        const auto iterator_stat = measure([&map](key_t lo, key_t hi) {
+            uint64_t sum = 0;
+            for (auto it = map.lower_bound(lo); it != map.end() && (*it).first < hi; ++it) {
+                sum += (*it).second;
+            }
+            return sum;
+        });
+
+        const auto std_stat = measure([&origin](key_t lo, key_t hi) {
+            uint64_t sum = 0;
+            for (auto it = origin.lower_bound(lo); it != origin.end() && it->first < hi; ++it) {
+                sum += it->second;
+            }
+            return sum;
+        });
+
+        EXPECT_EQ(std_stat.second, visitor_stat.second);
+        EXPECT_EQ(std_stat.second, iterator_stat.second);
+
+        std::cout << std::fixed << std::setprecision(2);
+        const auto width_fmt = std::setw(15);
+
+        auto report_time = [&width_fmt, &std_stat, nscans](const char* name, Duration time) {
+            const double diff = ((double)std_stat.first.Microseconds() / time.Microseconds() - 1) * 100;
+            std::cout << name << " time: " << width_fmt << time.Str() << "   ns/scan: " << width_fmt
+                      << (double)time.Microseconds() * 1000 / nscans << width_fmt
+                      << " rel imp: " << (diff > 0 ? '+' : ' ') << diff << "%" << std::endl;
+        };
+
+        std::cout << "Width: " << width << std::endl;
+        report_time("IntMap visitor ", visitor_stat.first);
+        report_time("IntMap iterator", iterator_stat.first);
+        report_time("std::map       ", std_stat.first);
+    }
+
+    //--------------------------------------------------------------//
+    void BenchMap::runBuild(uint32_t sample_size, uint32_t niterations) {
+        std::vector<std::pair<key_t, key_t>> records(sample_size);
+        for (key_t i = 0; i < sample_size; ++i) {
+            records[i] = {2 * i, i};
+        }
+
+        Relax::ThreadPool pool;
+
+        // map is destroyed out of measured time
+        auto measure = [niterations](auto&& load) {
+            std::vector<Duration> samples;
+            for (uint32_t iter = 0; iter < niterations; ++iter) {
+                samples.emplace_back(load());
+            }
+
+            uint64_t e = 0;
+            for (const auto& sample : samples) {
+                e += sample.Microseconds();
+            }
+
+            return std::pair<Duration, Duration>(Duration(e / samples.size()),
+                                                 (1 < niterations) ? Deviation(samples) : Duration());
+        };
+
+        const auto insert_time = measure([&records] {
+            auto map = std::make_unique<map_t<key_t, key_t>>();
+            const Timestamp start = Timestamp::Now();
+            for (const auto& record : records) {
+                map->emplace(record.first, record.second);
+            }
+            return Timestamp::Now() - start;
+        });
+
+        const auto build_time = measure([&records] {
+            auto map = std::make_unique<map_t<key_t, key_t>>();
+            const Timestamp start = Timestamp::Now();
+            map->build_from_sorted(records.begin(), records.end());
+            return Timestamp::Now() - start;
+        });
+
+        const auto parallel_time = measure([&records, &pool] {
+            auto map = std::make_unique<map_t<key_t, key_t>>();
+            const Timestamp start = Timestamp::Now();
+            map->build_from_sorted(records.begin(), records.end(), pool);
+            return Timestamp::Now() - start;
+        });
+
+        // sorted range with end() hints: linear too
+        const auto std_time = measure([&records] {
+            const Timestamp start = Timestamp::Now();
+            auto map = std::make_unique<std::map<key_t, key_t>>(records.begin(), records.end());
+            return Timestamp::Now() - start;
+        });
+
+        std::cout << std::fixed << std::setprecision(2);
+        const auto width = std::setw(15);
+
+        auto report_time = [&width, &insert_time](const char* name, const std::pair<Duration, Duration>& time) {
+            const double diff = ((double)insert_time.first.Microseconds() / time.first.Microseconds() - 1) * 100;
+            std::cout << name << " time: " << width << time.first.Str() << "   dev: " << width << time.second.Str()
+                      << width << " rel imp: " << (diff > 0 ? '+' : ' ') << diff << "%" << std::endl;
+        };
+
+        std::cout << "Records: " << sample_size << ", pool threads: " << pool.size() << std::endl;
+        report_time("IntMap insert  ", insert_time);
+        report_time("IntMap build   ", build_time);
+        report_time("IntMap parallel", parallel_time);
+        report_time("std::map       ", std_time);
+    }
+
+    //--------------------------------------------------------------//
+    template<class Pages>
+    BenchMap::TLookupStat BenchMap::benchLookup(const std::vector<uint64_t>& keys,
+                                                const std::vector<uint64_t>& lookups) {
+        Relax::ArenaAllocator<lookup_node_t, Pages> alloc;
+        Relax::IntrusiveMap<lookup_node_t> tree;
+        for (uint64_t key : keys) {
+            tree.insert(new (alloc.allocate(1)) lookup_node_t(key, key));
+        }
+
+        TTLBMissCounter counter;
+        uint64_t sum = 0;
+
+        counter.start();
+        const Timestamp start = Timestamp::Now();
+        for (uint64_t key : lookups) {
+            sum += (*tree.find(key))->m_value;
+        }
+        const Duration time = Timestamp::Now() - start;
+        const int64_t misses = counter.stop();
+
+        EXPECT_EQ(lookups.size() * (lookups.size() - 1) / 2, sum);
+        const uint64_t huge_kib = AnonHugePagesKiB();
+
+        // nodes are trivially destructible: arena frees them at once
+        tree.clearWithDestruct([](lookup_node_t*) noexcept {});
+        alloc.release();
+
+        return {time, misses, huge_kib};
+    }
+
+    //--------------------------------------------------------------//
+    void BenchMap::reportLookup(const TLookupStat& stat, uint64_t nlookups, const char* name) {
+        std::cout << std::fixed << std::setprecision(2);
+        const auto width = std::setw(15);
+
+        std::cout << name << " time: " << width << stat.m_time.Str() << "   ns/lookup: " << width
+                  << (double)stat.m_time.Microseconds() * 1000 / nlookups << "   dTLB misses/lookup: " << width;
+        if (0 <= stat.m_tlb_misses)
+            std::cout << (double)stat.m_tlb_misses / nlookups;
+        else
+            std::cout << "n/a";
+
+        std::cout << "   AnonHugePages: " << width << stat.m_huge_kib << " KiB" << std::endl;
+    }
 
     //////////////////////////////////////////////////////////////////
     TEST_F(BenchMap, bench_add_small) {
@@ -243,6 +656,70 @@ namespace Test {
         run(AddTestGeneratorBucketed, sample_size, nthreads, niterations);
     }
 
+    //--------------------------------------------------------------//
+    // 95% lookups: readers of shared lock do not wait for each other, optimistic readers do not write
+    TEST_F(BenchMap, bench_read_mostly) {
+        constexpr uint32_t sample_size = 100000;
+        constexpr uint32_t nthreads = 1;
+        constexpr uint32_t niterations = 20;
+
+        runReadMostly(sample_size, nthreads, niterations);
+    }
+
+    TEST_F(BenchMap, bench_mt_read_mostly) {
+        constexpr uint32_t sample_size = 800000;
+        constexpr uint32_t nthreads = 8;
+        constexpr uint32_t niterations = 10;
+
+        runReadMostly(sample_size, nthreads, niterations);
+    }
+
+    //--------------------------------------------------------------//
+    // time-window scans: descent cost dominates narrow ranges, in-order walk - wide ones
+    TEST_F(BenchMap, bench_range_scan) {
+        constexpr uint32_t sample_size = 1000000;
+
+        runRangeScan(sample_size, 200000, 16);
+        runRangeScan(sample_size, 20000, 256);
+        runRangeScan(sample_size, 2000, 4096);
+    }
+
+    //--------------------------------------------------------------//
+    // startup load of pre-sorted records
+    TEST_F(BenchMap, bench_build_from_sorted) {
+        constexpr uint32_t sample_size = 4000000;
+        constexpr uint32_t niterations = 5;
+
+        runBuild(sample_size, niterations);
+    }
+
+    //--------------------------------------------------------------//
+    // random lookups in 10M-node tree: TLB reach of 4 KiB vs 2 MiB pages
+    TEST_F(BenchMap, bench_lookup_huge_pages) {
+        std::vector<uint64_t> keys(m_lookup_tree_size);
+        std::iota(keys.begin(), keys.end(), 0);
+
+        std::mt19937_64 random(m_lookup_tree_size);
+        std::shuffle(keys.begin(), keys.end(), random);
+
+        // tree neighbours are spread over the arena by random insertion order
+        std::vector<uint64_t> lookups = keys;
+        std::shuffle(lookups.begin(), lookups.end(), random);
+
+        const TLookupStat heap_stat = benchLookup<Relax::THeapPages>(keys, lookups);
+        const TLookupStat huge_stat = benchLookup<Relax::THugePages>(keys, lookups);
+
+        const Relax::TPageStats& stats = Relax::PageStats();
+        std::cout << "Huge chunks: hugetlb " << stats.m_hugetlb_chunks.load() << ", THP advised "
+                  << stats.m_advised_chunks.load() << ", fallback " << stats.m_fallback_chunks.load() << std::endl;
+
+        reportLookup(heap_stat, lookups.size(), "4 KiB pages");
+        reportLookup(huge_stat, lookups.size(), "huge pages ");
+
+        const double diff = ((double)heap_stat.m_time.Microseconds() / huge_stat.m_time.Microseconds() - 1) * 100;
+        std::cout << "rel imp: " << (diff > 0 ? '+' : ' ') << std::setprecision(2) << diff << "%" << std::endl;
+    }
+
     //////////////////////////////////////////////////////////////////
 
 }  // namespace Test
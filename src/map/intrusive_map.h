@@ -1,9 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
 #include <queue>
+#include <vector>
 
 #include "common.h"
+#include "sync/atomic.h"
 #include "types.h"
 
 namespace Relax {
@@ -34,12 +38,44 @@ namespace Relax {
         IntrusiveMap& operator=(const IntrusiveMap& other) = delete;
         IntrusiveMap& operator=(IntrusiveMap&& other) noexcept = delete;
 
-        iterator find(const key_type& key) noexcept;
+        iterator find(const key_type& key) const noexcept;
+
+        /*
+         * find of optimistic reader racing with writers (seqlock): links are loaded atomically, keys may be torn.
+         * Result is valid only if no writer ran meanwhile. Walk is cut after m_max_depth steps (cycle seen in
+         * the middle of rotation): second - false.
+         * Node memory must stay readable after erase (type-stable), key_type - trivially copyable.
+         */
+        std::pair<iterator, bool> findOptimistic(const key_type& key) const noexcept;
+
+        // first node with key >= key
+        iterator lower_bound(const key_type& key) const noexcept;
+
+        // first node with key > key
+        iterator upper_bound(const key_type& key) const noexcept;
+
+        std::pair<iterator, iterator> equal_range(const key_type& key) const noexcept;
+
+        // f(node) for each node with key in [lo, hi), in order of keys
+        template<class Visitor>
+        void for_each_in_range(const key_type& lo, const key_type& hi, Visitor&& f) const;
 
         std::pair<iterator, bool> emplace(const key_type& key, pointer_type value);
 
         std::pair<iterator, bool> insert(pointer_type value) noexcept;
 
+        /*
+         * Links nodes of [first, last) (pointers, strictly increasing keys) into empty map in O(n):
+         * middle node of each range is root of its subtree, all levels but the last are complete,
+         * nodes of the last incomplete level are red
+         */
+        template<class RandomIt>
+        void build_from_sorted(RandomIt first, RandomIt last) noexcept;
+
+        // build_from_sorted with subtrees below m_build_split_depth linked by pool.parallel_for (ThreadPool)
+        template<class RandomIt, class Pool>
+        void build_from_sorted(RandomIt first, RandomIt last, Pool& pool);
+
         size_t erase(const key_type& key) noexcept;
 
         iterator erase(iterator iter) noexcept;
@@ -48,21 +84,29 @@ namespace Relax {
 
         void clearWithDestruct() noexcept;
 
+        // dispose(node) for each node, children before parents
+        template<class Disposer>
+        void clearWithDestruct(Disposer&& dispose) noexcept;
+
         size_t size() const noexcept;
 
     public:
-        class iterator : public std::iterator<std::input_iterator_tag, pointer_type> {
+        // owner's root is read by --end(): last node of the tree
+        class iterator : public std::iterator<std::bidirectional_iterator_tag, pointer_type> {
             friend class IntrusiveMap<V>;
 
-            iterator(pointer_type node)
-              : m_node(node) { }
+            iterator(const IntrusiveMap* owner, pointer_type node)
+              : m_owner(owner)
+              , m_node(node) { }
 
         public:
             iterator(const iterator& it)
-              : m_node(it.m_node) { }
+              : m_owner(it.m_owner)
+              , m_node(it.m_node) { }
             ~iterator() = default;
 
             iterator& operator=(const iterator& it) noexcept {
+                m_owner = it.m_owner;
                 m_node = it.m_node;
                 return *this;
             }
@@ -80,20 +124,83 @@ namespace Relax {
                 return it;
             }
 
+            iterator& operator--() noexcept {
+                m_node = (nullptr == m_node) ? maxRight(m_owner->m_root) : prev(m_node);
+                return *this;
+            }
+            iterator operator--(int) noexcept {
+                iterator it(*this);
+                --(*this);
+                return it;
+            }
+
             bool operator==(const iterator& other) const noexcept { return m_node == other.m_node; }
             bool operator!=(const iterator& other) const noexcept { return m_node != other.m_node; }
 
         private:
+            const IntrusiveMap* m_owner;
+
+            pointer_type m_node;
+        };
+
+        // descending order of keys
+        class reverse_iterator : public std::iterator<std::input_iterator_tag, pointer_type> {
+            friend class IntrusiveMap<V>;
+
+            reverse_iterator(const IntrusiveMap* owner, pointer_type node)
+              : m_owner(owner)
+              , m_node(node) { }
+
+        public:
+            reverse_iterator(const reverse_iterator& it) = default;
+            ~reverse_iterator() = default;
+
+            reverse_iterator& operator=(const reverse_iterator& it) noexcept = default;
+
+            pointer_type operator*() const noexcept { return m_node; }
+            pointer_type operator->() const noexcept { return m_node; }
+
+            reverse_iterator& operator++() noexcept {
+                m_node = prev(m_node);
+                return *this;
+            }
+            reverse_iterator operator++(int) noexcept {
+                reverse_iterator it(*this);
+                ++(*this);
+                return it;
+            }
+
+            // like std::reverse_iterator::base(): iterator of the next node, begin() for rend()
+            iterator base() const noexcept {
+                if (nullptr == m_node)
+                    return m_owner->begin();
+                return iterator(m_owner, next(m_node));
+            }
+
+            bool operator==(const reverse_iterator& other) const noexcept { return m_node == other.m_node; }
+            bool operator!=(const reverse_iterator& other) const noexcept { return m_node != other.m_node; }
+
+        private:
+            const IntrusiveMap* m_owner;
+
             pointer_type m_node;
         };
 
         iterator begin() const {
             if (nullptr == m_root)
                 return end();
-            return iterator(maxLeft(m_root));
+            return iterator(this, maxLeft(m_root));
         }
 
-        iterator end() const { return iterator(nullptr); }
+        iterator end() const { return iterator(this, nullptr); }
+
+        reverse_iterator rbegin() const {
+            if (nullptr == m_root)
+                return rend();
+            return reverse_iterator(this, maxRight(m_root));
+        }
+
+        reverse_iterator rend() const { return reverse_iterator(this, nullptr); }
 
     public:
         bool checkRB() noexcept;
@@ -101,10 +208,46 @@ namespace Relax {
     private:
         static pointer_type next(pointer_type node) noexcept;
 
+        static pointer_type prev(pointer_type node) noexcept;
+
         static inline pointer_type maxLeft(pointer_type node) noexcept;
 
+        static inline pointer_type maxRight(pointer_type node) noexcept;
+
         static void erase_swap(pointer_type one, pointer_type other) noexcept;
 
+        // subtree of n nodes from first under parent, returns its root
+        template<class RandomIt>
+        static pointer_type buildSubtree(RandomIt first,
+                                         size_t n,
+                                         pointer_type parent,
+                                         size_t depth,
+                                         size_t red_depth) noexcept;
+
+        // subtree of build_from_sorted left for worker: its root goes to *link
+        template<class RandomIt>
+        struct TBuildTask {
+            RandomIt m_first;
+            size_t m_n;
+            pointer_type m_parent;
+            pointer_type* m_link;
+            size_t m_depth;
+        };
+
+        // links nodes above split_depth, subtrees at split_depth go to tasks
+        template<class RandomIt>
+        static void buildTop(RandomIt first,
+                             size_t n,
+                             pointer_type parent,
+                             pointer_type* link,
+                             size_t depth,
+                             size_t red_depth,
+                             size_t split_depth,
+                             std::vector<TBuildTask<RandomIt>>& tasks);
+
+        // depth of the last level of tree of n nodes built by build_from_sorted
+        static inline size_t redDepth(size_t n) noexcept;
+
     private:
         static pointer_type uncle(pointer_type const parent) noexcept;
 
@@ -135,6 +278,16 @@ namespace Relax {
 
         static inline void assert_pure(pointer_type ptr);
 
+    public:
+        // height of red-black tree <= 2 * log2(size + 1)
+        static constexpr size_t m_max_depth = 2 * 64;
+
+        // parallel build: 2^6 subtrees for workers to steal
+        static constexpr size_t m_build_split_depth = 6;
+
+        // smaller ranges are linked by the calling thread: fork costs more than linking
+        static constexpr size_t m_min_parallel_build = 1 << 16;
+
     private:
         pointer_type m_root;
 
@@ -149,7 +302,7 @@ namespace Relax {
 
     //--------------------------------------------------------------//
     template<IntrusiveMappable V>
-    typename IntrusiveMap<V>::iterator IntrusiveMap<V>::find(const key_type& key) noexcept {
+    typename IntrusiveMap<V>::iterator IntrusiveMap<V>::find(const key_type& key) const noexcept {
         if (nullptr == m_root) {
             return end();
         }
@@ -162,7 +315,87 @@ namespace Relax {
                 return end();
         }
 
-        return iterator(node);
+        return iterator(this, node);
+    }
+
+    //--------------------------------------------------------------//
+    template<IntrusiveMappable V>
+    std::pair<typename IntrusiveMap<V>::iterator, bool> IntrusiveMap<V>::findOptimistic(
+        const key_type& key) const noexcept {
+        pointer_type node = NAtomic::load(&m_root, std::memory_order_relaxed);
+        for (size_t depth = 0; depth < m_max_depth; ++depth) {
+            if (nullptr == node)
+                return {end(), true};
+
+            const key_type node_key = node->m_key;
+            if (key == node_key)
+                return {iterator(this, node), true};
+
+            // both links are loaded: select of loaded values does not branch on random keys
+            const pointer_type left = NAtomic::load(&node->m_left, std::memory_order_relaxed);
+            const pointer_type right = NAtomic::load(&node->m_right, std::memory_order_relaxed);
+            node = pure((key < node_key) ? left : right);
+        }
+
+        return {end(), false};
+    }
+
+    //--------------------------------------------------------------//
+    template<IntrusiveMappable V>
+    typename IntrusiveMap<V>::iterator IntrusiveMap<V>::lower_bound(const key_type& key) const noexcept {
+        pointer_type bound = nullptr;
+        pointer_type node = m_root;
+        while (nullptr != node) {
+            if (node->m_key < key) {
+                node = pure(node->m_right);
+            }
+            else {
+                bound = node;
+                node = pure(node->m_left);
+            }
+        }
+
+        return iterator(this, bound);
+    }
+
+    //--------------------------------------------------------------//
+    template<IntrusiveMappable V>
+    typename IntrusiveMap<V>::iterator IntrusiveMap<V>::upper_bound(const key_type& key) const noexcept {
+        pointer_type bound = nullptr;
+        pointer_type node = m_root;
+        while (nullptr != node) {
+            if (key < node->m_key) {
+                bound = node;
+                node = pure(node->m_left);
+            }
+            else {
+                node = pure(node->m_right);
+            }
+        }
+
+        return iterator(this, bound);
+    }
+
+    //--------------------------------------------------------------//
+    template<IntrusiveMappable V>
+    std::pair<typename IntrusiveMap<V>::iterator, typename IntrusiveMap<V>::iterator> IntrusiveMap<V>::equal_range(
+        const key_type& key) const noexcept {
+        // keys are unique: range is empty or single node
+        const iterator lower = lower_bound(key);
+        if (end() == lower || key != (*lower)->m_key)
+            return {lower, lower};
+
+        return {lower, iterator(this, next(*lower))};
+    }
+
+    //--------------------------------------------------------------//
+    template<IntrusiveMappable V>
+    template<class Visitor>
+    void IntrusiveMap<V>::for_each_in_range(const key_type& lo, const key_type& hi, Visitor&& f) const {
+        // single descent, then in-order walk: amortized O(1) per visited node
+        for (pointer_type node = *lower_bound(lo); nullptr != node && node->m_key < hi; node = next(node)) {
+            f(node);
+        }
     }
 
     //--------------------------------------------------------------//
@@ -195,13 +428,13 @@ namespace Relax {
             value->m_right = nullptr;
             value->m_parent = nullptr;
             ++m_size;
-            return std::pair<iterator, bool>(iterator(value), true);
+            return std::pair<iterator, bool>(iterator(this, value), true);
         }
 
         pointer_type node = m_root;
         while (true) {
             if (key == node->m_key)
-                return std::pair<iterator, bool>(iterator(node), false);
+                return std::pair<iterator, bool>(iterator(this, node), false);
 
             pointer_type const next = pure((key < node->m_key) ? node->m_left : node->m_right);
 
@@ -220,7 +453,7 @@ namespace Relax {
         value->m_left = nullptr;
         value->m_right = nullptr;
         ++m_size;
-        const iterator result_iterator = iterator(value);
+        const iterator result_iterator = iterator(this, value);
 
         if (is_node_black(node)) {
             return std::pair<iterator, bool>(result_iterator, true);
@@ -301,6 +534,112 @@ namespace Relax {
         return std::pair<iterator, bool>(result_iterator, true);
     }
 
+    //--------------------------------------------------------------//
+    template<IntrusiveMappable V>
+    template<class RandomIt>
+    void IntrusiveMap<V>::build_from_sorted(RandomIt first, RandomIt last) noexcept {
+        assert(0 == m_size);
+        assert(last == std::adjacent_find(first, last, [](pointer_type one, pointer_type other) noexcept {
+                   return !(one->m_key < other->m_key);
+               }));
+
+        const size_t n = last - first;
+        m_root = buildSubtree(first, n, nullptr, 0, redDepth(n));
+        m_size = n;
+    }
+
+    //--------------------------------------------------------------//
+    template<IntrusiveMappable V>
+    template<class RandomIt, class Pool>
+    void IntrusiveMap<V>::build_from_sorted(RandomIt first, RandomIt last, Pool& pool) {
+        const size_t n = last - first;
+        if (n < m_min_parallel_build) {
+            build_from_sorted(first, last);
+            return;
+        }
+
+        assert(0 == m_size);
+        assert(last == std::adjacent_find(first, last, [](pointer_type one, pointer_type other) noexcept {
+                   return !(one->m_key < other->m_key);
+               }));
+
+        const size_t red_depth = redDepth(n);
+        std::vector<TBuildTask<RandomIt>> tasks;
+        tasks.reserve(size_t(1) << m_build_split_depth);
+        buildTop(first, n, nullptr, &m_root, 0, red_depth, m_build_split_depth, tasks);
+
+        // workers write links of different nodes
+        try {
+            pool.parallel_for(size_t(0), tasks.size(), size_t(1), [&tasks, red_depth](size_t i) noexcept {
+                const TBuildTask<RandomIt>& task = tasks[i];
+                *task.m_link = buildSubtree(task.m_first, task.m_n, task.m_parent, task.m_depth, red_depth);
+            });
+        }
+        catch (...) {
+            // nodes are not owned: map stays empty
+            m_root = nullptr;
+            throw;
+        }
+
+        m_size = n;
+    }
+
+    //--------------------------------------------------------------//
+    template<IntrusiveMappable V>
+    template<class RandomIt>
+    V* IntrusiveMap<V>::buildSubtree(RandomIt first,
+                                     size_t n,
+                                     pointer_type parent,
+                                     size_t depth,
+                                     size_t red_depth) noexcept {
+        if (0 == n)
+            return nullptr;
+
+        // left subtree is not larger than right one: sizes differ by 1 at most
+        const size_t nleft = (n - 1) / 2;
+        pointer_type const node = first[nleft];
+
+        node->m_parent = (depth == red_depth) ? red(parent) : parent;
+        node->m_left = buildSubtree(first, nleft, node, depth + 1, red_depth);
+        node->m_right = buildSubtree(first + nleft + 1, n - nleft - 1, node, depth + 1, red_depth);
+
+        return node;
+    }
+
+    //--------------------------------------------------------------//
+    template<IntrusiveMappable V>
+    template<class RandomIt>
+    void IntrusiveMap<V>::buildTop(RandomIt first,
+                                   size_t n,
+                                   pointer_type parent,
+                                   pointer_type* link,
+                                   size_t depth,
+                                   size_t red_depth,
+                                   size_t split_depth,
+                                   std::vector<TBuildTask<RandomIt>>& tasks) {
+        if (0 == n || depth == split_depth) {
+            *link = nullptr;
+            if (0 != n)
+                tasks.push_back({first, n, parent, link, depth});
+            return;
+        }
+
+        const size_t nleft = (n - 1) / 2;
+        pointer_type const node = first[nleft];
+        *link = node;
+
+        node->m_parent = (depth == red_depth) ? red(parent) : parent;
+        buildTop(first, nleft, node, &node->m_left, depth + 1, red_depth, split_depth, tasks);
+        buildTop(first + nleft + 1, n - nleft - 1, node, &node->m_right, depth + 1, red_depth, split_depth, tasks);
+    }
+
+    //--------------------------------------------------------------//
+    template<IntrusiveMappable V>
+    inline size_t IntrusiveMap<V>::redDepth(size_t n) noexcept {
+        // levels [0, red_depth) are complete: 2^red_depth - 1 <= n
+        return std::bit_width(n + 1) - 1;
+    }
+
     //--------------------------------------------------------------//
     template<IntrusiveMappable V>
     size_t IntrusiveMap<V>::erase(const key_type& key) noexcept {
@@ -323,7 +662,7 @@ namespace Relax {
         assert(nullptr != m_root);
         --m_size;
 
-        const iterator next_iter = iterator(next(iter.m_node));
+        const iterator next_iter = iterator(this, next(iter.m_node));
         pointer_type node = iter.m_node;
         if ((nullptr != node->m_left) && (nullptr != node->m_right)) {
             pointer_type const min_right = maxLeft(pure(node->m_right));
@@ -535,6 +874,13 @@ namespace Relax {
     //--------------------------------------------------------------//
     template<IntrusiveMappable V>
     void IntrusiveMap<V>::clearWithDestruct() noexcept {
+        clearWithDestruct([](pointer_type node) noexcept { delete node; });
+    }
+
+    //--------------------------------------------------------------//
+    template<IntrusiveMappable V>
+    template<class Disposer>
+    void IntrusiveMap<V>::clearWithDestruct(Disposer&& dispose) noexcept {
         pointer_type node = m_root;
         while (nullptr != node) {
             pointer_type next = node->m_left;
@@ -548,7 +894,7 @@ namespace Relax {
                         else
                             next->m_right = nullptr;
                     }
-                    delete node;
+                    dispose(node);
                 }
             }
 
@@ -630,6 +976,21 @@ namespace Relax {
         return parent;
     }
 
+    //--------------------------------------------------------------//
+    template<IntrusiveMappable V>
+    V* IntrusiveMap<V>::prev(pointer_type node) noexcept {
+        if (nullptr != node->m_left) {
+            return maxRight(pure(node->m_left));
+        }
+
+        pointer_type parent = pure(node->m_parent);
+        while (nullptr != parent && node->m_key < parent->m_key) {
+            parent = pure(parent->m_parent);
+        }
+
+        return parent;
+    }
+
     //--------------------------------------------------------------//
     template<IntrusiveMappable V>
     V* IntrusiveMap<V>::maxLeft(pointer_type node) noexcept {
@@ -639,6 +1000,15 @@ namespace Relax {
         return node;
     }
 
+    //--------------------------------------------------------------//
+    template<IntrusiveMappable V>
+    V* IntrusiveMap<V>::maxRight(pointer_type node) noexcept {
+        while (nullptr != node->m_right)
+            node = pure(node->m_right);
+
+        return node;
+    }
+
     //--------------------------------------------------------------//
     template<IntrusiveMappable V>
     void IntrusiveMap<V>::erase_swap(pointer_type one, pointer_type other) noexcept {
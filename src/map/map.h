@@ -1,6 +1,16 @@
 #pragma once
 
+#include <cassert>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "alloc/arena.h"
 #include "intrusive_map.h"
+#include "sync/seqlock.h"
 #include "types.h"
 
 namespace Relax {
@@ -12,8 +22,17 @@ namespace Relax {
     };
 
     //////////////////////////////////////////////////////////////////
-
-    template<class K, class T, class Lock = FakeLock>
+    /*
+     * Alloc - node allocator. Default ArenaAllocator<T>: nodes are cut from contiguous chunks of map's arena,
+     * erased nodes are reused, clear() and destructor free the arena in O(chunks).
+     * Nodes are allocated and freed under Lock.
+     * Lock - BasicLockable. SharedLockable Lock (e.g. std::shared_mutex): lookups run under shared lock,
+     * writes under exclusive one.
+     * OptimisticLockable Lock (TSeqLock): lookups take no lock, they walk the tree racing with writers and are
+     * repeated if writer ran meanwhile. Needs trivially copyable K and type-stable Alloc (default arena):
+     * erased nodes may be still read, arena is freed by destructor only.
+     */
+    template<class K, class T, class Lock = FakeLock, class Alloc = ArenaAllocator<T>>
     class Map {
     public:
         struct Node : TIntrusiveMappableBase<K, Node> {
@@ -29,6 +48,11 @@ namespace Relax {
             T m_value;
         };
 
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node> node_allocator_type;
+        typedef std::allocator_traits<node_allocator_type> node_allocator_traits;
+
+        typedef typename IntrusiveMap<Node>::iterator tree_iterator;
+
     public:
         typedef K key_type;
         typedef T mapped_type;
@@ -36,12 +60,14 @@ namespace Relax {
         typedef T& reference;
         typedef const T& const_reference;
         typedef size_t size_type;
+        typedef Alloc allocator_type;
 
     public:
         class iterator;
 
         Map()
-          : m_tree() { }
+          : m_tree()
+          , m_alloc() { }
 
         ~Map() { clear(); }
 
@@ -62,13 +88,52 @@ namespace Relax {
 
         size_type erase(key_type key);
 
+        // [first, last) - pairs of key and value, inserted under single lock acquisition.
+        // Returns number of inserted
+        template<class InputIt>
+        size_type insert_range(InputIt first, InputIt last);
+
+        // [first, last) - keys, erased under single lock acquisition. Returns number of erased
+        template<class InputIt>
+        size_type erase_range(InputIt first, InputIt last);
+
+        /*
+         * Fills empty map by [first, last) - pairs of key and value with strictly increasing keys, in O(n).
+         * Nodes are allocated in order of keys: arena places neighbours of tree walk side by side
+         */
+        template<class InputIt>
+        void build_from_sorted(InputIt first, InputIt last);
+
+        // build_from_sorted with nodes constructed and linked by pool.parallel_for (ThreadPool),
+        // allocation stays on calling thread
+        template<class RandomIt, class Pool>
+        void build_from_sorted(RandomIt first, RandomIt last, Pool& pool);
+
+        iterator find(const key_type& key) const;
+
+        bool contains(const key_type& key) const;
+
+        // copy of value: reference would outlive the lock. Throws std::out_of_range if key is not present
+        mapped_type at(const key_type& key) const;
+
+        // bounds are found under shared lock, like find: iterators are not protected after return
+        iterator lower_bound(const key_type& key) const;
+
+        iterator upper_bound(const key_type& key) const;
+
+        std::pair<iterator, iterator> equal_range(const key_type& key) const;
+
+        // f(key, value) for each key in [lo, hi), in order of keys, under shared lock
+        template<class Visitor>
+        void for_each_in_range(const key_type& lo, const key_type& hi, Visitor&& f) const;
+
         void clear() noexcept;
 
         size_type size() const noexcept;
 
     public:
-        class iterator : public std::iterator<std::input_iterator_tag, mapped_type> {
-            friend class Map<K, T, Lock>;
+        class iterator : public std::iterator<std::bidirectional_iterator_tag, mapped_type> {
+            friend class Map<K, T, Lock, Alloc>;
 
             iterator(typename IntrusiveMap<Node>::iterator it)
               : m_it(it) { }
@@ -96,6 +161,16 @@ namespace Relax {
                 return it;
             }
 
+            iterator& operator--() {
+                --m_it;
+                return *this;
+            }
+            iterator operator--(int) {
+                iterator it(*this);
+                --m_it;
+                return it;
+            }
+
             bool operator==(const iterator& other) const { return m_it == other.m_it; }
             bool operator!=(const iterator& other) const { return m_it != other.m_it; }
 
@@ -109,116 +184,424 @@ namespace Relax {
     public:
         bool checkRB() { return m_tree.checkRB(); }
 
+    private:
+        // creates node under lock, destroys it if key is already present
+        template<typename... Args>
+        std::pair<iterator, bool> emplaceNode(Args&&... args);
+
+        template<typename... Args>
+        Node* createNode(Args&&... args);
+
+        void destroyNode(Node* node) noexcept;
+
+        /*
+         * read(tree iterator of key) under read protection. Optimistic - Lock is OptimisticLockable and read
+         * tolerates torn node: read is repeated on conflict with writer, after m_optimistic_attempts conflicts
+         * reader takes the lock
+         */
+        template<bool Optimistic, class Read>
+        auto readNode(const key_type& key, Read&& read) const;
+
+        // shared lock of lookups: exclusive one if Lock is not SharedLockable
+        void lockShared() const;
+
+        void unlockShared() const noexcept;
+
     private:
         IntrusiveMap<Node> m_tree;
 
+        node_allocator_type m_alloc;
+
     private:
-        Lock m_lock;
+        mutable Lock m_lock;
+
+        static constexpr uint32_t m_optimistic_attempts = 16;
+
+        // nodes constructed per stolen part of parallel build_from_sorted
+        static constexpr size_t m_build_grain = 4096;
+
+        static_assert(!OptimisticLockable<Lock> ||
+                          (std::is_trivially_copyable_v<K> && IsTypeStable<node_allocator_type>),
+                      "optimistic readers compare keys of erased nodes: trivially copyable K, type-stable Alloc");
     };
 
     //--------------------------------------------------------------//
-    template<class K, class T, class L>
+    template<class K, class T, class L, class A>
     template<typename... Args>
-    std::pair<typename Map<K, T, L>::iterator, bool> Map<K, T, L>::emplace(const key_type& key, Args&&... args) {
-        typename Map<K, T, L>::Node* node = new Node(key, std::forward<Args>(args)...);
+    std::pair<typename Map<K, T, L, A>::iterator, bool> Map<K, T, L, A>::emplace(const key_type& key,
+                                                                                Args&&... args) {
+        return emplaceNode(key, std::forward<Args>(args)...);
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    template<typename... Args>
+    std::pair<typename Map<K, T, L, A>::iterator, bool> Map<K, T, L, A>::emplace(key_type&& key, Args&&... args) {
+        return emplaceNode(std::forward<key_type>(key), std::forward<Args>(args)...);
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    std::pair<typename Map<K, T, L, A>::iterator, bool> Map<K, T, L, A>::insert(key_type const key,
+                                                                                mapped_type const value) {
+        return emplaceNode(key, value);
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    std::pair<typename Map<K, T, L, A>::iterator, bool> Map<K, T, L, A>::insert(
+        const std::pair<key_type, mapped_type>& value) {
+        return emplaceNode(value.first, value.second);
+    }
 
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    size_t Map<K, T, L, A>::erase(key_type key) {
         // no guard
         // for simple remove of fake lock by optimizer
         m_lock.lock();
 
-        const auto res = m_tree.insert(node);
+        const auto iter = m_tree.find(key);
+
+        if (m_tree.end() == iter) {
+            m_lock.unlock();
+
+            return 0;
+        }
 
+        const auto res = m_tree.erase(key);
+
+        Node* const node = *iter;
+        destroyNode(node);
         m_lock.unlock();
 
-        return std::pair<iterator, bool>(iterator(res.first), res.second);
+        assert(1 == res);
+
+        return 1;
     }
 
     //--------------------------------------------------------------//
-    template<class K, class T, class L>
-    template<typename... Args>
-    std::pair<typename Map<K, T, L>::iterator, bool> Map<K, T, L>::emplace(key_type&& key, Args&&... args) {
-        typename Map<K, T, L>::Node* node = new Node(std::forward<key_type>(key), std::forward<Args>(args)...);
+    template<class K, class T, class L, class A>
+    template<class InputIt>
+    typename Map<K, T, L, A>::size_type Map<K, T, L, A>::insert_range(InputIt first, InputIt last) {
+        size_type count = 0;
+        m_lock.lock();
 
-        // no guard
-        // for simple remove of fake lock by optimizer
+        try {
+            for (; first != last; ++first) {
+                const auto& value = *first;
+                Node* const node = createNode(value.first, value.second);
+                if (m_tree.insert(node).second)
+                    ++count;
+                else
+                    destroyNode(node);
+            }
+        }
+        catch (...) {
+            m_lock.unlock();
+            throw;
+        }
+
+        m_lock.unlock();
+        return count;
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    template<class InputIt>
+    typename Map<K, T, L, A>::size_type Map<K, T, L, A>::erase_range(InputIt first, InputIt last) {
+        size_type count = 0;
         m_lock.lock();
 
-        const auto res = m_tree.insert(node);
+        for (; first != last; ++first) {
+            const auto iter = m_tree.find(*first);
+            if (m_tree.end() == iter)
+                continue;
+
+            Node* const node = *iter;
+            m_tree.erase(iter);
+            destroyNode(node);
+            ++count;
+        }
 
         m_lock.unlock();
+        return count;
+    }
 
-        return std::pair<iterator, bool>(iterator(res.first), res.second);
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    template<class InputIt>
+    void Map<K, T, L, A>::build_from_sorted(InputIt first, InputIt last) {
+        std::vector<Node*> nodes;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                                        typename std::iterator_traits<InputIt>::iterator_category>)
+            nodes.reserve(std::distance(first, last));
+
+        m_lock.lock();
+        assert(0 == m_tree.size());
+
+        try {
+            for (; first != last; ++first) {
+                const auto& value = *first;
+                nodes.push_back(createNode(value.first, value.second));
+            }
+        }
+        catch (...) {
+            for (Node* node : nodes) {
+                destroyNode(node);
+            }
+            m_lock.unlock();
+            throw;
+        }
+
+        m_tree.build_from_sorted(nodes.begin(), nodes.end());
+        m_lock.unlock();
     }
 
     //--------------------------------------------------------------//
-    template<class K, class T, class L>
-    std::pair<typename Map<K, T, L>::iterator, bool> Map<K, T, L>::insert(key_type const key,
-                                                                          mapped_type const value) {
-        typename Map<K, T, L>::Node* node = new Node(key, value);
+    template<class K, class T, class L, class A>
+    template<class RandomIt, class Pool>
+    void Map<K, T, L, A>::build_from_sorted(RandomIt first, RandomIt last, Pool& pool) {
+        static_assert(std::is_nothrow_copy_constructible_v<K> && std::is_nothrow_copy_constructible_v<T>,
+                      "nodes are constructed by workers: nothrow copy of K and T");
+
+        const size_t n = last - first;
+        std::vector<Node*> memory(n);
+
+        // nullptr - node is not constructed
+        std::vector<Node*> nodes(n, nullptr);
 
-        // no guard
-        // for simple remove of fake lock by optimizer
         m_lock.lock();
+        assert(0 == m_tree.size());
 
-        const auto res = m_tree.insert(node);
+        // allocator is not thread-safe: memory is taken here, workers only construct
+        size_t nallocated = 0;
+        try {
+            for (; nallocated < n; ++nallocated) {
+                memory[nallocated] = node_allocator_traits::allocate(m_alloc, 1);
+            }
+
+            pool.parallel_for(size_t(0), n, m_build_grain, [this, &memory, &nodes, first](size_t i) noexcept {
+                const auto& value = first[i];
+                node_allocator_traits::construct(m_alloc, memory[i], value.first, value.second);
+                nodes[i] = memory[i];
+            });
+
+            m_tree.build_from_sorted(nodes.begin(), nodes.end(), pool);
+        }
+        catch (...) {
+            // fork of pool failed: some parts may be not constructed
+            for (size_t i = 0; i < nallocated; ++i) {
+                if (nullptr != nodes[i])
+                    destroyNode(nodes[i]);
+                else
+                    node_allocator_traits::deallocate(m_alloc, memory[i], 1);
+            }
+            m_lock.unlock();
+            throw;
+        }
 
         m_lock.unlock();
+    }
 
-        return std::pair<iterator, bool>(iterator(res.first), res.second);
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    typename Map<K, T, L, A>::iterator Map<K, T, L, A>::find(const key_type& key) const {
+        return iterator(readNode<true>(key, [](tree_iterator iter) { return iter; }));
     }
 
     //--------------------------------------------------------------//
-    template<class K, class T, class L>
-    std::pair<typename Map<K, T, L>::iterator, bool> Map<K, T, L>::insert(
-        const std::pair<key_type, mapped_type>& value) {
-        typename Map<K, T, L>::Node* node = new Node(std::pair<key_type, mapped_type>(value));
+    template<class K, class T, class L, class A>
+    bool Map<K, T, L, A>::contains(const key_type& key) const {
+        return readNode<true>(key, [this](tree_iterator iter) { return m_tree.end() != iter; });
+    }
 
-        // no guard
-        // for simple remove of fake lock by optimizer
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    T Map<K, T, L, A>::at(const key_type& key) const {
+        // torn copy of not trivially copyable value is not safe: under lock
+        auto value = readNode<std::is_trivially_copyable_v<T>>(key, [this](tree_iterator iter) {
+            return (m_tree.end() == iter) ? std::optional<T>() : std::optional<T>(iter->m_value);
+        });
+
+        if (!value)
+            throw std::out_of_range("Relax::Map::at: key is not present");
+
+        return std::move(*value);
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    typename Map<K, T, L, A>::iterator Map<K, T, L, A>::lower_bound(const key_type& key) const {
+        lockShared();
+        const tree_iterator iter = m_tree.lower_bound(key);
+        unlockShared();
+
+        return iterator(iter);
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    typename Map<K, T, L, A>::iterator Map<K, T, L, A>::upper_bound(const key_type& key) const {
+        lockShared();
+        const tree_iterator iter = m_tree.upper_bound(key);
+        unlockShared();
+
+        return iterator(iter);
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    std::pair<typename Map<K, T, L, A>::iterator, typename Map<K, T, L, A>::iterator> Map<K, T, L, A>::equal_range(
+        const key_type& key) const {
+        lockShared();
+        const auto [lower, upper] = m_tree.equal_range(key);
+        unlockShared();
+
+        return {iterator(lower), iterator(upper)};
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    template<class Visitor>
+    void Map<K, T, L, A>::for_each_in_range(const key_type& lo, const key_type& hi, Visitor&& f) const {
+        lockShared();
+        try {
+            m_tree.for_each_in_range(lo, hi, [&f](const Node* node) {
+                f(node->m_key, static_cast<const mapped_type&>(node->m_value));
+            });
+        }
+        catch (...) {
+            unlockShared();
+            throw;
+        }
+
+        unlockShared();
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    template<bool Optimistic, class Read>
+    auto Map<K, T, L, A>::readNode(const key_type& key, Read&& read) const {
+        if constexpr (Optimistic && OptimisticLockable<L>) {
+            for (uint32_t attempt = 0; attempt < m_optimistic_attempts; ++attempt) {
+                const uint64_t version = m_lock.read_begin();
+                const auto [iter, complete] = m_tree.findOptimistic(key);
+                if (!complete)
+                    continue;
+
+                auto result = read(iter);
+                if (!m_lock.read_retry(version))
+                    return result;
+            }
+        }
+
+        lockShared();
+        try {
+            auto result = read(m_tree.find(key));
+            unlockShared();
+            return result;
+        }
+        catch (...) {
+            unlockShared();
+            throw;
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    void Map<K, T, L, A>::clear() noexcept {
         m_lock.lock();
 
-        const auto res = m_tree.insert(node);
+        // optimistic readers may still read nodes: arena is not freed
+        if constexpr (!OptimisticLockable<L> && requires(node_allocator_type& alloc) { alloc.release(); }) {
+            // arena: nodes are only destroyed, memory is freed by chunks
+            if constexpr (std::is_trivially_destructible_v<Node>)
+                m_tree.clear();
+            else
+                m_tree.clearWithDestruct([this](Node* node) noexcept {
+                    node_allocator_traits::destroy(m_alloc, node);
+                });
+
+            m_alloc.release();
+        }
+        else {
+            m_tree.clearWithDestruct([this](Node* node) noexcept { destroyNode(node); });
+        }
 
         m_lock.unlock();
-
-        return std::pair<iterator, bool>(iterator(res.first), res.second);
     }
 
     //--------------------------------------------------------------//
-    template<class K, class T, class L>
-    size_t Map<K, T, L>::erase(key_type key) {
+    template<class K, class T, class L, class A>
+    template<typename... Args>
+    std::pair<typename Map<K, T, L, A>::iterator, bool> Map<K, T, L, A>::emplaceNode(Args&&... args) {
         // no guard
         // for simple remove of fake lock by optimizer
         m_lock.lock();
 
-        const auto iter = m_tree.find(key);
-
-        if (m_tree.end() == iter) {
+        Node* node;
+        try {
+            node = createNode(std::forward<Args>(args)...);
+        }
+        catch (...) {
             m_lock.unlock();
-
-            return 0;
+            throw;
         }
 
-        const auto res = m_tree.erase(key);
+        const auto res = m_tree.insert(node);
+        if (!res.second)
+            destroyNode(node);
+
         m_lock.unlock();
 
-        Node* const node = *iter;
-        delete node;
+        return std::pair<iterator, bool>(iterator(res.first), res.second);
+    }
 
-        assert(1 == res);
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    template<typename... Args>
+    typename Map<K, T, L, A>::Node* Map<K, T, L, A>::createNode(Args&&... args) {
+        Node* const node = node_allocator_traits::allocate(m_alloc, 1);
+        try {
+            node_allocator_traits::construct(m_alloc, node, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            node_allocator_traits::deallocate(m_alloc, node, 1);
+            throw;
+        }
 
-        return 1;
+        return node;
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    void Map<K, T, L, A>::destroyNode(Node* node) noexcept {
+        node_allocator_traits::destroy(m_alloc, node);
+        node_allocator_traits::deallocate(m_alloc, node, 1);
     }
 
     //--------------------------------------------------------------//
-    template<class K, class T, class L>
-    void Map<K, T, L>::clear() noexcept {
-        m_tree.clearWithDestruct();
+    template<class K, class T, class L, class A>
+    inline void Map<K, T, L, A>::lockShared() const {
+        if constexpr (SharedLockable<L>)
+            m_lock.lock_shared();
+        else
+            m_lock.lock();
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, class A>
+    inline void Map<K, T, L, A>::unlockShared() const noexcept {
+        if constexpr (SharedLockable<L>)
+            m_lock.unlock_shared();
+        else
+            m_lock.unlock();
     }
 
     //--------------------------------------------------------------//
-    template<class K, class T, class L>
-    size_t Map<K, T, L>::size() const noexcept {
+    template<class K, class T, class L, class A>
+    size_t Map<K, T, L, A>::size() const noexcept {
         return m_tree.size();
     }
 
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+#include "map.h"
+#include "types.h"
+
+namespace Relax {
+
+#pragma region ShardedMap
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * NShards Map's under one facade, key goes to shard by its hash.
+     *  * Writers of different shards do not share lock: shards are cache line aligned
+     *  * insert_batch/erase_batch - values are grouped by shard, each shard is locked once per batch
+     *  * begin/end - ordered iteration by merge of shards (rare full scans), not safe against concurrent writers
+     * Lock, Alloc - per shard, see Map.
+     */
+    template<class K, class T, class Lock = std::mutex, size_t NShards = 16, class Alloc = ArenaAllocator<T>>
+    class ShardedMap {
+        static_assert(0 < NShards && 0 == (NShards & (NShards - 1)), "NShards - power of 2");
+
+        typedef Map<K, T, Lock, Alloc> shard_type;
+
+        struct alignas(CACHELINE_SIZE) TShard {
+            shard_type m_map;
+        };
+
+    public:
+        typedef K key_type;
+        typedef T mapped_type;
+        typedef T* pointer_type;
+        typedef size_t size_type;
+        typedef Alloc allocator_type;
+
+        static constexpr size_type m_nshards = NShards;
+
+    public:
+        class iterator;
+
+        ShardedMap() = default;
+
+        ShardedMap(const ShardedMap& other) = delete;
+        ShardedMap(ShardedMap&& other) noexcept = delete;
+        ShardedMap& operator=(const ShardedMap& other) = delete;
+        ShardedMap& operator=(ShardedMap&& other) noexcept = delete;
+
+        template<typename... Args>
+        std::pair<typename shard_type::iterator, bool> emplace(const key_type& key, Args&&... args);
+
+        std::pair<typename shard_type::iterator, bool> insert(key_type key, mapped_type value);
+
+        size_type erase(key_type key);
+
+        bool contains(const key_type& key) const;
+
+        // copy of value, throws std::out_of_range if key is not present
+        mapped_type at(const key_type& key) const;
+
+        // [first, last) - pairs of key and value (lvalues), returns number of inserted
+        template<class ForwardIt>
+        size_type insert_batch(ForwardIt first, ForwardIt last);
+
+        // returns number of erased
+        size_type erase_batch(std::span<const key_type> keys);
+
+        void clear() noexcept;
+
+        size_type size() const noexcept;
+
+        static size_type shardOf(const key_type& key) noexcept;
+
+    public:
+        class iterator : public std::iterator<std::input_iterator_tag, mapped_type> {
+            friend class ShardedMap<K, T, Lock, NShards, Alloc>;
+
+            typedef typename shard_type::iterator shard_iterator;
+
+            iterator(const ShardedMap* owner, std::array<shard_iterator, NShards> its)
+              : m_owner(owner)
+              , m_its(its) {
+                selectMin();
+            }
+
+        public:
+            iterator(const iterator& it) = default;
+            ~iterator() = default;
+
+            iterator& operator=(const iterator& it) = default;
+
+            auto operator*() const noexcept { return *m_its[m_current]; }
+            pointer_type operator->() const { return m_its[m_current].operator->(); }
+
+            iterator& operator++() {
+                ++m_its[m_current];
+                selectMin();
+                return *this;
+            }
+            iterator operator++(int) {
+                iterator it(*this);
+                ++(*this);
+                return it;
+            }
+
+            bool operator==(const iterator& other) const {
+                return m_current == other.m_current &&
+                       (NShards == m_current || m_its[m_current] == other.m_its[m_current]);
+            }
+            bool operator!=(const iterator& other) const { return !(*this == other); }
+
+        private:
+            // shard of least key, NShards - all shards are passed
+            void selectMin();
+
+        private:
+            const ShardedMap* m_owner;
+
+            std::array<shard_iterator, NShards> m_its;
+
+            size_type m_current = NShards;
+        };
+
+        iterator begin() const;
+        iterator end() const;
+
+    private:
+        template<size_t... Index>
+        std::array<typename shard_type::iterator, NShards> begins(std::index_sequence<Index...>) const;
+
+        template<size_t... Index>
+        std::array<typename shard_type::iterator, NShards> ends(std::index_sequence<Index...>) const;
+
+    private:
+        std::array<TShard, NShards> m_shards;
+    };
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    inline typename ShardedMap<K, T, L, N, A>::size_type ShardedMap<K, T, L, N, A>::shardOf(
+        const key_type& key) noexcept {
+        if constexpr (1 == N)
+            return 0;
+
+        // Fibonacci hashing: top bits of product, std::hash of integers is identity
+        const uint64_t hash = static_cast<uint64_t>(std::hash<K>{}(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_type>(hash >> (64 - std::countr_zero(N)));
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    template<typename... Args>
+    inline std::pair<typename Map<K, T, L, A>::iterator, bool> ShardedMap<K, T, L, N, A>::emplace(
+        const key_type& key,
+        Args&&... args) {
+        return m_shards[shardOf(key)].m_map.emplace(key, std::forward<Args>(args)...);
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    inline std::pair<typename Map<K, T, L, A>::iterator, bool> ShardedMap<K, T, L, N, A>::insert(
+        key_type key,
+        mapped_type value) {
+        return m_shards[shardOf(key)].m_map.insert(key, value);
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    inline typename ShardedMap<K, T, L, N, A>::size_type ShardedMap<K, T, L, N, A>::erase(key_type key) {
+        return m_shards[shardOf(key)].m_map.erase(key);
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    inline bool ShardedMap<K, T, L, N, A>::contains(const key_type& key) const {
+        return m_shards[shardOf(key)].m_map.contains(key);
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    inline T ShardedMap<K, T, L, N, A>::at(const key_type& key) const {
+        return m_shards[shardOf(key)].m_map.at(key);
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    template<class ForwardIt>
+    typename ShardedMap<K, T, L, N, A>::size_type ShardedMap<K, T, L, N, A>::insert_batch(ForwardIt first,
+                                                                                          ForwardIt last) {
+        std::array<std::vector<std::pair<const key_type&, const mapped_type&>>, N> batches;
+        for (; first != last; ++first) {
+            const auto& value = *first;
+            batches[shardOf(value.first)].emplace_back(value.first, value.second);
+        }
+
+        size_type count = 0;
+        for (size_type i = 0; i < N; ++i) {
+            if (!batches[i].empty())
+                count += m_shards[i].m_map.insert_range(batches[i].begin(), batches[i].end());
+        }
+
+        return count;
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    typename ShardedMap<K, T, L, N, A>::size_type ShardedMap<K, T, L, N, A>::erase_batch(
+        std::span<const key_type> keys) {
+        std::array<std::vector<key_type>, N> batches;
+        for (const key_type& key : keys) {
+            batches[shardOf(key)].push_back(key);
+        }
+
+        size_type count = 0;
+        for (size_type i = 0; i < N; ++i) {
+            if (!batches[i].empty())
+                count += m_shards[i].m_map.erase_range(batches[i].begin(), batches[i].end());
+        }
+
+        return count;
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    void ShardedMap<K, T, L, N, A>::clear() noexcept {
+        for (TShard& shard : m_shards) {
+            shard.m_map.clear();
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    typename ShardedMap<K, T, L, N, A>::size_type ShardedMap<K, T, L, N, A>::size() const noexcept {
+        size_type size = 0;
+        for (const TShard& shard : m_shards) {
+            size += shard.m_map.size();
+        }
+
+        return size;
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    template<size_t... Index>
+    inline std::array<typename Map<K, T, L, A>::iterator, N> ShardedMap<K, T, L, N, A>::begins(
+        std::index_sequence<Index...>) const {
+        return {m_shards[Index].m_map.begin()...};
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    template<size_t... Index>
+    inline std::array<typename Map<K, T, L, A>::iterator, N> ShardedMap<K, T, L, N, A>::ends(
+        std::index_sequence<Index...>) const {
+        return {m_shards[Index].m_map.end()...};
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    typename ShardedMap<K, T, L, N, A>::iterator ShardedMap<K, T, L, N, A>::begin() const {
+        return iterator(this, begins(std::make_index_sequence<N>()));
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    typename ShardedMap<K, T, L, N, A>::iterator ShardedMap<K, T, L, N, A>::end() const {
+        return iterator(this, ends(std::make_index_sequence<N>()));
+    }
+
+    //--------------------------------------------------------------//
+    template<class K, class T, class L, size_t N, class A>
+    void ShardedMap<K, T, L, N, A>::iterator::selectMin() {
+        // linear scan: N is small, full scans are rare
+        m_current = N;
+        for (size_type i = 0; i < N; ++i) {
+            if (m_owner->m_shards[i].m_map.end() == m_its[i])
+                continue;
+
+            if (N == m_current || (*m_its[i]).first < (*m_its[m_current]).first)
+                m_current = i;
+        }
+    }
+
+#pragma endregion ShardedMap
+
+}  // namespace Relax
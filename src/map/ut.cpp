@@ -5,9 +5,13 @@
 #include <fstream>
 #include <list>
 #include <map>
+#include <random>
+#include <shared_mutex>
 #include <thread>
 
 #include "map.h"
+#include "pool/thread_pool.h"
+#include "sharded_map.h"
 #include "test/test.h"
 #include "testgen.h"
 
@@ -46,6 +50,10 @@ namespace Test {
 
         void run_custom(const std::vector<TestCommand>& sample);
 
+        // readers see even keys all the time, one writer inserts and erases odd ones
+        template<class Lock>
+        static void testConcurrentLookup(uint32_t nthreads);
+
     private:
         static bool check(std::map<key_t, value_t>& origin,
                           map_t<key_t, value_t>& tested,
@@ -197,6 +205,44 @@ namespace Test {
         }
     }
 
+    //--------------------------------------------------------------//
+    template<class Lock>
+    void TestMap::testConcurrentLookup(uint32_t nthreads) {
+        constexpr key_t nkeys = 10000;
+        constexpr uint32_t nrounds = 20;
+
+        map_t<key_t, key_t, Lock> map;
+        for (key_t key = 0; key < nkeys; key += 2) {
+            map.emplace(key, key);
+        }
+
+        auto run_result = RunThreads(nthreads, [&map](uint32_t thread_id, uint32_t nthreads) -> bool {
+            (void)nthreads;
+            bool result = true;
+            for (uint32_t round = 0; round < nrounds; ++round) {
+                for (key_t key = 0; key < nkeys; key += 2) {
+                    if (0 == thread_id) {
+                        if (0 == round % 2)
+                            result &= map.emplace(key + 1, key + 1).second;
+                        else
+                            result &= (1 == map.erase(key + 1));
+                    }
+                    else {
+                        result &= map.contains(key) && (key == map.at(key));
+                    }
+                }
+            }
+
+            return result;
+        });
+
+        for (bool result : run_result.first) {
+            ASSERT_TRUE(result);
+        }
+        ASSERT_EQ(nkeys / 2, map.size());
+        ASSERT_TRUE(map.checkRB());
+    }
+
     //////////////////////////////////////////////////////////////////
     TEST_F(TestMap, brut_add_64) {
         constexpr uint32_t sample_size = 64;
@@ -373,4 +419,442 @@ namespace Test {
 
     //--------------------------------------------------------------//
 
+
+    //////////////////////////////////////////////////////////////////
+    // erased nodes are reused by arena, clear frees it
+    TEST_F(TestMap, arena_reuse) {
+        map_t<key_t, std::string> map;
+        for (key_t key = 0; key < 10000; ++key) {
+            ASSERT_TRUE(map.emplace(key, std::to_string(key)).second);
+        }
+        ASSERT_FALSE(map.emplace(7, "dup").second);
+
+        const uint64_t nallocs = Relax::ArenaStats().m_system_allocs.load();
+        for (key_t key = 0; key < 10000; key += 2) {
+            ASSERT_EQ(1u, map.erase(key));
+        }
+        for (key_t key = 0; key < 10000; key += 2) {
+            ASSERT_TRUE(map.insert(key, std::to_string(key)).second);
+        }
+        ASSERT_EQ(nallocs, Relax::ArenaStats().m_system_allocs.load());
+
+        key_t expected = 0;
+        for (auto [key, value] : map) {
+            ASSERT_EQ(expected, key);
+            ASSERT_EQ(std::to_string(expected++), value);
+        }
+        ASSERT_TRUE(map.checkRB());
+
+        map.clear();
+        ASSERT_EQ(0u, map.size());
+        ASSERT_TRUE(map.insert({1, "one"}).second);
+        ASSERT_EQ(1u, map.size());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMap, huge_pages) {
+        map_t<key_t, key_t, Relax::FakeLock, Relax::ArenaAllocator<key_t, Relax::THugePages>> map;
+        for (key_t key = 0; key < 100000; ++key) {
+            ASSERT_TRUE(map.emplace(key, key * 2).second);
+        }
+
+        key_t expected = 0;
+        for (auto [key, value] : map) {
+            ASSERT_EQ(expected, key);
+            ASSERT_EQ(2 * expected++, value);
+        }
+        ASSERT_EQ(100000u, expected);
+        ASSERT_TRUE(map.checkRB());
+
+        map.clear();
+        ASSERT_EQ(0u, map.size());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMap, find_contains_at) {
+        map_t<key_t, std::string> map;
+        for (key_t key = 0; key < 1000; key += 2) {
+            ASSERT_TRUE(map.emplace(key, std::to_string(key)).second);
+        }
+
+        for (key_t key = 0; key < 1000; ++key) {
+            const bool present = (0 == key % 2);
+            ASSERT_EQ(present, map.contains(key));
+            ASSERT_EQ(present, map.end() != map.find(key));
+            if (present) {
+                ASSERT_EQ(key, (*map.find(key)).first);
+                ASSERT_EQ(std::to_string(key), map.at(key));
+            }
+            else {
+                ASSERT_THROW(map.at(key), std::out_of_range);
+            }
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMap, bounds) {
+        map_t<key_t, key_t> map;
+        for (key_t key = 0; key < 1000; key += 10) {
+            ASSERT_TRUE(map.emplace(key, 2 * key).second);
+        }
+
+        for (key_t key = 0; key < 1010; ++key) {
+            const key_t lower = (key + 9) / 10 * 10;
+            const key_t upper = (key / 10 + 1) * 10;
+
+            if (lower < 1000)
+                ASSERT_EQ(lower, (*map.lower_bound(key)).first);
+            else
+                ASSERT_TRUE(map.end() == map.lower_bound(key));
+
+            if (upper < 1000)
+                ASSERT_EQ(upper, (*map.upper_bound(key)).first);
+            else
+                ASSERT_TRUE(map.end() == map.upper_bound(key));
+
+            const auto [first, last] = map.equal_range(key);
+            ASSERT_TRUE(first == map.lower_bound(key));
+            ASSERT_TRUE(last == map.upper_bound(key));
+            ASSERT_EQ(map.contains(key), first != last);
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMap, reverse_iteration) {
+        using node_t = map_t<key_t, key_t>::Node;
+
+        std::vector<node_t> nodes;
+        nodes.reserve(1000);
+        std::map<key_t, key_t> origin;
+        Relax::IntrusiveMap<node_t> tree;
+        ASSERT_TRUE(tree.rbegin() == tree.rend());
+
+        std::mt19937 random(1000);
+        for (uint32_t i = 0; i < 1000; ++i) {
+            const key_t key = random() % 5000;
+            nodes.emplace_back(key, key);
+            if (tree.insert(&nodes.back()).second)
+                origin.emplace(key, key);
+        }
+
+        auto origin_it = origin.rbegin();
+        for (auto it = tree.rbegin(); it != tree.rend(); ++it, ++origin_it) {
+            ASSERT_EQ(origin_it->first, it->m_key);
+        }
+        ASSERT_TRUE(origin.rend() == origin_it);
+
+        // -- is inverse of ++
+        auto it = tree.begin();
+        for (auto next = std::next(it); next != tree.end(); ++it, ++next) {
+            ASSERT_TRUE(it == std::prev(next));
+        }
+        ASSERT_EQ(origin.rbegin()->first, it->m_key);
+        ASSERT_EQ(origin.rbegin()->first, std::prev(tree.end())->m_key);
+
+        // std::reverse_iterator steps back from end()
+        origin_it = origin.rbegin();
+        using std_reverse_t = std::reverse_iterator<Relax::IntrusiveMap<node_t>::iterator>;
+        for (std_reverse_t it(tree.end()); it != std_reverse_t(tree.begin()); ++it, ++origin_it) {
+            ASSERT_EQ(origin_it->first, (*it)->m_key);
+        }
+        ASSERT_TRUE(origin.rend() == origin_it);
+
+        // base() is iterator of the next node, like std::reverse_iterator::base()
+        ASSERT_TRUE(tree.end() == tree.rbegin().base());
+        ASSERT_TRUE(tree.begin() == tree.rend().base());
+        ASSERT_EQ(origin.rbegin()->first, std::prev(tree.rbegin().base())->m_key);
+
+        tree.clear();
+
+        map_t<key_t, key_t> map;
+        for (const auto& [key, value] : origin) {
+            map.emplace(key, value);
+        }
+        ASSERT_EQ(origin.rbegin()->first, (*std::prev(map.end())).first);
+        ASSERT_EQ(std::next(origin.rbegin())->first, (*std::prev(map.end(), 2)).first);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMap, for_each_in_range) {
+        map_t<key_t, key_t> map;
+        std::map<key_t, key_t> origin;
+        std::mt19937 random(1000);
+        for (uint32_t i = 0; i < 1000; ++i) {
+            const key_t key = random() % 5000;
+            if (map.emplace(key, 2 * key).second)
+                origin.emplace(key, 2 * key);
+        }
+
+        for (const auto& [lo, hi] : {std::pair<key_t, key_t>(0, 5000), {100, 200}, {4999, 6000}, {300, 300}}) {
+            std::vector<std::pair<key_t, key_t>> visited;
+            map.for_each_in_range(lo, hi, [&visited](const key_t& key, const key_t& value) {
+                visited.emplace_back(key, value);
+            });
+
+            const std::vector<std::pair<key_t, key_t>> expected(origin.lower_bound(lo), origin.lower_bound(hi));
+            ASSERT_EQ(expected, visited);
+        }
+
+        // visitor exception releases lock
+        map_t<key_t, key_t, std::mutex> locked_map;
+        locked_map.emplace(1u, 1u);
+        ASSERT_THROW(locked_map.for_each_in_range(0, 10, [](const key_t&, const key_t&) { throw 1; }), int);
+        ASSERT_TRUE(locked_map.contains(1));
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMap, build_from_sorted) {
+        using node_t = map_t<key_t, key_t>::Node;
+
+        for (key_t n : {0u, 1u, 2u, 3u, 7u, 8u, 100u, 1000u, 4097u}) {
+            std::vector<node_t> nodes;
+            std::vector<node_t*> sorted;
+            nodes.reserve(n);
+            for (key_t key = 0; key < n; ++key) {
+                sorted.push_back(&nodes.emplace_back(2 * key, key));
+            }
+
+            Relax::IntrusiveMap<node_t> tree;
+            tree.build_from_sorted(sorted.begin(), sorted.end());
+            ASSERT_EQ(n, tree.size());
+            ASSERT_TRUE(tree.checkRB());
+
+            key_t expected = 0;
+            for (node_t* node : tree) {
+                ASSERT_EQ(2 * expected++, node->m_key);
+            }
+            ASSERT_EQ(n, expected);
+
+            // built tree is ordinary red-black tree for inserts and erases
+            node_t odd(1, 1);
+            ASSERT_TRUE(tree.insert(&odd).second);
+            ASSERT_TRUE(tree.checkRB());
+            for (key_t key = 0; key < n; key += 3) {
+                ASSERT_EQ(1u, tree.erase(2 * key));
+                ASSERT_TRUE(tree.checkRB());
+            }
+
+            tree.clear();
+        }
+
+        // sequential wrapper over input iterator, value with allocation
+        map_t<key_t, std::string> map;
+        std::list<std::pair<key_t, std::string>> values;
+        for (key_t key = 0; key < 1000; ++key) {
+            values.emplace_back(key, std::to_string(key));
+        }
+
+        map.build_from_sorted(values.begin(), values.end());
+        ASSERT_EQ(1000u, map.size());
+        ASSERT_TRUE(map.checkRB());
+        for (key_t key = 0; key < 1000; ++key) {
+            ASSERT_EQ(std::to_string(key), map.at(key));
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMap, MTBuildFromSorted_4) {
+        constexpr key_t n = 300000;
+
+        std::vector<std::pair<key_t, key_t>> values;
+        for (key_t key = 0; key < n; ++key) {
+            values.emplace_back(2 * key, key);
+        }
+
+        Relax::ThreadPool pool(4);
+        map_t<key_t, key_t, std::mutex> map;
+        map.build_from_sorted(values.begin(), values.end(), pool);
+
+        ASSERT_EQ(n, map.size());
+        ASSERT_TRUE(map.checkRB());
+
+        key_t expected = 0;
+        for (auto [key, value] : map) {
+            ASSERT_EQ(2 * expected, key);
+            ASSERT_EQ(expected++, value);
+        }
+        ASSERT_EQ(n, expected);
+
+        for (key_t key = 0; key < n; key += 7) {
+            ASSERT_EQ(1u, map.erase(2 * key));
+        }
+        ASSERT_TRUE(map.checkRB());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMap, MTSharedLookup_8) {
+        testConcurrentLookup<std::shared_mutex>(8);
+    }
+
+    //--------------------------------------------------------------//
+    // readers take no lock: erased nodes stay in arena, torn walks are repeated
+    TEST_F(TestMap, MTOptimisticLookup_8) {
+        testConcurrentLookup<Relax::TSeqLock<>>(8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMap, optimistic_clear) {
+        map_t<key_t, key_t, Relax::TSeqLock<>> map;
+        for (key_t key = 0; key < 1000; ++key) {
+            ASSERT_TRUE(map.emplace(key, key).second);
+        }
+
+        // nodes go to free lists of arena, not to the system
+        const uint64_t reserved = Relax::ArenaStats().m_reserved.load();
+        map.clear();
+        ASSERT_EQ(reserved, Relax::ArenaStats().m_reserved.load());
+        ASSERT_FALSE(map.contains(1));
+
+        for (key_t key = 0; key < 1000; ++key) {
+            ASSERT_TRUE(map.emplace(key, 2 * key).second);
+        }
+        ASSERT_EQ(reserved, Relax::ArenaStats().m_reserved.load());
+        ASSERT_EQ(20u, map.at(10));
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMap, std_allocator) {
+        map_t<key_t, std::string, Relax::FakeLock, std::allocator<std::string>> map;
+        for (key_t key = 0; key < 1000; ++key) {
+            ASSERT_TRUE(map.emplace(key, std::to_string(key)).second);
+        }
+        ASSERT_FALSE(map.insert(7, "dup").second);
+
+        for (key_t key = 0; key < 1000; key += 3) {
+            ASSERT_EQ(1u, map.erase(key));
+        }
+        ASSERT_EQ(0u, map.erase(0));
+        ASSERT_EQ(666u, map.size());
+        ASSERT_TRUE(map.checkRB());
+    }
+
+    //////////////////////////////////////////////////////////////////
+    class TestShardedMap : public ::testing::Test {
+    public:
+        using key_t = uint32_t;
+
+        template<class Lock = std::mutex>
+        using map_t = Relax::ShardedMap<key_t, key_t, Lock, 8>;
+
+    public:
+        TestShardedMap() { }
+
+        TestShardedMap(const TestShardedMap& other) = delete;
+        TestShardedMap(TestShardedMap&& other) noexcept = delete;
+        TestShardedMap& operator=(const TestShardedMap& other) = delete;
+        TestShardedMap& operator=(TestShardedMap&& other) noexcept = delete;
+
+        // merged iteration gives all keys in order
+        template<class Map>
+        static bool checkOrder(const Map& map, key_t step);
+    };
+
+    //--------------------------------------------------------------//
+    template<class Map>
+    bool TestShardedMap::checkOrder(const Map& map, key_t step) {
+        key_t expected = 0;
+        for (auto [key, value] : map) {
+            if (expected != key || 2 * expected != value)
+                return false;
+            expected += step;
+        }
+
+        return map.size() * step == expected;
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestShardedMap, OrderedIteration) {
+        map_t<Relax::FakeLock> map;
+        ASSERT_TRUE(map.begin() == map.end());
+
+        for (key_t key = 1000; 0 < key; --key) {
+            ASSERT_TRUE(map.emplace(key - 1, 2 * (key - 1)).second);
+        }
+        ASSERT_FALSE(map.insert(7, 0).second);
+
+        // keys are spread over all shards
+        std::array<size_t, map_t<>::m_nshards> nkeys = {};
+        for (key_t key = 0; key < 1000; ++key) {
+            ++nkeys[map_t<>::shardOf(key)];
+        }
+        for (size_t count : nkeys) {
+            ASSERT_LT(0u, count);
+        }
+
+        ASSERT_EQ(1000u, map.size());
+        ASSERT_TRUE(checkOrder(map, 1));
+        ASSERT_EQ(14u, map.at(7));
+        ASSERT_THROW(map.at(1000), std::out_of_range);
+
+        for (key_t key = 1; key < 1000; key += 2) {
+            ASSERT_EQ(1u, map.erase(key));
+        }
+        ASSERT_TRUE(checkOrder(map, 2));
+
+        map.clear();
+        ASSERT_EQ(0u, map.size());
+        ASSERT_TRUE(map.begin() == map.end());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestShardedMap, Batches) {
+        map_t<> map;
+        std::vector<std::pair<key_t, key_t>> values;
+        for (key_t key = 0; key < 1000; ++key) {
+            values.emplace_back(key, 2 * key);
+        }
+
+        ASSERT_EQ(1000u, map.insert_batch(values.begin(), values.end()));
+        ASSERT_EQ(0u, map.insert_batch(values.begin(), values.begin() + 10));
+        ASSERT_TRUE(checkOrder(map, 1));
+
+        std::vector<key_t> keys;
+        for (key_t key = 1; key < 1000; key += 2) {
+            keys.push_back(key);
+        }
+        keys.push_back(1001);
+
+        ASSERT_EQ(500u, map.erase_batch(keys));
+        ASSERT_EQ(0u, map.erase_batch(keys));
+        ASSERT_TRUE(checkOrder(map, 2));
+    }
+
+    //--------------------------------------------------------------//
+    // threads insert and erase disjoint keys: shards are locked independently
+    TEST_F(TestShardedMap, MTAddErase_8) {
+        constexpr uint32_t nthreads = 8;
+        constexpr key_t per_thread = 20000;
+
+        map_t<> map;
+        auto run_result = RunThreads(nthreads, [&map](uint32_t thread_id, uint32_t nthreads) -> bool {
+            bool result = true;
+            for (key_t i = 0; i < per_thread; ++i) {
+                const key_t key = i * nthreads + thread_id;
+                result &= map.emplace(key, 2 * key).second;
+            }
+
+            // odd keys of thread are erased by batch
+            std::vector<key_t> keys;
+            for (key_t i = 1; i < per_thread; i += 2) {
+                keys.push_back(i * nthreads + thread_id);
+            }
+            result &= (keys.size() == map.erase_batch(keys));
+
+            return result;
+        });
+
+        for (bool result : run_result.first) {
+            ASSERT_TRUE(result);
+        }
+
+        ASSERT_EQ(nthreads * per_thread / 2, map.size());
+        key_t expected = 0;
+        for (auto [key, value] : map) {
+            ASSERT_EQ(expected, key);
+            ASSERT_EQ(2 * key, value);
+            // next key of even i: skips odd i of all threads
+            expected += ((expected % nthreads) == nthreads - 1) ? nthreads + 1 : 1;
+        }
+    }
+
 }  // namespace Test
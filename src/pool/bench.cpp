@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include "test/test.h"
+#include "thread_pool.h"
+
+namespace Test {
+    //////////////////////////////////////////////////////////////////
+    class BenchThreadPool : public ::testing::Test {
+    public:
+        using value_t = uint64_t;
+
+        BenchThreadPool() { }
+
+        BenchThreadPool(const BenchThreadPool& other) = delete;
+        BenchThreadPool(BenchThreadPool&& other) noexcept = delete;
+        BenchThreadPool& operator=(const BenchThreadPool& other) = delete;
+        BenchThreadPool& operator=(BenchThreadPool&& other) noexcept = delete;
+
+        // mean and deviation of niterations runs of f
+        template<typename Callable>
+        static std::pair<Duration, Duration> benchSamples(uint32_t niterations, Callable&& f);
+
+        // round trips of empty task: submit, then get
+        static std::pair<Duration, Duration> benchPoolSpawn(uint32_t nthreads, uint64_t ntasks);
+
+        static std::pair<Duration, Duration> benchAsyncSpawn(uint64_t ntasks);
+
+        // nrounds of light work on each value, split between nthreads
+        static std::pair<Duration, Duration> benchPoolForkJoin(uint32_t nthreads,
+                                                               std::vector<value_t>& values,
+                                                               uint32_t nrounds);
+
+        // chunk per std::async thread, like RunThreads
+        static std::pair<Duration, Duration> benchAsyncForkJoin(uint32_t nthreads,
+                                                                std::vector<value_t>& values,
+                                                                uint32_t nrounds);
+
+        static void report(std::pair<Duration, Duration> lfstat, std::pair<Duration, Duration> std_stat);
+
+    public:
+        static constexpr uint32_t m_nspawns = 20000;
+
+        static constexpr uint32_t m_nvalues = 1 << 16;
+
+        static constexpr uint32_t m_nrounds = 200;
+
+        static constexpr uint32_t m_grain = 1024;
+
+        static constexpr uint32_t m_nsamples = 5;
+
+        static constexpr std::array<uint32_t, 4> m_nthread_modes = {1, 2, 8, 32};
+    };
+
+    //--------------------------------------------------------------//
+    template<typename Callable>
+    std::pair<Duration, Duration> BenchThreadPool::benchSamples(uint32_t niterations, Callable&& f) {
+        std::vector<Duration> samples;
+        for (uint32_t iter = 0; iter < niterations; ++iter) {
+            const Timestamp start = Timestamp::Now();
+            f();
+            samples.emplace_back(Timestamp::Now() - start);
+        }
+
+        uint64_t e = 0;
+        for (const auto& sample : samples) {
+            e += sample.Microseconds();
+        }
+        e /= samples.size();
+
+        return {Duration(e), (1 < niterations) ? Deviation(samples) : Duration()};
+    }
+
+    //--------------------------------------------------------------//
+    std::pair<Duration, Duration> BenchThreadPool::benchPoolSpawn(uint32_t nthreads, uint64_t ntasks) {
+        Relax::ThreadPool pool(nthreads);
+        return benchSamples(m_nsamples, [&] {
+            for (uint64_t i = 0; i < ntasks; ++i) {
+                pool.submit([i] { return i; }).get();
+            }
+        });
+    }
+
+    //--------------------------------------------------------------//
+    std::pair<Duration, Duration> BenchThreadPool::benchAsyncSpawn(uint64_t ntasks) {
+        return benchSamples(m_nsamples, [&] {
+            for (uint64_t i = 0; i < ntasks; ++i) {
+                std::async(std::launch::async, [i] { return i; }).get();
+            }
+        });
+    }
+
+    //--------------------------------------------------------------//
+    std::pair<Duration, Duration> BenchThreadPool::benchPoolForkJoin(uint32_t nthreads,
+                                                                     std::vector<value_t>& values,
+                                                                     uint32_t nrounds) {
+        Relax::ThreadPool pool(nthreads);
+        return benchSamples(m_nsamples, [&] {
+            for (uint32_t round = 0; round < nrounds; ++round) {
+                pool.parallel_for<size_t>(0, values.size(), m_grain, [&](size_t i) {
+                    values[i] = values[i] * 3 + 1;
+                });
+            }
+        });
+    }
+
+    //--------------------------------------------------------------//
+    std::pair<Duration, Duration> BenchThreadPool::benchAsyncForkJoin(uint32_t nthreads,
+                                                                      std::vector<value_t>& values,
+                                                                      uint32_t nrounds) {
+        return benchSamples(m_nsamples, [&] {
+            for (uint32_t round = 0; round < nrounds; ++round) {
+                RunThreads(nthreads, [&](uint32_t thread_id, uint32_t nthreads) -> int {
+                    const size_t per_thread = (values.size() + nthreads - 1) / nthreads;
+                    const size_t end = std::min(values.size(), (thread_id + 1) * per_thread);
+                    for (size_t i = thread_id * per_thread; i < end; ++i) {
+                        values[i] = values[i] * 3 + 1;
+                    }
+                    return 0;
+                });
+            }
+        });
+    }
+
+    //--------------------------------------------------------------//
+    void BenchThreadPool::report(std::pair<Duration, Duration> lfstat, std::pair<Duration, Duration> std_stat) {
+        std::cout << std::fixed << std::setprecision(2) << std::setw(6);
+        const auto width = std::setw(15);
+
+        const double lf_time_μs = (double)lfstat.first.Microseconds();
+        const double std_time_μs = (double)std_stat.first.Microseconds();
+        const double std_diff = ((std_time_μs / lf_time_μs) - 1) * 100;
+
+        std::cout << "Pool  time: " << width << lfstat.first.StrMilli() << "   dev: " << width
+                  << lfstat.second.StrMilli() << std::endl;
+        std::cout << "Async time: " << width << std_stat.first.StrMilli() << "   dev: " << width
+                  << std_stat.second.StrMilli() << width << " rel imp: " << (std_diff > 0 ? '+' : ' ')
+                  << std::setprecision(2) << std_diff << "%" << std::endl;
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(BenchThreadPool, spawn_latency) {
+        const auto std_stat = benchAsyncSpawn(m_nspawns);
+
+        for (uint32_t nthreads : m_nthread_modes) {
+            std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
+
+            auto lfstat = benchPoolSpawn(nthreads, m_nspawns);
+
+            report(lfstat, std_stat);
+            std::cout << "Pool round trip: " << (double)lfstat.first.Microseconds() * 1000 / m_nspawns << "ns"
+                      << std::endl;
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchThreadPool, fork_join) {
+        std::vector<value_t> values(m_nvalues);
+
+        for (uint32_t nthreads : m_nthread_modes) {
+            std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
+
+            auto lfstat = benchPoolForkJoin(nthreads, values, m_nrounds);
+            auto std_stat = benchAsyncForkJoin(nthreads, values, m_nrounds);
+
+            report(lfstat, std_stat);
+        }
+    }
+
+}  // namespace Test
@@ -0,0 +1,593 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "alloc/node_pool.h"
+#include "common.h"
+#include "deque/work_stealing_deque.h"
+#include "queue/intrusive_queue.h"
+#include "sync/event.h"
+#include "types.h"
+
+namespace Relax {
+
+    class ThreadPool;
+
+#pragma region TFuture
+
+    //////////////////////////////////////////////////////////////////
+    // Result of submitted task, shared by task and its future: destroyed by the last of them
+    template<class R>
+    class TFutureState {
+        friend class ThreadPool;
+
+        template<class U>
+        friend class TFuture;
+
+    public:
+        TFutureState() = default;
+
+        TFutureState(const TFutureState& other) = delete;
+        TFutureState(TFutureState&& other) noexcept = delete;
+        TFutureState& operator=(const TFutureState& other) = delete;
+        TFutureState& operator=(TFutureState&& other) noexcept = delete;
+
+    protected:
+        virtual ~TFutureState() = default;
+
+        // returns memory to pool
+        virtual void destroy() noexcept = 0;
+
+        void release() noexcept;
+
+    protected:
+        TEvent m_ready;
+
+        std::optional<std::conditional_t<std::is_void_v<R>, bool, R>> m_value;
+
+        std::exception_ptr m_exception;
+
+        std::atomic<int32_t> m_nrefs = 2;
+    };
+
+    //////////////////////////////////////////////////////////////////
+    // Move-only future of ThreadPool task
+    template<class R>
+    class TFuture {
+        friend class ThreadPool;
+
+    public:
+        TFuture() noexcept;
+        ~TFuture();
+
+        TFuture(const TFuture& other) = delete;
+        TFuture(TFuture&& other) noexcept;
+        TFuture& operator=(const TFuture& other) = delete;
+        TFuture& operator=(TFuture&& other) noexcept;
+
+        bool valid() const noexcept;
+
+        bool ready() const noexcept;
+
+        // worker of the pool runs other tasks while waiting
+        void wait();
+
+        // rethrows exception of task, future becomes invalid
+        R get();
+
+    private:
+        TFuture(ThreadPool* pool, TFutureState<R>* state) noexcept;
+
+        void reset() noexcept;
+
+    private:
+        ThreadPool* m_pool;
+
+        TFutureState<R>* m_state;
+    };
+
+    //--------------------------------------------------------------//
+    template<class R>
+    void TFutureState<R>::release() noexcept {
+        if (1 == m_nrefs.fetch_sub(1, std::memory_order_acq_rel))
+            destroy();
+    }
+
+#pragma endregion TFuture
+
+#pragma region ThreadPool
+
+    //////////////////////////////////////////////////////////////////
+    // Unit of ThreadPool work: node of injection queue, pointer in worker deques
+    struct TTask : TChainableBase<TTask> {
+        virtual ~TTask() = default;
+
+        // runs and destroys task
+        virtual void execute() noexcept = 0;
+    };
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Work-stealing thread pool.
+     *  * Tasks spawned by worker go to its WorkStealingDeque, by other threads - to injection queue
+     *  * Idle worker takes own deque (LIFO), then injection queue, then steals from others (FIFO)
+     *  * Worker without work spins briefly, then parks on TEventCount. Spawn wakes parked worker only if none
+     *    is spinning: spawn is syscall-free while workers are busy
+     *  * Tasks are allocated from ObjectPool: no allocations in steady state
+     *  * Worker waiting for future or parallel_for runs other tasks meanwhile
+     *  * Destructor runs all submitted tasks, then joins workers
+     */
+    class ThreadPool {
+        template<class R>
+        friend class TFuture;
+
+        struct Worker {
+            Worker(ThreadPool* pool, uint32_t index)
+              : m_deque()
+              , m_thread()
+              , m_pool(pool)
+              , m_random(index * 2654435761u | 1) { }
+
+            WorkStealingDeque<TTask*> m_deque;
+
+            std::thread m_thread;
+
+            ThreadPool* const m_pool;
+
+            // xorshift32 state of victim choice
+            uint32_t m_random;
+        };
+
+        //--------------------------------------------------------------//
+        template<class F, class R>
+        struct TFutureTask final : TTask, TFutureState<R> {
+            template<class Fn>
+            explicit TFutureTask(Fn&& f)
+              : m_f(std::forward<Fn>(f)) { }
+
+            void execute() noexcept override {
+                try {
+                    if constexpr (std::is_void_v<R>) {
+                        m_f();
+                        this->m_value.emplace(true);
+                    }
+                    else {
+                        this->m_value.emplace(m_f());
+                    }
+                }
+                catch (...) {
+                    this->m_exception = std::current_exception();
+                }
+
+                this->m_ready.set();
+                this->release();
+            }
+
+            void destroy() noexcept override { ObjectPool<TFutureTask>::destroy(this); }
+
+            F m_f;
+        };
+
+        //--------------------------------------------------------------//
+        // f must not throw
+        template<class F>
+        struct TDetachedTask final : TTask {
+            template<class Fn>
+            explicit TDetachedTask(Fn&& f)
+              : m_f(std::forward<Fn>(f)) { }
+
+            void execute() noexcept override {
+                m_f();
+                ObjectPool<TDetachedTask>::destroy(this);
+            }
+
+            F m_f;
+        };
+
+        //--------------------------------------------------------------//
+        // pending parts of parallel_for
+        struct TForkJoin {
+            // part is done
+            void finish() noexcept {
+                if (1 == m_npending.fetch_sub(1, std::memory_order_acq_rel))
+                    m_done.set();
+            }
+
+            // the first exception wins
+            void fail(std::exception_ptr exception) noexcept {
+                if (!m_failed.exchange(true, std::memory_order_relaxed))
+                    m_exception = std::move(exception);
+            }
+
+            TEvent m_done;
+
+            std::atomic<int64_t> m_npending = 1;
+
+            std::atomic<bool> m_failed = false;
+
+            std::exception_ptr m_exception;
+        };
+
+    public:
+        typedef size_t size_type;
+
+    public:
+        explicit ThreadPool(uint32_t nthreads = std::thread::hardware_concurrency());
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool& other) = delete;
+        ThreadPool(ThreadPool&& other) noexcept = delete;
+        ThreadPool& operator=(const ThreadPool& other) = delete;
+        ThreadPool& operator=(ThreadPool&& other) noexcept = delete;
+
+        size_type size() const noexcept;
+
+        template<class F>
+        TFuture<std::invoke_result_t<std::decay_t<F>&>> submit(F&& f);
+
+        // f(i) for i in [begin, end): range is halved down to grain, halves are stolen by idle workers
+        template<class Index, class F>
+        void parallel_for(Index begin, Index end, Index grain, F&& f);
+
+    private:
+        void stop() noexcept;
+
+        void spawn(TTask* task) noexcept;
+
+        void run(Worker& worker) noexcept;
+
+        // own deque, injection queue, other deques
+        TTask* findTask(Worker& worker) noexcept;
+
+        bool hasWork() const noexcept;
+
+        // worker of this pool runs tasks until event is set, other thread sleeps
+        void join(TEvent& event);
+
+        Worker* currentWorker() const noexcept;
+
+        template<class Index, class F>
+        void forkRange(TForkJoin& fork_join, Index begin, Index end, Index grain, F& f) noexcept;
+
+    private:
+        // findTask attempts before parking, yield between them: spinning worker gives way to busy ones
+        static constexpr uint32_t m_idle_spin_cnt = 64;
+
+    private:
+        std::vector<std::unique_ptr<Worker>> m_workers;
+
+        IntrusiveMutexFreeQueue<TTask> m_injection;
+
+        TEventCount m_idle;
+
+        // workers looking for task before parking: spawn doesn't wake others while any
+        alignas(CACHELINE_SIZE) std::atomic<uint32_t> m_nspinning;
+
+        alignas(CACHELINE_SIZE) std::atomic<bool> m_stop;
+
+        static inline thread_local Worker* m_current = nullptr;
+    };
+
+    //--------------------------------------------------------------//
+    inline ThreadPool::ThreadPool(uint32_t nthreads)
+      : m_workers()
+      , m_injection()
+      , m_idle()
+      , m_nspinning(0)
+      , m_stop(false) {
+        nthreads = std::max<uint32_t>(1, nthreads);
+        for (uint32_t i = 0; i < nthreads; ++i) {
+            m_workers.emplace_back(std::make_unique<Worker>(this, i));
+        }
+
+        try {
+            for (auto& worker : m_workers) {
+                worker->m_thread = std::thread([this, &worker = *worker] { run(worker); });
+            }
+        }
+        catch (...) {
+            stop();
+            throw;
+        }
+    }
+
+    //--------------------------------------------------------------//
+    inline ThreadPool::~ThreadPool() {
+        stop();
+    }
+
+    //--------------------------------------------------------------//
+    inline ThreadPool::size_type ThreadPool::size() const noexcept {
+        return m_workers.size();
+    }
+
+    //--------------------------------------------------------------//
+    template<class F>
+    TFuture<std::invoke_result_t<std::decay_t<F>&>> ThreadPool::submit(F&& f) {
+        typedef std::invoke_result_t<std::decay_t<F>&> result_type;
+        typedef TFutureTask<std::decay_t<F>, result_type> task_type;
+
+        task_type* const task = ObjectPool<task_type>::create(std::forward<F>(f));
+        spawn(task);
+
+        return TFuture<result_type>(this, task);
+    }
+
+    //--------------------------------------------------------------//
+    template<class Index, class F>
+    void ThreadPool::parallel_for(Index begin, Index end, Index grain, F&& f) {
+        if (!(begin < end))
+            return;
+
+        TForkJoin fork_join;
+        forkRange(fork_join, begin, end, std::max<Index>(grain, 1), f);
+        fork_join.finish();
+
+        join(fork_join.m_done);
+
+        if (fork_join.m_exception)
+            std::rethrow_exception(fork_join.m_exception);
+    }
+
+    //--------------------------------------------------------------//
+    template<class Index, class F>
+    void ThreadPool::forkRange(TForkJoin& fork_join, Index begin, Index end, Index grain, F& f) noexcept {
+        try {
+            // upper halves go to thieves, the lowest part is run here
+            while (grain < end - begin) {
+                const Index middle = begin + (end - begin) / 2;
+
+                auto part = [this, &fork_join, middle, end, grain, &f] {
+                    forkRange(fork_join, middle, end, grain, f);
+                    fork_join.finish();
+                };
+                TTask* const task = ObjectPool<TDetachedTask<decltype(part)>>::create(std::move(part));
+
+                fork_join.m_npending.fetch_add(1, std::memory_order_relaxed);
+                spawn(task);
+                end = middle;
+            }
+
+            for (Index i = begin; i < end; ++i) {
+                f(i);
+            }
+        }
+        catch (...) {
+            fork_join.fail(std::current_exception());
+        }
+    }
+
+    //--------------------------------------------------------------//
+    inline void ThreadPool::stop() noexcept {
+        m_stop.store(true, std::memory_order_seq_cst);
+        m_idle.notify(INT32_MAX);
+
+        for (auto& worker : m_workers) {
+            if (worker->m_thread.joinable())
+                worker->m_thread.join();
+        }
+    }
+
+    //--------------------------------------------------------------//
+    inline void ThreadPool::spawn(TTask* task) noexcept {
+        Worker* const worker = currentWorker();
+
+        bool pushed = false;
+        if (nullptr != worker) {
+            try {
+                worker->m_deque.push(task);
+                pushed = true;
+            }
+            catch (...) {
+                // deque can't grow: injection queue doesn't allocate
+            }
+        }
+
+        if (!pushed)
+            m_injection.push(task);
+
+        // push before check of spinning workers and waiters: parking worker either sees task or is woken
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (0 == m_nspinning.load(std::memory_order_seq_cst))
+            m_idle.notify(1);
+    }
+
+    //--------------------------------------------------------------//
+    inline void ThreadPool::run(Worker& worker) noexcept {
+        m_current = &worker;
+
+        while (true) {
+            TTask* task = findTask(worker);
+            if (nullptr == task) {
+                m_nspinning.fetch_add(1, std::memory_order_seq_cst);
+                for (uint32_t i = 0; nullptr == task && i < m_idle_spin_cnt; ++i) {
+                    std::this_thread::yield();
+                    task = findTask(worker);
+                }
+
+                // before check of work: spawn either sees spinning worker or the worker sees task
+                const uint32_t nspinning = m_nspinning.fetch_sub(1, std::memory_order_seq_cst);
+
+                // the last spinning worker took task: spawns it has seen may be left for parked ones
+                if (nullptr != task && 1 == nspinning && hasWork())
+                    m_idle.notify(1);
+            }
+
+            if (nullptr != task) {
+                task->execute();
+                continue;
+            }
+
+            const int32_t key = m_idle.prepareWait();
+            if (hasWork()) {
+                m_idle.cancelWait();
+                continue;
+            }
+
+            if (m_stop.load(std::memory_order_seq_cst)) {
+                m_idle.cancelWait();
+                break;
+            }
+
+            m_idle.commitWait(key);
+        }
+
+        m_current = nullptr;
+    }
+
+    //--------------------------------------------------------------//
+    inline TTask* ThreadPool::findTask(Worker& worker) noexcept {
+        TTask* task = nullptr;
+        if (worker.m_deque.pop(task))
+            return task;
+
+        task = m_injection.pop();
+        if (nullptr != task)
+            return task;
+
+        worker.m_random ^= worker.m_random << 13;
+        worker.m_random ^= worker.m_random >> 17;
+        worker.m_random ^= worker.m_random << 5;
+
+        const size_t nworkers = m_workers.size();
+        const size_t start = worker.m_random % nworkers;
+        for (size_t i = 0; i < nworkers; ++i) {
+            Worker& victim = *m_workers[(start + i) % nworkers];
+            if (&victim != &worker && victim.m_deque.steal(task))
+                return task;
+        }
+
+        return nullptr;
+    }
+
+    //--------------------------------------------------------------//
+    inline bool ThreadPool::hasWork() const noexcept {
+        if (!m_injection.empty())
+            return true;
+
+        for (const auto& worker : m_workers) {
+            if (!worker->m_deque.empty())
+                return true;
+        }
+
+        return false;
+    }
+
+    //--------------------------------------------------------------//
+    inline void ThreadPool::join(TEvent& event) {
+        Worker* const worker = currentWorker();
+        if (nullptr == worker) {
+            event.wait();
+            return;
+        }
+
+        while (!event.is_set()) {
+            TTask* const task = findTask(*worker);
+            if (nullptr != task)
+                task->execute();
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    //--------------------------------------------------------------//
+    inline ThreadPool::Worker* ThreadPool::currentWorker() const noexcept {
+        Worker* const worker = m_current;
+        return (nullptr != worker && this == worker->m_pool) ? worker : nullptr;
+    }
+
+#pragma endregion ThreadPool
+
+#pragma region TFuture
+
+    //--------------------------------------------------------------//
+    template<class R>
+    TFuture<R>::TFuture() noexcept
+      : m_pool(nullptr)
+      , m_state(nullptr) { }
+
+    //--------------------------------------------------------------//
+    template<class R>
+    TFuture<R>::TFuture(ThreadPool* pool, TFutureState<R>* state) noexcept
+      : m_pool(pool)
+      , m_state(state) { }
+
+    //--------------------------------------------------------------//
+    template<class R>
+    TFuture<R>::~TFuture() {
+        reset();
+    }
+
+    //--------------------------------------------------------------//
+    template<class R>
+    TFuture<R>::TFuture(TFuture&& other) noexcept
+      : m_pool(std::exchange(other.m_pool, nullptr))
+      , m_state(std::exchange(other.m_state, nullptr)) { }
+
+    //--------------------------------------------------------------//
+    template<class R>
+    TFuture<R>& TFuture<R>::operator=(TFuture&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_pool = std::exchange(other.m_pool, nullptr);
+            m_state = std::exchange(other.m_state, nullptr);
+        }
+
+        return *this;
+    }
+
+    //--------------------------------------------------------------//
+    template<class R>
+    inline bool TFuture<R>::valid() const noexcept {
+        return nullptr != m_state;
+    }
+
+    //--------------------------------------------------------------//
+    template<class R>
+    inline bool TFuture<R>::ready() const noexcept {
+        return m_state->m_ready.is_set();
+    }
+
+    //--------------------------------------------------------------//
+    template<class R>
+    void TFuture<R>::wait() {
+        m_pool->join(m_state->m_ready);
+    }
+
+    //--------------------------------------------------------------//
+    template<class R>
+    R TFuture<R>::get() {
+        wait();
+
+        // state is released on any exit
+        std::unique_ptr<TFuture, void (*)(TFuture*)> guard(this, [](TFuture* future) { future->reset(); });
+
+        if (m_state->m_exception)
+            std::rethrow_exception(m_state->m_exception);
+
+        if constexpr (!std::is_void_v<R>)
+            return std::move(*m_state->m_value);
+    }
+
+    //--------------------------------------------------------------//
+    template<class R>
+    void TFuture<R>::reset() noexcept {
+        if (nullptr == m_state)
+            return;
+
+        m_state->release();
+        m_pool = nullptr;
+        m_state = nullptr;
+    }
+
+#pragma endregion TFuture
+
+}  // namespace Relax
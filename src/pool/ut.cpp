@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <numeric>
+
+#include "test/test.h"
+#include "thread_pool.h"
+
+namespace Test {
+    //////////////////////////////////////////////////////////////////
+    class TestThreadPool : public ::testing::Test {
+    public:
+        using value_t = uint64_t;
+
+        TestThreadPool() { }
+
+        TestThreadPool(const TestThreadPool& other) = delete;
+        TestThreadPool(TestThreadPool&& other) noexcept = delete;
+        TestThreadPool& operator=(const TestThreadPool& other) = delete;
+        TestThreadPool& operator=(TestThreadPool&& other) noexcept = delete;
+
+        // each task waits for futures of two subtasks: workers must run tasks while waiting
+        static value_t fib(Relax::ThreadPool& pool, value_t n);
+
+        // every index is visited exactly once
+        void testParallelFor(uint32_t nthreads, value_t size, value_t grain);
+    };
+
+    //--------------------------------------------------------------//
+    TestThreadPool::value_t TestThreadPool::fib(Relax::ThreadPool& pool, value_t n) {
+        if (n < 2)
+            return n;
+
+        auto left = pool.submit([&pool, n] { return fib(pool, n - 1); });
+        auto right = pool.submit([&pool, n] { return fib(pool, n - 2); });
+        return left.get() + right.get();
+    }
+
+    //--------------------------------------------------------------//
+    void TestThreadPool::testParallelFor(uint32_t nthreads, value_t size, value_t grain) {
+        Relax::ThreadPool pool(nthreads);
+        std::vector<std::atomic<uint32_t>> visits(size);
+
+        pool.parallel_for<value_t>(0, size, grain, [&](value_t i) {
+            visits[i].fetch_add(1, std::memory_order_relaxed);
+        });
+
+        for (value_t i = 0; i < size; ++i) {
+            ASSERT_EQ(1u, visits[i].load(std::memory_order_relaxed));
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestThreadPool, SubmitGet) {
+        Relax::ThreadPool pool(2);
+        ASSERT_EQ(2u, pool.size());
+
+        auto value = pool.submit([] { return 42; });
+        ASSERT_TRUE(value.valid());
+        ASSERT_EQ(42, value.get());
+        ASSERT_FALSE(value.valid());
+
+        std::atomic<bool> called = false;
+        auto done = pool.submit([&] { called = true; });
+        done.wait();
+        ASSERT_TRUE(done.ready());
+        done.get();
+        ASSERT_TRUE(called);
+
+        auto move_only = pool.submit([] { return std::make_unique<std::string>("moved"); });
+        ASSERT_EQ("moved", *move_only.get());
+
+        auto failed = pool.submit([]() -> int { throw std::runtime_error("task"); });
+        ASSERT_THROW(failed.get(), std::runtime_error);
+        ASSERT_FALSE(failed.valid());
+
+        // dropped future: task still runs
+        pool.submit([] { return std::string("dropped"); });
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestThreadPool, NestedWait) {
+        Relax::ThreadPool pool(2);
+        ASSERT_EQ(6765u, fib(pool, 20));
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestThreadPool, DestructorRunsTasks) {
+        std::atomic<uint32_t> count = 0;
+        {
+            Relax::ThreadPool pool(4);
+            for (uint32_t i = 0; i < 10000; ++i) {
+                pool.submit([&] { count.fetch_add(1, std::memory_order_relaxed); });
+            }
+        }
+
+        ASSERT_EQ(10000u, count.load());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestThreadPool, MTSubmitters_8) {
+        static constexpr uint32_t nsubmitters = 8;
+        static constexpr uint32_t ntasks = 20000;
+        Relax::ThreadPool pool(4);
+
+        auto run_result = RunThreads(nsubmitters, [&](uint32_t thread_id, uint32_t nthreads) -> value_t {
+            (void)nthreads;
+            std::vector<Relax::TFuture<value_t>> futures;
+            for (uint32_t i = 0; i < ntasks; ++i) {
+                futures.emplace_back(pool.submit([thread_id, i] { return (value_t)thread_id * ntasks + i; }));
+            }
+
+            value_t sum = 0;
+            for (auto& future : futures) {
+                sum += future.get();
+            }
+            return sum;
+        });
+
+        const value_t total = std::accumulate(run_result.first.begin(), run_result.first.end(), (value_t)0);
+        const value_t n = nsubmitters * ntasks;
+        ASSERT_EQ(n * (n - 1) / 2, total);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestThreadPool, ParallelFor) {
+        testParallelFor(1, 1000, 1);
+        testParallelFor(4, 1, 16);
+        testParallelFor(4, 100000, 1);
+        testParallelFor(8, 1000003, 1000);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestThreadPool, ParallelForNested) {
+        Relax::ThreadPool pool(4);
+        std::atomic<value_t> sum = 0;
+
+        pool.parallel_for<value_t>(0, 100, 1, [&](value_t i) {
+            pool.parallel_for<value_t>(0, 100, 8, [&](value_t j) {
+                sum.fetch_add(i * 100 + j, std::memory_order_relaxed);
+            });
+        });
+
+        ASSERT_EQ(10000u * 9999u / 2, sum.load());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestThreadPool, ParallelForThrows) {
+        Relax::ThreadPool pool(4);
+        std::atomic<uint32_t> count = 0;
+
+        ASSERT_THROW(pool.parallel_for<uint32_t>(0, 10000, 10,
+                                                 [&](uint32_t i) {
+                                                     count.fetch_add(1, std::memory_order_relaxed);
+                                                     if (5000 == i)
+                                                         throw std::runtime_error("index");
+                                                 }),
+                     std::runtime_error);
+
+        // pool is usable after failure
+        ASSERT_EQ(7, pool.submit([] { return 7; }).get());
+    }
+
+}  // namespace Test
@@ -2,7 +2,11 @@
 
 #include <queue>
 
+#include "bounded_queue.h"
 #include "queue.h"
+#include "segmented_queue.h"
+#include "sharded_queue.h"
+#include "spsc_queue.h"
 #include "test/test.h"
 
 namespace Test {
@@ -22,6 +26,9 @@ namespace Test {
     public:
         typedef T value_type;
 
+        // allocations of all instances, counted under lock
+        static uint64_t nallocs() { return m_nallocs.load(std::memory_order_relaxed); }
+
         SillyMutexQueue()
           : m_head(nullptr)
           , m_tail(nullptr)
@@ -32,6 +39,7 @@ namespace Test {
         void push(Args&&... args) {
             Node* node = new Node(std::forward<Args>(args)...);
             std::unique_lock<std::mutex> g(m_mutex);
+            m_nallocs.store(m_nallocs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
             Node* old_tail = m_tail;
             m_tail = node;
             if (nullptr == old_tail) {
@@ -42,6 +50,36 @@ namespace Test {
             }
         }
 
+        template<class InputIt>
+        void push_range(InputIt begin, InputIt end) {
+            Node* first = nullptr;
+            Node* last = nullptr;
+            uint64_t count = 0;
+            for (; begin != end; ++begin) {
+                Node* node = new Node(*begin);
+                if (nullptr == last)
+                    first = node;
+                else
+                    last->m_next = node;
+                last = node;
+                ++count;
+            }
+
+            if (nullptr == first)
+                return;
+
+            std::unique_lock<std::mutex> g(m_mutex);
+            m_nallocs.store(m_nallocs.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+            Node* old_tail = m_tail;
+            m_tail = last;
+            if (nullptr == old_tail) {
+                m_head = first;
+            }
+            else {
+                old_tail->m_next = first;
+            }
+        }
+
         bool pop(T& ref) {
             std::unique_lock<std::mutex> g(m_mutex);
             if (nullptr == m_head)
@@ -71,8 +109,43 @@ namespace Test {
         Node* m_tail;
 
         std::mutex m_mutex;
+
+        static inline std::atomic<uint64_t> m_nallocs = 0;
     };
 
+    //////////////////////////////////////////////////////////////////
+    // system allocations made by queues of type T: counted node allocations or pool chunks and magazines.
+    // Pool counters are global: one queue is benched at a time, so they see only its node pool
+    template<class T>
+    uint64_t NAllocs() {
+        if constexpr (requires { T::nallocs(); })
+            return T::nallocs();
+        else if constexpr (requires { T::allocator_type::nallocs(); })
+            return T::allocator_type::nallocs();
+        else
+            return Relax::NodePoolStats().m_system_allocs.load(std::memory_order_relaxed) +
+                   Relax::NodePoolStats().m_magazine_allocs.load(std::memory_order_relaxed);
+    }
+
+    //--------------------------------------------------------------//
+    // returns bench result and system allocations per queue operation
+    template<class T, typename Callable>
+    std::pair<std::pair<Duration, Duration>, double> BenchAllocs(uint64_t nops, Callable&& bench) {
+        const uint64_t start = NAllocs<T>();
+        const auto stat = bench();
+        return {stat, (double)(NAllocs<T>() - start) / nops};
+    }
+
+    //--------------------------------------------------------------//
+    // returns bench result and peak number of retired, not reclaimed nodes of domain during it
+    template<typename Callable>
+    std::pair<std::pair<Duration, Duration>, uint64_t> BenchReclaim(Relax::TReclaimStats& stats, Callable&& bench) {
+        stats.m_peak_unreclaimed.store(stats.m_unreclaimed.load(std::memory_order_relaxed),
+                                       std::memory_order_relaxed);
+        const auto stat = bench();
+        return {stat, stats.m_peak_unreclaimed.load(std::memory_order_relaxed)};
+    }
+
     //////////////////////////////////////////////////////////////////
     template<class T, class PushType = typename T::value_type>
     std::pair<Duration, Duration> BenchQueueSeqPush(uint64_t sample_size, uint32_t nthreads, uint32_t niterations) {
@@ -106,6 +179,71 @@ namespace Test {
             sample_size);
     }
 
+    //--------------------------------------------------------------//
+    // intrusive queues get linked chain, others - range of values
+    template<class T, class PushType>
+    inline void PushBatch(T& queue, std::vector<PushType>& batch) {
+        if (batch.empty())
+            return;
+
+        if constexpr (requires { queue.push_chain(batch.front(), batch.back(), batch.size()); }) {
+            for (size_t i = 1; i < batch.size(); ++i) {
+                batch[i - 1]->m_next = batch[i];
+            }
+            queue.push_chain(batch.front(), batch.back(), batch.size());
+        }
+        else {
+            queue.push_range(batch.begin(), batch.end());
+        }
+
+        batch.clear();
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class PushType = typename T::value_type>
+    std::pair<Duration, Duration> BenchQueueSeqPushBatch(uint64_t sample_size,
+                                                         uint32_t nthreads,
+                                                         uint32_t batch_size,
+                                                         uint32_t niterations) {
+        std::vector<std::remove_pointer_t<PushType>> prealloced;
+        if constexpr (std::is_pointer_v<PushType>) {
+            prealloced.resize(sample_size);
+        }
+
+        return BenchThreads<T>(
+            nthreads,
+            niterations,
+            [&prealloced](uint32_t thread_id, uint32_t nthreads, T& queue, uint32_t sample_size, uint32_t batch_size)
+                -> int {
+                (void)prealloced;
+                const uint32_t per_thread = sample_size / nthreads;
+
+                const uint32_t start = thread_id * per_thread;
+                const uint32_t end = start + per_thread;
+                Generator<uint32_t> g(start, 1, end);
+
+                std::vector<PushType> batch;
+                batch.reserve(batch_size);
+
+                while (!g.empty()) {
+                    if constexpr (std::is_pointer_v<PushType>) {
+                        batch.emplace_back(&(prealloced[g.get()]));
+                    }
+                    else {
+                        batch.emplace_back(g.get());
+                    }
+
+                    if (batch_size == batch.size())
+                        PushBatch(queue, batch);
+                }
+                PushBatch(queue, batch);
+
+                return 0;
+            },
+            sample_size,
+            batch_size);
+    }
+
     //--------------------------------------------------------------//
     template<class T, class PushType = typename T::value_type>
     std::pair<Duration, Duration> BenchQueueSeqPushPop(uint64_t sample_size,
@@ -146,7 +284,8 @@ namespace Test {
     }
 
     //--------------------------------------------------------------//
-    template<class T, class PushType = typename T::value_type>
+    // PopAll: drain each section by pop_all instead of per-element pop loop
+    template<class T, class PushType = typename T::value_type, bool PopAll = false>
     std::pair<Duration, Duration> BenchQueueSectioned(uint64_t sample_size,
                                                       uint32_t nthreads,
                                                       uint32_t nsections,
@@ -179,6 +318,112 @@ namespace Test {
                         }
                     }
 
+                    if constexpr (PopAll) {
+                        auto chain = queue.pop_all();
+                        while (chain.pop_front())
+                            ;
+                    }
+                    else {
+                        PushType ret;
+                        while (queue.pop(ret))
+                            ;
+                    }
+                }
+
+                return 0;
+            },
+            sample_size,
+            nsections);
+    }
+
+    //--------------------------------------------------------------//
+    // drains each section by pop_bulk into buffer of bulk_size values
+    template<class T>
+    std::pair<Duration, Duration> BenchQueueSectionedBulk(uint64_t sample_size,
+                                                          uint32_t nthreads,
+                                                          uint32_t nsections,
+                                                          uint32_t bulk_size,
+                                                          uint32_t niterations) {
+        return BenchThreads<T>(
+            nthreads,
+            niterations,
+            [](uint32_t thread_id,
+               uint32_t nthreads,
+               T& queue,
+               uint32_t sample_size,
+               uint32_t nsections,
+               uint32_t bulk_size) -> int {
+                const uint32_t per_thread = sample_size / nthreads;
+                const uint32_t per_section = per_thread / nsections;
+
+                const uint32_t start = thread_id * per_thread;
+                const uint32_t end = start + per_thread;
+                Generator<uint32_t> g(start, 1, end);
+
+                std::vector<typename T::value_type> bulk(bulk_size);
+
+                for (uint32_t section = 0; section < nsections; ++section) {
+                    for (uint32_t i = 0; i < per_section; ++i) {
+                        queue.push(g.get());
+                    }
+
+                    while (0 != queue.pop_bulk(bulk))
+                        ;
+                }
+
+                return 0;
+            },
+            sample_size,
+            nsections,
+            bulk_size);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class PushType = typename T::value_type>
+    std::pair<Duration, Duration> BenchQueueSectionedBatch(uint64_t sample_size,
+                                                           uint32_t nthreads,
+                                                           uint32_t nsections,
+                                                           uint32_t batch_size,
+                                                           uint32_t niterations) {
+        std::vector<std::remove_pointer_t<PushType>> prealloced;
+        if constexpr (std::is_pointer_v<PushType>) {
+            prealloced.resize(sample_size);
+        }
+
+        return BenchThreads<T>(
+            nthreads,
+            niterations,
+            [&prealloced](uint32_t thread_id,
+                          uint32_t nthreads,
+                          T& queue,
+                          uint32_t sample_size,
+                          uint32_t nsections,
+                          uint32_t batch_size) -> int {
+                (void)prealloced;
+                const uint32_t per_thread = sample_size / nthreads;
+                const uint32_t per_section = per_thread / nsections;
+
+                const uint32_t start = thread_id * per_thread;
+                const uint32_t end = start + per_thread;
+                Generator<uint32_t> g(start, 1, end);
+
+                std::vector<PushType> batch;
+                batch.reserve(batch_size);
+
+                for (uint32_t section = 0; section < nsections; ++section) {
+                    for (uint32_t i = 0; i < per_section; ++i) {
+                        if constexpr (std::is_pointer_v<PushType>) {
+                            batch.emplace_back(&(prealloced[g.get()]));
+                        }
+                        else {
+                            batch.emplace_back(g.get());
+                        }
+
+                        if (batch_size == batch.size())
+                            PushBatch(queue, batch);
+                    }
+                    PushBatch(queue, batch);
+
                     PushType ret;
                     while (queue.pop(ret))
                         ;
@@ -187,7 +432,8 @@ namespace Test {
                 return 0;
             },
             sample_size,
-            nsections);
+            nsections,
+            batch_size);
     }
 
     //--------------------------------------------------------------//
@@ -236,8 +482,164 @@ namespace Test {
             sample_size);
     }
 
+    //--------------------------------------------------------------//
+    template<class T, class PushType = typename T::value_type>
+    std::pair<Duration, Duration> BenchQueueProducersConsumers(uint64_t sample_size,
+                                                               uint32_t nproducers,
+                                                               uint32_t nconsumers,
+                                                               uint32_t niterations) {
+        std::vector<std::remove_pointer_t<PushType>> prealloced;
+        if constexpr (std::is_pointer_v<PushType>) {
+            prealloced.resize(sample_size);
+        }
+
+        return BenchThreads<T>(
+            nproducers + nconsumers,
+            niterations,
+            [&prealloced](uint32_t thread_id,
+                          uint32_t nthreads,
+                          T& queue,
+                          uint32_t sample_size,
+                          uint32_t nproducers) -> int {
+                (void)prealloced;
+                const uint32_t nconsumers = nthreads - nproducers;
+
+                if (thread_id < nproducers) {
+                    const uint32_t per_thread = sample_size / nproducers;
+                    const uint32_t start = thread_id * per_thread;
+                    const uint32_t end = start + per_thread;
+                    Generator<uint32_t> g(start, 1, end);
+
+                    while (!g.empty()) {
+                        if constexpr (std::is_pointer_v<PushType>) {
+                            queue.push(&(prealloced[g.get()]));
+                        }
+                        else {
+                            queue.push(g.get());
+                        }
+                    }
+                }
+                else {
+                    const uint32_t consumer_id = thread_id - nproducers;
+                    const uint32_t per_thread = sample_size / nconsumers;
+                    const uint32_t npops = per_thread + ((0 == consumer_id) ? (sample_size % nconsumers) : 0);
+
+                    PushType value;
+                    for (uint32_t i = 0; i < npops; ++i) {
+                        while (!queue.pop(value)) {
+                            std::this_thread::yield();
+                        }
+                    }
+                }
+
+                return 0;
+            },
+            sample_size,
+            nproducers);
+    }
+
+    //--------------------------------------------------------------//
+    // CPU time consumed by calling thread
+    inline Duration ThreadCpuTime() {
+#if WIN
+        FILETIME creation, exit, kernel, user;
+        GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+        const uint64_t ticks = ((uint64_t)kernel.dwHighDateTime << 32 | kernel.dwLowDateTime) +
+                               ((uint64_t)user.dwHighDateTime << 32 | user.dwLowDateTime);
+        return Duration(ticks / 10);
+#else
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return Duration((uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000);
+#endif
+    }
+
+    //--------------------------------------------------------------//
+    // consumers wait on empty queue for idle time: returns CPU time of consumers
+    template<class T, bool Wait>
+    Duration BenchQueueIdle(uint32_t nconsumers, std::chrono::milliseconds idle) {
+        T queue;
+
+        auto consume = [&queue, idle](uint32_t thread_id, uint32_t nthreads) -> Duration {
+            if (0 == thread_id) {
+                std::this_thread::sleep_for(idle);
+                for (uint32_t i = 1; i < nthreads; ++i) {
+                    queue.push(i);
+                }
+
+                return Duration();
+            }
+
+            const Duration start = ThreadCpuTime();
+
+            typename T::value_type value;
+            if constexpr (Wait) {
+                queue.pop_wait(value);
+            }
+            else {
+                while (!queue.pop(value)) {
+                    std::this_thread::yield();
+                }
+            }
+
+            return Duration(ThreadCpuTime().Microseconds() - start.Microseconds());
+        };
+
+        auto run_result = RunThreads(nconsumers + 1, consume);
+
+        Duration cpu;
+        for (const Duration& thread_cpu : run_result.first) {
+            cpu += thread_cpu;
+        }
+
+        return cpu;
+    }
+
+    //--------------------------------------------------------------//
+    // producer pushes push time after pause, consumer measures delivery: returns mean latency in ns
+    template<class T, bool Wait>
+    double BenchQueueWakeLatency(uint32_t nwakes, std::chrono::microseconds pause) {
+        T queue;
+
+        auto now_ns = [] {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        };
+
+        auto run_result = RunThreads(2, [&](uint32_t thread_id, uint32_t nthreads) -> uint64_t {
+            (void)nthreads;
+            uint64_t total_ns = 0;
+
+            if (0 == thread_id) {
+                for (uint32_t i = 0; i < nwakes; ++i) {
+                    std::this_thread::sleep_for(pause);
+                    queue.push(now_ns());
+                }
+            }
+            else {
+                typename T::value_type value;
+                for (uint32_t i = 0; i < nwakes; ++i) {
+                    if constexpr (Wait) {
+                        queue.pop_wait(value);
+                    }
+                    else {
+                        while (!queue.pop(value)) {
+                            std::this_thread::yield();
+                        }
+                    }
+                    total_ns += now_ns() - value;
+                }
+            }
+
+            return total_ns;
+        });
+
+        return (double)run_result.first[1] / nwakes;
+    }
+
     //////////////////////////////////////////////////////////////////
-    void ReportSingle(Duration lftime, Duration std_time) {
+    void ReportSingle(Duration lftime, Duration std_time, const char* lf_name = "MF") {
         std::cout << std::fixed << std::setprecision(2) << std::setw(6);
         const auto width = std::setw(9);
 
@@ -245,14 +647,18 @@ namespace Test {
         const double std_time_μs = (double)std_time.Microseconds();
         const double std_diff = ((std_time_μs / lf_time_μs) - 1) * 100;
 
-        std::cout << "MF time:         " << width << lftime.StrMilli() << std::endl;
+        std::cout << std::left << std::setw(17) << (std::string(lf_name) + " time: ") << std::right << width
+                  << lftime.StrMilli() << std::endl;
         std::cout << "std::queue time: " << width << std_time.StrMilli() << width
                   << " rel imp: " << (std_diff > 0 ? '+' : ' ') << std::setprecision(2) << std_diff << "%"
                   << std::endl;
     }
 
     //--------------------------------------------------------------//
-    void Report(std::pair<Duration, Duration> lfstat, std::pair<Duration, Duration> std_stat) {
+    void Report(std::pair<Duration, Duration> lfstat,
+                std::pair<Duration, Duration> std_stat,
+                const char* lf_name = "MF",
+                const char* std_name = "Mutex") {
         std::cout << std::fixed << std::setprecision(2) << std::setw(6);
         const auto width = std::setw(15);
 
@@ -265,18 +671,83 @@ namespace Test {
         const double std_time_μs = (double)std_stat.first.Microseconds();
         const double std_diff = ((std_time_μs / lf_time_μs) - 1) * 100;
 
-        std::cout << "MF time:      " << width << lftime.StrMilli() << "   dev: " << width << lfvar.StrMilli()
-                  << std::endl;
-        std::cout << "Mutex time:   " << width << std_time.StrMilli() << "   dev: " << width << std_var.StrMilli()
+        std::cout << std::left << std::setw(8) << lf_name << std::right << "time: " << width << lftime.StrMilli()
+                  << "   dev: " << width << lfvar.StrMilli() << std::endl;
+        std::cout << std::left << std::setw(8) << std_name << std::right << "time: " << width << std_time.StrMilli()
+                  << "   dev: " << width << std_var.StrMilli()
                   << width << " rel imp: " << (std_diff > 0 ? '+' : ' ') << std::setprecision(2) << std_diff << "%"
                   << std::endl;
     }
 
+    //--------------------------------------------------------------//
+    void ReportAllocs(double lf_allocs, double std_allocs, double new_allocs) {
+        std::cout << std::fixed << std::setprecision(4);
+        const auto width = std::setw(15);
+
+        std::cout << "Allocs/op MF: " << width << lf_allocs << "   Mutex: " << width << std_allocs
+                  << "   MF+new: " << width << new_allocs << std::endl;
+    }
+
+    //--------------------------------------------------------------//
+    // time - time with reclaimed nodes, base_time - the same queue with type-stable nodes
+    void ReportReclaim(Duration time, Duration base_time, uint64_t nops, uint64_t peak_nodes, size_t node_size) {
+        std::cout << std::fixed << std::setprecision(2);
+        const auto width = std::setw(15);
+
+        const double overhead_μs = (double)time.Microseconds() - (double)base_time.Microseconds();
+        const double overhead_ns = overhead_μs * 1000 / nops;
+
+        std::cout << "Reclaim ns/op: " << width << overhead_ns << "   peak unreclaimed: " << width << peak_nodes
+                  << " nodes, " << (double)(peak_nodes * node_size) / 1024 << " KiB" << std::endl;
+    }
+
     //////////////////////////////////////////////////////////////////
     class BenchMutexFreeQueue : public ::testing::Test {
     public:
         using value_t = uint32_t;
 
+        using queue_t = Relax::MutexFreeQueue<value_t>;
+
+        // std::allocator counting node allocations
+        using new_queue_t = Relax::MutexFreeQueue<value_t, TCountingAllocator<value_t>>;
+
+        // holds whole sample: seq benches push everything before pop
+        using ring_queue_t = Relax::BoundedMutexFreeQueue<value_t, 1 << 20>;
+
+        using spsc_queue_t = Relax::SPSCQueue<value_t, 1 << 16>;
+
+        using segmented_queue_t = Relax::SegmentedMutexFreeQueue<value_t>;
+
+        // lock-free pops: type-stable pool nodes vs nodes freed by reclamation policy
+        using lockfree_queue_t = Relax::MutexFreeQueue<value_t,
+                                                       Relax::NodePoolAllocator<value_t>,
+                                                       Relax::TAdaptiveBackoff,
+                                                       Relax::EPopMode::LockFree>;
+
+        using hazard_queue_t = Relax::MutexFreeQueue<value_t,
+                                                     Relax::NodePoolAllocator<value_t>,
+                                                     Relax::TAdaptiveBackoff,
+                                                     Relax::EPopMode::LockFree,
+                                                     Relax::EReclaim::HazardPointers>;
+
+        using hazard_new_queue_t = Relax::MutexFreeQueue<value_t,
+                                                         std::allocator<value_t>,
+                                                         Relax::TAdaptiveBackoff,
+                                                         Relax::EPopMode::LockFree,
+                                                         Relax::EReclaim::HazardPointers>;
+
+        using epoch_queue_t = Relax::MutexFreeQueue<value_t,
+                                                    Relax::NodePoolAllocator<value_t>,
+                                                    Relax::TAdaptiveBackoff,
+                                                    Relax::EPopMode::LockFree,
+                                                    Relax::EReclaim::EpochBased>;
+
+        using epoch_new_queue_t = Relax::MutexFreeQueue<value_t,
+                                                        std::allocator<value_t>,
+                                                        Relax::TAdaptiveBackoff,
+                                                        Relax::EPopMode::LockFree,
+                                                        Relax::EReclaim::EpochBased>;
+
         BenchMutexFreeQueue() { }
 
         BenchMutexFreeQueue(const BenchMutexFreeQueue& other) = delete;
@@ -292,6 +763,13 @@ namespace Test {
         static constexpr std::array<uint32_t, 4> m_nthread_modes = {2, 8, 12, 1024};
 
         static constexpr uint32_t m_nsections = 1000;
+
+        static constexpr std::array<uint32_t, 3> m_batch_modes = {32, 128, 256};
+
+        static constexpr std::array<uint32_t, 3> m_nconsumer_modes = {1, 4, 16};
+
+        // MutexFreeQueue node: link and value
+        static constexpr size_t m_node_size = sizeof(std::pair<void*, value_t>);
     };
 
     //--------------------------------------------------------------//
@@ -318,7 +796,18 @@ namespace Test {
 
         Duration std_time = Timestamp::Now() - start;
 
+        segmented_queue_t seg_queue;
+        g.restart();
+
+        start = Timestamp::Now();
+        while (!g.empty()) {
+            seg_queue.push(g.nextUp());
+        }
+
+        Duration seg_time = Timestamp::Now() - start;
+
         ReportSingle(lftime, std_time);
+        ReportSingle(seg_time, std_time, "Seg");
     }
 
     //--------------------------------------------------------------//
@@ -353,7 +842,21 @@ namespace Test {
 
         Duration std_time = Timestamp::Now() - start;
 
+        segmented_queue_t seg_queue;
+        g.restart();
+
+        start = Timestamp::Now();
+        while (!g.empty()) {
+            seg_queue.push(g.nextUp());
+        }
+
+        while (seg_queue.pop(ret))
+            ;
+
+        Duration seg_time = Timestamp::Now() - start;
+
         ReportSingle(lftime, std_time);
+        ReportSingle(seg_time, std_time, "Seg");
     }
 
     //--------------------------------------------------------------//
@@ -365,11 +868,29 @@ namespace Test {
             std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
             const uint64_t size = sample_size - (sample_size % nthreads);
 
-            auto lfstat = BenchQueueSeqPush<Relax::MutexFreeQueue<value_t>>(size, nthreads, niterations);
+            const uint64_t nops = size * niterations;
+
+            auto [lfstat, lf_allocs] = BenchAllocs<queue_t>(nops, [&] {
+                return BenchQueueSeqPush<queue_t>(size, nthreads, niterations);
+            });
+
+            auto [std_stat, std_allocs] = BenchAllocs<SillyMutexQueue<value_t>>(nops, [&] {
+                return BenchQueueSeqPush<SillyMutexQueue<value_t>>(size, nthreads, niterations);
+            });
+
+            auto [new_stat, new_allocs] = BenchAllocs<new_queue_t>(nops, [&] {
+                return BenchQueueSeqPush<new_queue_t>(size, nthreads, niterations);
+            });
 
-            auto std_stat = BenchQueueSeqPush<SillyMutexQueue<value_t>>(size, nthreads, niterations);
+            auto ring_stat = BenchQueueSeqPush<ring_queue_t>(size, nthreads, niterations);
+
+            auto seg_stat = BenchQueueSeqPush<segmented_queue_t>(size, nthreads, niterations);
 
             Report(lfstat, std_stat);
+            Report(lfstat, new_stat, "MF", "MF+new");
+            Report(ring_stat, lfstat, "Ring", "MF");
+            Report(seg_stat, lfstat, "Seg", "MF");
+            ReportAllocs(lf_allocs, std_allocs, new_allocs);
         }
     }
 
@@ -382,11 +903,29 @@ namespace Test {
             std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
             const uint64_t size = sample_size - (sample_size % nthreads);
 
-            auto lfstat = BenchQueueSeqPushPop<Relax::MutexFreeQueue<value_t>>(size, nthreads, niterations);
+            const uint64_t nops = 2 * size * niterations;
+
+            auto [lfstat, lf_allocs] = BenchAllocs<queue_t>(nops, [&] {
+                return BenchQueueSeqPushPop<queue_t>(size, nthreads, niterations);
+            });
+
+            auto [std_stat, std_allocs] = BenchAllocs<SillyMutexQueue<value_t>>(nops, [&] {
+                return BenchQueueSeqPushPop<SillyMutexQueue<value_t>>(size, nthreads, niterations);
+            });
+
+            auto [new_stat, new_allocs] = BenchAllocs<new_queue_t>(nops, [&] {
+                return BenchQueueSeqPushPop<new_queue_t>(size, nthreads, niterations);
+            });
 
-            auto std_stat = BenchQueueSeqPushPop<SillyMutexQueue<value_t>>(size, nthreads, niterations);
+            auto ring_stat = BenchQueueSeqPushPop<ring_queue_t>(size, nthreads, niterations);
+
+            auto seg_stat = BenchQueueSeqPushPop<segmented_queue_t>(size, nthreads, niterations);
 
             Report(lfstat, std_stat);
+            Report(lfstat, new_stat, "MF", "MF+new");
+            Report(ring_stat, lfstat, "Ring", "MF");
+            Report(seg_stat, lfstat, "Seg", "MF");
+            ReportAllocs(lf_allocs, std_allocs, new_allocs);
         }
     }
 
@@ -400,12 +939,115 @@ namespace Test {
             std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
             const uint64_t size = sample_size - (sample_size % nthreads);
 
-            auto lfstat =
-                BenchQueueSectioned<Relax::MutexFreeQueue<value_t>>(size, nthreads, nsections, niterations);
+            const uint64_t nops = 2 * size * niterations;
+
+            auto [lfstat, lf_allocs] = BenchAllocs<queue_t>(nops, [&] {
+                return BenchQueueSectioned<queue_t>(size, nthreads, nsections, niterations);
+            });
 
-            auto std_stat = BenchQueueSectioned<SillyMutexQueue<value_t>>(size, nthreads, nsections, niterations);
+            auto [std_stat, std_allocs] = BenchAllocs<SillyMutexQueue<value_t>>(nops, [&] {
+                return BenchQueueSectioned<SillyMutexQueue<value_t>>(size, nthreads, nsections, niterations);
+            });
+
+            auto [new_stat, new_allocs] = BenchAllocs<new_queue_t>(nops, [&] {
+                return BenchQueueSectioned<new_queue_t>(size, nthreads, nsections, niterations);
+            });
+
+            auto ring_stat = BenchQueueSectioned<ring_queue_t>(size, nthreads, nsections, niterations);
+
+            auto seg_stat = BenchQueueSectioned<segmented_queue_t>(size, nthreads, nsections, niterations);
 
             Report(lfstat, std_stat);
+            Report(lfstat, new_stat, "MF", "MF+new");
+            Report(ring_stat, lfstat, "Ring", "MF");
+            Report(seg_stat, lfstat, "Seg", "MF");
+            ReportAllocs(lf_allocs, std_allocs, new_allocs);
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchMutexFreeQueue, seq_push_batch) {
+        constexpr uint64_t sample_size = m_sample_size;
+        constexpr uint32_t niterations = m_nsamples;
+
+        for (uint32_t batch_size : m_batch_modes) {
+            for (uint32_t nthreads : m_nthread_modes) {
+                std::cout << "NThread: " << std::setw(9) << nthreads << "   Batch: " << std::setw(6) << batch_size
+                          << std::endl;
+                const uint64_t size = sample_size - (sample_size % nthreads);
+
+                auto lfstat = BenchQueueSeqPushBatch<Relax::MutexFreeQueue<value_t>>(size,
+                                                                                     nthreads,
+                                                                                     batch_size,
+                                                                                     niterations);
+
+                auto std_stat =
+                    BenchQueueSeqPushBatch<SillyMutexQueue<value_t>>(size, nthreads, batch_size, niterations);
+
+                auto seg_stat =
+                    BenchQueueSeqPushBatch<segmented_queue_t>(size, nthreads, batch_size, niterations);
+
+                Report(lfstat, std_stat);
+                Report(seg_stat, lfstat, "Seg", "MF");
+            }
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchMutexFreeQueue, batched_push_pop_batch) {
+        constexpr uint64_t sample_size = m_sample_size;
+        constexpr uint32_t niterations = m_nsamples;
+        constexpr uint32_t nsections = m_nsections;
+
+        for (uint32_t batch_size : m_batch_modes) {
+            for (uint32_t nthreads : m_nthread_modes) {
+                std::cout << "NThread: " << std::setw(9) << nthreads << "   Batch: " << std::setw(6) << batch_size
+                          << std::endl;
+                const uint64_t size = sample_size - (sample_size % nthreads);
+
+                auto lfstat = BenchQueueSectionedBatch<Relax::MutexFreeQueue<value_t>>(size,
+                                                                                       nthreads,
+                                                                                       nsections,
+                                                                                       batch_size,
+                                                                                       niterations);
+
+                auto std_stat = BenchQueueSectionedBatch<SillyMutexQueue<value_t>>(size,
+                                                                                   nthreads,
+                                                                                   nsections,
+                                                                                   batch_size,
+                                                                                   niterations);
+
+                auto seg_stat = BenchQueueSectionedBatch<segmented_queue_t>(size,
+                                                                            nthreads,
+                                                                            nsections,
+                                                                            batch_size,
+                                                                            niterations);
+
+                Report(lfstat, std_stat);
+                Report(seg_stat, lfstat, "Seg", "MF");
+            }
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchMutexFreeQueue, batched_push_pop_bulk) {
+        constexpr uint64_t sample_size = m_sample_size;
+        constexpr uint32_t niterations = m_nsamples;
+        constexpr uint32_t nsections = m_nsections;
+
+        for (uint32_t bulk_size : m_batch_modes) {
+            for (uint32_t nthreads : m_nthread_modes) {
+                std::cout << "NThread: " << std::setw(9) << nthreads << "   Bulk: " << std::setw(6) << bulk_size
+                          << std::endl;
+                const uint64_t size = sample_size - (sample_size % nthreads);
+
+                auto bulk_stat =
+                    BenchQueueSectionedBulk<queue_t>(size, nthreads, nsections, bulk_size, niterations);
+
+                auto lfstat = BenchQueueSectioned<queue_t>(size, nthreads, nsections, niterations);
+
+                Report(bulk_stat, lfstat, "Bulk", "MF");
+            }
         }
     }
 
@@ -418,14 +1060,116 @@ namespace Test {
             std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
             const uint64_t size = sample_size - (sample_size % nthreads);
 
-            auto lfstat = BenchQueueParPushPop<Relax::MutexFreeQueue<value_t>>(size, nthreads, niterations);
+            const uint64_t nops = 2 * size * niterations;
+
+            auto [lfstat, lf_allocs] = BenchAllocs<queue_t>(nops, [&] {
+                return BenchQueueParPushPop<queue_t>(size, nthreads, niterations);
+            });
+
+            auto [std_stat, std_allocs] = BenchAllocs<SillyMutexQueue<value_t>>(nops, [&] {
+                return BenchQueueParPushPop<SillyMutexQueue<value_t>>(size, nthreads, niterations);
+            });
+
+            auto [new_stat, new_allocs] = BenchAllocs<new_queue_t>(nops, [&] {
+                return BenchQueueParPushPop<new_queue_t>(size, nthreads, niterations);
+            });
+
+            auto ring_stat = BenchQueueParPushPop<ring_queue_t>(size, nthreads, niterations);
 
-            auto std_stat = BenchQueueParPushPop<SillyMutexQueue<value_t>>(size, nthreads, niterations);
+            auto seg_stat = BenchQueueParPushPop<segmented_queue_t>(size, nthreads, niterations);
 
             Report(lfstat, std_stat);
+            Report(lfstat, new_stat, "MF", "MF+new");
+            Report(ring_stat, lfstat, "Ring", "MF");
+            Report(seg_stat, lfstat, "Seg", "MF");
+            ReportAllocs(lf_allocs, std_allocs, new_allocs);
+
+            // single producer and single consumer
+            if (2 == nthreads) {
+                auto spsc_stat = BenchQueueParPushPop<spsc_queue_t>(size, nthreads, niterations);
+                Report(spsc_stat, lfstat, "SPSC", "MF");
+            }
+        }
+    }
+
+    //--------------------------------------------------------------//
+    // per-operation cost of reclamation (guard + retire + amortized scan or epoch advance) and retired memory held
+    TEST_F(BenchMutexFreeQueue, reclaim) {
+        constexpr uint64_t sample_size = m_sample_size;
+        constexpr uint32_t niterations = m_nsamples;
+
+        for (uint32_t nthreads : m_nthread_modes) {
+            std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
+            const uint64_t size = sample_size - (sample_size % nthreads);
+            const uint64_t nops = 2 * size;
+
+            auto lfstat = BenchQueueParPushPop<lockfree_queue_t>(size, nthreads, niterations);
+
+            auto [hp_stat, hp_peak] = BenchReclaim(Relax::HazardStats(), [&] {
+                return BenchQueueParPushPop<hazard_queue_t>(size, nthreads, niterations);
+            });
+
+            auto [hp_new_stat, hp_new_peak] = BenchReclaim(Relax::HazardStats(), [&] {
+                return BenchQueueParPushPop<hazard_new_queue_t>(size, nthreads, niterations);
+            });
+
+            auto [ebr_stat, ebr_peak] = BenchReclaim(Relax::EpochStats(), [&] {
+                return BenchQueueParPushPop<epoch_queue_t>(size, nthreads, niterations);
+            });
+
+            auto [ebr_new_stat, ebr_new_peak] = BenchReclaim(Relax::EpochStats(), [&] {
+                return BenchQueueParPushPop<epoch_new_queue_t>(size, nthreads, niterations);
+            });
+
+            Report(hp_stat, lfstat, "HP", "LF");
+            ReportReclaim(hp_stat.first, lfstat.first, nops, hp_peak, m_node_size);
+            Report(hp_new_stat, lfstat, "HP+new", "LF");
+            ReportReclaim(hp_new_stat.first, lfstat.first, nops, hp_new_peak, m_node_size);
+            Report(ebr_stat, lfstat, "EBR", "LF");
+            ReportReclaim(ebr_stat.first, lfstat.first, nops, ebr_peak, m_node_size);
+            Report(ebr_new_stat, lfstat, "EBR+new", "LF");
+            ReportReclaim(ebr_new_stat.first, lfstat.first, nops, ebr_new_peak, m_node_size);
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchMutexFreeQueue, idle_consumers) {
+        constexpr std::chrono::milliseconds idle(200);
+
+        for (uint32_t nconsumers : m_nconsumer_modes) {
+            std::cout << "NConsumers: " << std::setw(6) << nconsumers << "   Idle: " << idle.count() << "ms"
+                      << std::endl;
+
+            const Duration wait_cpu = BenchQueueIdle<queue_t, true>(nconsumers, idle);
+            const Duration poll_cpu = BenchQueueIdle<queue_t, false>(nconsumers, idle);
+
+            std::cout << "CPU time pop_wait: " << std::setw(12) << wait_cpu.Str() << "   poll: " << std::setw(12)
+                      << poll_cpu.Str() << std::endl;
+
+            const Duration seg_wait_cpu = BenchQueueIdle<segmented_queue_t, true>(nconsumers, idle);
+            std::cout << "CPU time Seg pop_wait: " << std::setw(12) << seg_wait_cpu.Str() << std::endl;
         }
     }
 
+    //--------------------------------------------------------------//
+    TEST_F(BenchMutexFreeQueue, wake_latency) {
+        constexpr uint32_t nwakes = 1000;
+        constexpr std::chrono::microseconds pause(500);
+
+        using latency_queue_t = Relax::MutexFreeQueue<uint64_t>;
+
+        const double wait_ns = BenchQueueWakeLatency<latency_queue_t, true>(nwakes, pause);
+        const double poll_ns = BenchQueueWakeLatency<latency_queue_t, false>(nwakes, pause);
+
+        const double seg_wait_ns =
+            BenchQueueWakeLatency<Relax::SegmentedMutexFreeQueue<uint64_t>, true>(nwakes, pause);
+
+        std::cout << std::fixed << std::setprecision(0);
+        std::cout << "Wake latency pop_wait: " << std::setw(9) << wait_ns << "ns   poll: " << std::setw(9)
+                  << poll_ns << "ns" << std::endl;
+        std::cout << "Wake latency Seg pop_wait: " << std::setw(9) << seg_wait_ns << "ns" << std::endl;
+    }
+
     //////////////////////////////////////////////////////////////////
     class BenchIntrusiveMutexFreeQueue : public ::testing::Test {
     public:
@@ -435,6 +1179,16 @@ namespace Test {
 
         using value_t = Node;
 
+        using lockfree_queue_t = Relax::IntrusiveMutexFreeQueue<value_t, Relax::EPopMode::LockFree>;
+
+        using spsc_queue_t = Relax::SPSCQueue<value_t*, 1 << 16>;
+
+        template<size_t NShards>
+        using sharded_queue_t = Relax::ShardedMutexFreeQueue<value_t, NShards>;
+
+        template<Relax::BackoffPolicy Backoff>
+        using backoff_queue_t = Relax::IntrusiveMutexFreeQueue<value_t, Relax::EPopMode::Marked, Backoff>;
+
         BenchIntrusiveMutexFreeQueue() { }
 
         BenchIntrusiveMutexFreeQueue(const BenchIntrusiveMutexFreeQueue& other) = delete;
@@ -450,6 +1204,23 @@ namespace Test {
         static constexpr std::array<uint32_t, 4> m_nthread_modes = {2, 8, 12, 1024};
 
         static constexpr uint32_t m_nsections = 1000;
+
+        static constexpr std::array<uint32_t, 3> m_batch_modes = {32, 128, 256};
+
+        static constexpr uint32_t m_nproducers = 2;
+
+        static constexpr std::array<uint32_t, 6> m_nconsumer_modes = {1, 2, 4, 8, 16, 32};
+
+        // threads per hardware thread
+        static constexpr std::array<uint32_t, 4> m_oversubscription_modes = {1, 4, 16, 64};
+
+        // shard count knob of ShardedMutexFreeQueue
+        template<class Bench>
+        static void forShardModes(Bench&& bench) {
+            bench.template operator()<4>();
+            bench.template operator()<16>();
+            bench.template operator()<64>();
+        }
     };
 
     //--------------------------------------------------------------//
@@ -510,6 +1281,85 @@ namespace Test {
         }
     }
 
+    //--------------------------------------------------------------//
+    TEST_F(BenchIntrusiveMutexFreeQueue, batched_push_pop_all) {
+        constexpr uint64_t sample_size = m_sample_size;
+        constexpr uint32_t niterations = m_nsamples;
+        constexpr uint32_t nsections = m_nsections;
+
+        for (uint32_t nthreads : m_nthread_modes) {
+            std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
+            const uint64_t size = sample_size - (sample_size % nthreads);
+
+            auto pop_all_stat = BenchQueueSectioned<Relax::IntrusiveMutexFreeQueue<value_t>, value_t*, true>(
+                size,
+                nthreads,
+                nsections,
+                niterations);
+
+            auto lfstat = BenchQueueSectioned<Relax::IntrusiveMutexFreeQueue<value_t>, value_t*>(size,
+                                                                                                 nthreads,
+                                                                                                 nsections,
+                                                                                                 niterations);
+
+            Report(pop_all_stat, lfstat, "PopAll", "MF");
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchIntrusiveMutexFreeQueue, seq_push_batch) {
+        constexpr uint64_t sample_size = m_sample_size;
+        constexpr uint32_t niterations = m_nsamples;
+
+        for (uint32_t batch_size : m_batch_modes) {
+            for (uint32_t nthreads : m_nthread_modes) {
+                std::cout << "NThread: " << std::setw(9) << nthreads << "   Batch: " << std::setw(6) << batch_size
+                          << std::endl;
+                const uint64_t size = sample_size - (sample_size % nthreads);
+
+                auto lfstat = BenchQueueSeqPushBatch<Relax::IntrusiveMutexFreeQueue<value_t>, value_t*>(size,
+                                                                                                        nthreads,
+                                                                                                        batch_size,
+                                                                                                        niterations);
+
+                auto std_stat =
+                    BenchQueueSeqPushBatch<SillyMutexQueue<value_t*>>(size, nthreads, batch_size, niterations);
+
+                Report(lfstat, std_stat);
+            }
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchIntrusiveMutexFreeQueue, batched_push_pop_batch) {
+        constexpr uint64_t sample_size = m_sample_size;
+        constexpr uint32_t niterations = m_nsamples;
+        constexpr uint32_t nsections = m_nsections;
+
+        for (uint32_t batch_size : m_batch_modes) {
+            for (uint32_t nthreads : m_nthread_modes) {
+                std::cout << "NThread: " << std::setw(9) << nthreads << "   Batch: " << std::setw(6) << batch_size
+                          << std::endl;
+                const uint64_t size = sample_size - (sample_size % nthreads);
+
+                auto lfstat = BenchQueueSectionedBatch<Relax::IntrusiveMutexFreeQueue<value_t>, value_t*>(
+                    size,
+                    nthreads,
+                    nsections,
+                    batch_size,
+                    niterations);
+
+                auto std_stat = BenchQueueSectionedBatch<SillyMutexQueue<value_t*>>(size,
+                                                                                    nthreads,
+                                                                                    nsections,
+                                                                                    batch_size,
+                                                                                    niterations);
+
+                Report(lfstat, std_stat);
+            }
+        }
+    }
+
     //--------------------------------------------------------------//
     TEST_F(BenchIntrusiveMutexFreeQueue, parallel_push_pop) {
         constexpr uint64_t sample_size = m_sample_size;
@@ -523,9 +1373,118 @@ namespace Test {
                                                                                                   nthreads,
                                                                                                   niterations);
 
+            auto lockfree_stat = BenchQueueParPushPop<lockfree_queue_t, value_t*>(size, nthreads, niterations);
+
             auto std_stat = BenchQueueParPushPop<SillyMutexQueue<value_t*>>(size, nthreads, niterations);
 
             Report(lfstat, std_stat);
+            Report(lockfree_stat, lfstat, "LF", "MF");
+
+            // single producer and single consumer
+            if (2 == nthreads) {
+                auto spsc_stat = BenchQueueParPushPop<spsc_queue_t, value_t*>(size, nthreads, niterations);
+                Report(spsc_stat, lfstat, "SPSC", "MF");
+            }
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchIntrusiveMutexFreeQueue, parallel_push_pop_consumers) {
+        constexpr uint64_t sample_size = m_sample_size;
+        constexpr uint32_t niterations = m_nsamples;
+        constexpr uint32_t nproducers = m_nproducers;
+
+        for (uint32_t nconsumers : m_nconsumer_modes) {
+            std::cout << "NProducers: " << std::setw(6) << nproducers << "   NConsumers: " << std::setw(6)
+                      << nconsumers << std::endl;
+            const uint64_t size = sample_size - (sample_size % nproducers);
+
+            auto lfstat = BenchQueueProducersConsumers<Relax::IntrusiveMutexFreeQueue<value_t>, value_t*>(
+                size,
+                nproducers,
+                nconsumers,
+                niterations);
+
+            auto lockfree_stat =
+                BenchQueueProducersConsumers<lockfree_queue_t, value_t*>(size, nproducers, nconsumers, niterations);
+
+            auto std_stat =
+                BenchQueueProducersConsumers<SillyMutexQueue<value_t*>>(size, nproducers, nconsumers, niterations);
+
+            Report(lfstat, std_stat);
+            Report(lockfree_stat, lfstat, "LF", "MF");
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchIntrusiveMutexFreeQueue, sharded_seq_push) {
+        constexpr uint64_t sample_size = m_sample_size;
+        constexpr uint32_t niterations = m_nsamples;
+
+        for (uint32_t nthreads : m_nthread_modes) {
+            std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
+            const uint64_t size = sample_size - (sample_size % nthreads);
+
+            auto lfstat =
+                BenchQueueSeqPush<Relax::IntrusiveMutexFreeQueue<value_t>, value_t*>(size, nthreads, niterations);
+
+            forShardModes([&]<size_t NShards>() {
+                auto sharded_stat = BenchQueueSeqPush<sharded_queue_t<NShards>, value_t*>(size, nthreads, niterations);
+                Report(sharded_stat, lfstat, ("Shard" + std::to_string(NShards)).c_str(), "MF");
+            });
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchIntrusiveMutexFreeQueue, sharded_parallel_push_pop) {
+        constexpr uint64_t sample_size = m_sample_size;
+        constexpr uint32_t niterations = m_nsamples;
+
+        for (uint32_t nthreads : m_nthread_modes) {
+            std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
+            const uint64_t size = sample_size - (sample_size % nthreads);
+
+            auto lfstat = BenchQueueParPushPop<Relax::IntrusiveMutexFreeQueue<value_t>, value_t*>(size,
+                                                                                                  nthreads,
+                                                                                                  niterations);
+
+            forShardModes([&]<size_t NShards>() {
+                auto sharded_stat =
+                    BenchQueueParPushPop<sharded_queue_t<NShards>, value_t*>(size, nthreads, niterations);
+                Report(sharded_stat, lfstat, ("Shard" + std::to_string(NShards)).c_str(), "MF");
+            });
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchIntrusiveMutexFreeQueue, backoff_policies) {
+        constexpr uint64_t sample_size = m_sample_size;
+        constexpr uint32_t niterations = m_nsamples;
+
+        const uint32_t ncores = std::max(1u, std::thread::hardware_concurrency());
+
+        for (uint32_t oversubscription : m_oversubscription_modes) {
+            // even: producer/consumer pairs
+            const uint32_t nthreads = std::max(2u, ncores * oversubscription / 2 * 2);
+            std::cout << "NThread: " << std::setw(9) << nthreads << "   Oversubscription: " << std::setw(3)
+                      << oversubscription << std::endl;
+            const uint64_t size = sample_size - (sample_size % nthreads);
+
+            auto adaptive_stat =
+                BenchQueueParPushPop<backoff_queue_t<Relax::TAdaptiveBackoff>, value_t*>(size, nthreads, niterations);
+
+            auto exp_stat =
+                BenchQueueParPushPop<backoff_queue_t<Relax::TExpBackoff<>>, value_t*>(size, nthreads, niterations);
+
+            auto yield_stat =
+                BenchQueueParPushPop<backoff_queue_t<Relax::TYieldBackoff<>>, value_t*>(size, nthreads, niterations);
+
+            auto park_stat =
+                BenchQueueParPushPop<backoff_queue_t<Relax::TParkBackoff<>>, value_t*>(size, nthreads, niterations);
+
+            Report(exp_stat, adaptive_stat, "Exp", "Adapt");
+            Report(yield_stat, adaptive_stat, "Yield", "Adapt");
+            Report(park_stat, adaptive_stat, "Park", "Adapt");
         }
     }
 
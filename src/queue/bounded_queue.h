@@ -0,0 +1,257 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+#include "common.h"
+#include "types.h"
+
+namespace Relax {
+
+#pragma region BoundedMutexFreeQueue
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * MPMC ring of Capacity slots with per-slot sequence numbers.
+     *  * Capacity - power of 2
+     *  * No allocations after construction
+     *  * push spins (yields) while queue is full, try_push fails instead
+     */
+    template<class T, size_t Capacity = 1024>
+    class BoundedMutexFreeQueue {
+        static_assert(0 < Capacity && 0 == (Capacity & (Capacity - 1)), "Capacity must be power of 2");
+        static_assert(std::is_nothrow_move_constructible_v<T>, "");
+        static_assert(std::is_nothrow_destructible_v<T>, "");
+
+        struct Slot {
+            std::atomic<size_t> m_seq;
+            alignas(T) unsigned char m_storage[sizeof(T)];
+
+            T* value() noexcept { return std::launder(reinterpret_cast<T*>(m_storage)); }
+        };
+
+    public:
+        typedef T value_type;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef size_t size_type;
+
+        static constexpr size_type m_capacity = Capacity;
+
+    public:
+        BoundedMutexFreeQueue();
+        ~BoundedMutexFreeQueue();
+
+        BoundedMutexFreeQueue(const BoundedMutexFreeQueue& other) = delete;
+        BoundedMutexFreeQueue(BoundedMutexFreeQueue&& other) noexcept = delete;
+        BoundedMutexFreeQueue& operator=(const BoundedMutexFreeQueue& other) = delete;
+        BoundedMutexFreeQueue& operator=(BoundedMutexFreeQueue&& other) noexcept = delete;
+
+        bool empty() const noexcept;
+
+        size_type size() const noexcept;
+
+        static constexpr size_type capacity() noexcept { return Capacity; }
+
+        void push(const value_type& value);
+
+        void push(value_type&& value);
+
+        template<typename... Args>
+        void emplace(Args&&... args);
+
+        bool try_push(const value_type& value);
+
+        bool try_push(value_type&& value);
+
+        template<typename... Args>
+        bool try_emplace(Args&&... args);
+
+        bool pop(value_type& ref);
+
+        void clear();
+
+    private:
+        static constexpr size_type m_mask = Capacity - 1;
+
+        std::unique_ptr<Slot[]> m_slots;
+
+        alignas(CACHELINE_SIZE) std::atomic<size_type> m_enqueue_pos;
+
+        alignas(CACHELINE_SIZE) std::atomic<size_type> m_dequeue_pos;
+    };
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    BoundedMutexFreeQueue<T, C>::BoundedMutexFreeQueue()
+      : m_slots(new Slot[C])
+      , m_enqueue_pos(0)
+      , m_dequeue_pos(0) {
+        for (size_type i = 0; i < C; ++i) {
+            m_slots[i].m_seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    BoundedMutexFreeQueue<T, C>::~BoundedMutexFreeQueue() {
+        clear();
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline bool BoundedMutexFreeQueue<T, C>::empty() const noexcept {
+        return 0 == size();
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline typename BoundedMutexFreeQueue<T, C>::size_type BoundedMutexFreeQueue<T, C>::size() const noexcept {
+        const size_type dequeue_pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        const size_type enqueue_pos = m_enqueue_pos.load(std::memory_order_relaxed);
+
+        // positions are loaded not atomically together
+        return (enqueue_pos > dequeue_pos) ? std::min(enqueue_pos - dequeue_pos, C) : 0;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline void BoundedMutexFreeQueue<T, C>::push(const value_type& value) {
+        emplace(value);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline void BoundedMutexFreeQueue<T, C>::push(value_type&& value) {
+        emplace(std::move(value));
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    template<typename... Args>
+    inline void BoundedMutexFreeQueue<T, C>::emplace(Args&&... args) {
+        // value is built once: args may be rvalues
+        value_type value(std::forward<Args>(args)...);
+        while (!try_emplace(std::move(value))) {
+            std::this_thread::yield();
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline bool BoundedMutexFreeQueue<T, C>::try_push(const value_type& value) {
+        return try_emplace(value);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline bool BoundedMutexFreeQueue<T, C>::try_push(value_type&& value) {
+        return try_emplace(std::move(value));
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    template<typename... Args>
+    bool BoundedMutexFreeQueue<T, C>::try_emplace(Args&&... args) {
+        if constexpr (!std::is_nothrow_constructible_v<value_type, Args&&...>) {
+            // claimed slot can't be released WO value: build it before claim
+            return try_emplace(value_type(std::forward<Args>(args)...));
+        }
+        else {
+            size_type pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            Slot* slot;
+
+            while (true) {
+                slot = &m_slots[pos & m_mask];
+                const size_type seq = slot->m_seq.load(std::memory_order_acquire);
+                const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+                if (0 == diff) {
+                    if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0) {
+                    // full
+                    return false;
+                }
+                else {
+                    pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+
+            new (slot->m_storage) value_type(std::forward<Args>(args)...);
+            slot->m_seq.store(pos + 1, std::memory_order_release);
+
+            return true;
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    bool BoundedMutexFreeQueue<T, C>::pop(value_type& ref) {
+        size_type pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        Slot* slot;
+
+        while (true) {
+            slot = &m_slots[pos & m_mask];
+            const size_type seq = slot->m_seq.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+            if (0 == diff) {
+                if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0) {
+                // empty
+                return false;
+            }
+            else {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        value_type* const value = slot->value();
+        new (&ref) value_type(std::move(*value));
+        value->~value_type();
+
+        slot->m_seq.store(pos + C, std::memory_order_release);
+
+        return true;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    void BoundedMutexFreeQueue<T, C>::clear() {
+        size_type pos = m_dequeue_pos.load(std::memory_order_relaxed);
+
+        while (true) {
+            Slot* const slot = &m_slots[pos & m_mask];
+            const size_type seq = slot->m_seq.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+            if (0 == diff) {
+                if (!m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    continue;
+
+                slot->value()->~value_type();
+                slot->m_seq.store(pos + C, std::memory_order_release);
+                ++pos;
+            }
+            else if (diff < 0) {
+                return;
+            }
+            else {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //--------------------------------------------------------------//
+
+#pragma endregion BoundedMutexFreeQueue
+
+}  // namespace Relax
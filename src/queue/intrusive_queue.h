@@ -1,8 +1,13 @@
 #pragma once
 
 #include <atomic>
+#include <cassert>
+#include <chrono>
 
+#include "reclaim/reclaim.h"
 #include "sync/atomic.h"
+#include "sync/backoff.h"
+#include "sync/event.h"
 #include "common.h"
 #include "types.h"
 
@@ -11,7 +16,114 @@ namespace Relax {
 #pragma region IntrusiveMutexFreeQueue
 
     //////////////////////////////////////////////////////////////////
+    enum class EPopMode {
+        // consumers serialize on the marked (locked) head
+        Marked,
+        // consumers CAS the ABA-tagged head, no locks.
+        // Popped nodes may still be read by concurrent poppers: node memory must stay readable
+        // (type-stable) while the queue is in use, or Reclaim policy protects them (see reclaim/reclaim.h).
+        LockFree,
+    };
+
+    //////////////////////////////////////////////////////////////////
+    // Consumer-private chain of nodes detached from queue.
+    // Links are complete: iterate WO synchronization.
     template<Chainable V>
+    class TChain {
+    public:
+        typedef V* pointer_type;
+        typedef size_t size_type;
+
+    public:
+        class iterator;
+
+        TChain()
+          : m_first(nullptr)
+          , m_last(nullptr)
+          , m_size(0) { }
+
+        TChain(pointer_type first, pointer_type last, size_type size)
+          : m_first(first)
+          , m_last(last)
+          , m_size(size) { }
+
+        bool empty() const noexcept { return 0 == m_size; }
+
+        size_type size() const noexcept { return m_size; }
+
+        pointer_type front() const noexcept { return m_first; }
+
+        pointer_type back() const noexcept { return m_last; }
+
+        // node may be reused (pushed again) right after pop_front
+        pointer_type pop_front() noexcept {
+            pointer_type const node = m_first;
+            if (nullptr == node)
+                return nullptr;
+
+            m_first = next(node);
+            if (nullptr == m_first)
+                m_last = nullptr;
+            --m_size;
+
+            return node;
+        }
+
+        pointer_type next(pointer_type node) const noexcept { return (m_last == node) ? nullptr : node->m_next; }
+
+    public:
+        // node must not be reused until iterator is moved forward
+        class iterator : public std::iterator<std::input_iterator_tag, pointer_type> {
+            friend class TChain<V>;
+
+            iterator(const TChain* chain, pointer_type node)
+              : m_chain(chain)
+              , m_node(node) { }
+
+        public:
+            pointer_type operator*() const noexcept { return m_node; }
+            pointer_type operator->() const noexcept { return m_node; }
+
+            iterator& operator++() noexcept {
+                m_node = m_chain->next(m_node);
+                return *this;
+            }
+            iterator operator++(int) noexcept {
+                iterator it(*this);
+                ++(*this);
+                return it;
+            }
+
+            bool operator==(const iterator& other) const noexcept { return m_node == other.m_node; }
+            bool operator!=(const iterator& other) const noexcept { return m_node != other.m_node; }
+
+        private:
+            const TChain* m_chain;
+
+            pointer_type m_node;
+        };
+
+        iterator begin() const { return iterator(this, m_first); }
+        iterator end() const { return iterator(this, nullptr); }
+
+    private:
+        pointer_type m_first;
+
+        pointer_type m_last;
+
+        size_type m_size;
+    };
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Backoff - policy of spin on locked head (Marked mode), see sync/backoff.h
+     * Reclaim - LockFree mode: popper guards node before it is read, popped nodes may be freed after
+     * TReclaim<Reclaim>::retire. Marked poppers never read popped nodes.
+     */
+    template<Chainable V,
+             EPopMode PopMode = EPopMode::Marked,
+             BackoffPolicy Backoff = TAdaptiveBackoff,
+             EReclaim Reclaim = EReclaim::TypeStable>
     class IntrusiveMutexFreeQueue {
     public:
         typedef V* pointer_type;
@@ -19,6 +131,7 @@ namespace Relax {
         typedef V& reference;
         typedef const V& const_reference;
         typedef size_t size_type;
+        typedef TChain<V> chain_type;
 
     public:
         IntrusiveMutexFreeQueue();
@@ -34,16 +147,44 @@ namespace Relax {
 
         void push(pointer_type ptr) noexcept;
 
+        // first..last - chain already linked by m_next, count - its length
+        void push_chain(pointer_type first, pointer_type last, size_type count) noexcept;
+
         pointer_type pop() noexcept;
 
         bool pop(pointer_type& ptr) noexcept;
 
+        // spins briefly, then parks until push
+        pointer_type pop_wait() noexcept;
+
+        // nullptr on timeout
+        template<class Rep, class Period>
+        pointer_type pop_wait_for(const std::chrono::duration<Rep, Period>& timeout) noexcept;
+
+        // detaches up to count nodes from head by single head acquisition
+        chain_type pop_chain(size_type count) noexcept;
+
+        // detaches all nodes by O(1) atomic ops
+        chain_type pop_all() noexcept;
+
         // TODO: void swap(IntrusiveMutexFreeQueue& queue) noexcept;
 
         void clear() noexcept;
 
     private:
-        inline void setPopPauseCnt(uint32_t old, uint32_t actual);
+        pointer_type popMarked() noexcept;
+
+        pointer_type popLockFree() noexcept;
+
+        chain_type popChainMarked(size_type count) noexcept;
+
+        chain_type popChainLockFree(size_type count) noexcept;
+
+        pointer_type lockHead() noexcept;
+
+        pointer_type spinPop() noexcept;
+
+        static chain_type completeChain(pointer_type first, pointer_type last) noexcept;
 
         inline bool markHead(pointer_type& head);
 
@@ -51,116 +192,186 @@ namespace Relax {
 
         static inline pointer_type marked(pointer_type ptr);
 
+        // ptr: 0bTTTTTTTTTTTTTTTTXXX...XXX
+        // T - ABA tag (LockFree mode only), X - 48-bit address
+        static inline pointer_type tagged(pointer_type ptr, uint64_t tag);
+
+        static inline pointer_type untagged(pointer_type ptr);
+
+        static inline uint64_t tagOf(pointer_type ptr);
+
+    private:
+        typedef typename TReclaim<Reclaim>::guard_type guard_type;
+
+        static_assert(EPopMode::LockFree == PopMode || EReclaim::TypeStable == Reclaim,
+                      "Marked poppers never read popped nodes");
+
+        static constexpr uint32_t m_tag_shift = 48;
+
+        static constexpr uintptr_t m_address_mask = ((uintptr_t)1 << m_tag_shift) - 1;
+
+        static_assert(sizeof(uintptr_t) == sizeof(uint64_t), "tagged head requires 64-bit pointers");
+
+        // pop attempts before parking
+        static constexpr uint32_t m_wait_spin_cnt = 128;
+
     private:
         alignas(CACHELINE_SIZE) std::atomic<V*> m_head;
 
         alignas(CACHELINE_SIZE) std::atomic<V*> m_tail;
 
-        alignas(CACHELINE_SIZE) std::atomic<uint32_t> m_pop_pause_cnt = 1;
+        [[no_unique_address]] typename Backoff::TShared m_backoff;
 
         // TODO:
         alignas(CACHELINE_SIZE) std::atomic<size_t> m_size;
 
+        // consumers parked in pop_wait
+        TEventCount m_event;
+
 #if RELAX_MF_QUEUE_VERIFICATION
         std::atomic<size_t> m_pop_cnt = 0;
 #endif
     };
 
-    //--------------------------------------------------------------//
-    template<Chainable V>
-    void IntrusiveMutexFreeQueue<V>::setPopPauseCnt(uint32_t old, uint32_t actual) {
-        if (actual <= old) {
-            m_pop_pause_cnt.store(std::max(1u, old - 1), std::memory_order_relaxed);
-        }
-        else {
-            m_pop_pause_cnt.store(actual, std::memory_order_relaxed);
-        }
-    }
-
     //-----------------------------------------------------------------------//
-    template<Chainable V>
-    bool IntrusiveMutexFreeQueue<V>::markHead(pointer_type& head) {
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    bool IntrusiveMutexFreeQueue<V, M, B, R>::markHead(pointer_type& head) {
         return m_head.compare_exchange_strong(head,
                                               marked(head),
-                                              std::memory_order_relaxed,
+                                              std::memory_order_acquire,
                                               std::memory_order_relaxed);
     }
 
     //-----------------------------------------------------------------------//
-    template<Chainable V>
-    bool IntrusiveMutexFreeQueue<V>::isMarked(pointer_type ptr) {
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    bool IntrusiveMutexFreeQueue<V, M, B, R>::isMarked(pointer_type ptr) {
         return reinterpret_cast<uintptr_t>(ptr) & 0b1;
     }
 
     //-----------------------------------------------------------------------//
-    template<Chainable V>
-    typename IntrusiveMutexFreeQueue<V>::pointer_type IntrusiveMutexFreeQueue<V>::marked(pointer_type ptr) {
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    typename IntrusiveMutexFreeQueue<V, M, B, R>::pointer_type IntrusiveMutexFreeQueue<V, M, B, R>::marked(
+        pointer_type ptr) {
         return reinterpret_cast<pointer_type>(reinterpret_cast<uintptr_t>(ptr) | 0b1);
     }
 
+    //-----------------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    typename IntrusiveMutexFreeQueue<V, M, B, R>::pointer_type IntrusiveMutexFreeQueue<V, M, B, R>::tagged(
+        pointer_type ptr,
+        uint64_t tag) {
+        assert(0 == (reinterpret_cast<uintptr_t>(ptr) & ~m_address_mask));
+        return reinterpret_cast<pointer_type>(reinterpret_cast<uintptr_t>(ptr) | (tag << m_tag_shift));
+    }
+
+    //-----------------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    typename IntrusiveMutexFreeQueue<V, M, B, R>::pointer_type IntrusiveMutexFreeQueue<V, M, B, R>::untagged(
+        pointer_type ptr) {
+        return reinterpret_cast<pointer_type>(reinterpret_cast<uintptr_t>(ptr) & m_address_mask);
+    }
+
+    //-----------------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    uint64_t IntrusiveMutexFreeQueue<V, M, B, R>::tagOf(pointer_type ptr) {
+        return reinterpret_cast<uintptr_t>(ptr) >> m_tag_shift;
+    }
+
     //--------------------------------------------------------------//
-    template<Chainable V>
-    IntrusiveMutexFreeQueue<V>::IntrusiveMutexFreeQueue()
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    IntrusiveMutexFreeQueue<V, M, B, R>::IntrusiveMutexFreeQueue()
       : m_head(nullptr)
       , m_tail(nullptr)
-      , m_size(0) { }
+      , m_size(0)
+      , m_event() { }
 
     //--------------------------------------------------------------//
-    template<Chainable V>
-    inline bool IntrusiveMutexFreeQueue<V>::empty() const noexcept {
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    inline bool IntrusiveMutexFreeQueue<V, M, B, R>::empty() const noexcept {
         return 0 == m_size.load(std::memory_order_relaxed);
     }
 
     //--------------------------------------------------------------//
-    template<Chainable V>
-    inline typename IntrusiveMutexFreeQueue<V>::size_type IntrusiveMutexFreeQueue<V>::size() const noexcept {
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    inline typename IntrusiveMutexFreeQueue<V, M, B, R>::size_type IntrusiveMutexFreeQueue<V, M, B, R>::size()
+        const noexcept {
         return m_size.load(std::memory_order_relaxed);
     }
 
     //--------------------------------------------------------------//
-    template<Chainable V>
-    inline void IntrusiveMutexFreeQueue<V>::push(pointer_type ptr) noexcept {
-        if (nullptr == ptr)
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    inline void IntrusiveMutexFreeQueue<V, M, B, R>::push(pointer_type ptr) noexcept {
+        push_chain(ptr, ptr, 1);
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    inline void IntrusiveMutexFreeQueue<V, M, B, R>::push_chain(pointer_type first,
+                                                          pointer_type last,
+                                                          size_type count) noexcept {
+        if (nullptr == first)
             return;
 
-        NAtomic::store(&ptr->m_next, (pointer_type)nullptr, std::memory_order_release);
+        assert(nullptr != last && 0 < count);
 
-        pointer_type tail = m_tail.exchange(ptr, std::memory_order_acq_rel);
+        NAtomic::store(&last->m_next, (pointer_type)nullptr, std::memory_order_release);
 
-        if (nullptr == tail)
-            m_head.store(ptr, std::memory_order_relaxed);
+        pointer_type tail = m_tail.exchange(last, std::memory_order_acq_rel);
+
+        if (nullptr == tail) {
+            if constexpr (EPopMode::LockFree == M) {
+                // the only writer of the empty head: bump the tag for stale poppers
+                const uint64_t tag = tagOf(m_head.load(std::memory_order_relaxed)) + 1;
+                m_head.store(tagged(first, tag), std::memory_order_release);
+            }
+            else {
+                m_head.store(first, std::memory_order_release);
+            }
+        }
         else {
-            NAtomic::store(&tail->m_next, ptr, std::memory_order_release);
+            NAtomic::store(&tail->m_next, first, std::memory_order_release);
         }
 
-        m_size.fetch_add(1, std::memory_order_relaxed);
+        // seq_cst: pairs with size check of parking consumer (free on x86 - locked op anyway)
+        m_size.fetch_add(count, std::memory_order_seq_cst);
+
+        m_event.notify((int32_t)std::min<size_type>(count, INT32_MAX));
     }
 
     //--------------------------------------------------------------//
-    template<Chainable V>
-    inline typename IntrusiveMutexFreeQueue<V>::pointer_type IntrusiveMutexFreeQueue<V>::pop() noexcept {
-        uint32_t pop_pause_cnt = 0;
-        const uint32_t old_pop_pause_cnt = m_pop_pause_cnt.load(std::memory_order_relaxed);
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    inline typename IntrusiveMutexFreeQueue<V, M, B, R>::pointer_type IntrusiveMutexFreeQueue<V, M, B, R>::pop()
+        noexcept {
+        if constexpr (EPopMode::LockFree == M)
+            return popLockFree();
+        else
+            return popMarked();
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    typename IntrusiveMutexFreeQueue<V, M, B, R>::pointer_type IntrusiveMutexFreeQueue<V, M, B, R>::lockHead()
+        noexcept {
+        B backoff(m_backoff);
         pointer_type head = m_head.load(std::memory_order_relaxed);
 
         while ((nullptr != head) && (isMarked(head) || (!markHead(head)))) {
-            if (0 == pop_pause_cnt) {
-                pop_pause_cnt = old_pop_pause_cnt;
-                for (uint32_t i = 0; i < old_pop_pause_cnt; ++i)
-                    CPU_PAUSE();
-            }
-            else {
-                CPU_PAUSE();
-                ++pop_pause_cnt;
-            }
+            backoff.pause([this] { return !isMarked(m_head.load(std::memory_order_relaxed)); });
 
             head = m_head.load(std::memory_order_relaxed);
         }
 
-        if (nullptr == head) {
-            setPopPauseCnt(old_pop_pause_cnt, pop_pause_cnt);
+        return head;
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    typename IntrusiveMutexFreeQueue<V, M, B, R>::pointer_type IntrusiveMutexFreeQueue<V, M, B, R>::popMarked()
+        noexcept {
+        pointer_type const head = lockHead();
+
+        if (nullptr == head)
             return nullptr;
-        }
 
         // m_head is marked (locked)
         pointer_type next = NAtomic::load(&head->m_next, std::memory_order_acquire);
@@ -178,7 +389,7 @@ namespace Relax {
                     next = NAtomic::load(&head->m_next, std::memory_order_acquire);
                 } while (nullptr == next);
 
-                m_head.store(next, std::memory_order_relaxed);
+                m_head.store(next, std::memory_order_release);
             }
             else {
                 pointer_type marked_head = marked(head);
@@ -186,10 +397,11 @@ namespace Relax {
             }
         }
         else {
-            m_head.store(next, std::memory_order_relaxed);
+            m_head.store(next, std::memory_order_release);
         }
 
-        setPopPauseCnt(old_pop_pause_cnt, pop_pause_cnt);
+        // head is unlocked
+        B::notify(m_backoff);
 
         m_size.fetch_sub(1, std::memory_order_relaxed);
 
@@ -197,17 +409,315 @@ namespace Relax {
     }
 
     //--------------------------------------------------------------//
-    template<Chainable V>
-    inline bool IntrusiveMutexFreeQueue<V>::pop(pointer_type& ptr) noexcept {
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    typename IntrusiveMutexFreeQueue<V, M, B, R>::pointer_type IntrusiveMutexFreeQueue<V, M, B, R>::popLockFree()
+        noexcept {
+        guard_type guard;
+        pointer_type head = m_head.load(std::memory_order_acquire);
+
+        while (true) {
+            pointer_type const node = untagged(head);
+            if (nullptr == node)
+                return nullptr;
+
+            if (!guard.protect(node, m_head, head))
+                continue;
+
+            // node may be already popped by other thread: value of next is checked by tag of head
+            pointer_type const next = NAtomic::load(&node->m_next, std::memory_order_acquire);
+            const uint64_t tag = tagOf(head) + 1;
+
+            if (nullptr != next) {
+                if (m_head.compare_exchange_weak(head,
+                                                 tagged(next, tag),
+                                                 std::memory_order_acq_rel,
+                                                 std::memory_order_acquire))
+                    break;
+
+                continue;
+            }
+
+            // node looks like the last one: detach it from head, then from tail
+            if (!m_head.compare_exchange_weak(head,
+                                              tagged(nullptr, tag),
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire))
+                continue;
+
+            pointer_type tail = node;
+            if (!m_tail.compare_exchange_strong(tail,
+                                                nullptr,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_relaxed)) {
+                // already taken as predecessor by other thread: wait for producer's link.
+                // Head is empty until then, so no other popper writes it
+                pointer_type link = NAtomic::load(&node->m_next, std::memory_order_acquire);
+                while (nullptr == link) {
+                    CPU_PAUSE();
+                    link = NAtomic::load(&node->m_next, std::memory_order_acquire);
+                }
+
+                m_head.store(tagged(link, tag + 1), std::memory_order_release);
+            }
+
+            break;
+        }
+
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+
+        return untagged(head);
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    inline typename IntrusiveMutexFreeQueue<V, M, B, R>::chain_type IntrusiveMutexFreeQueue<V, M, B, R>::pop_chain(
+        size_type count) noexcept {
+        if (0 == count)
+            return chain_type();
+
+        if constexpr (EPopMode::LockFree == M)
+            return popChainLockFree(count);
+        else
+            return popChainMarked(count);
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    typename IntrusiveMutexFreeQueue<V, M, B, R>::chain_type IntrusiveMutexFreeQueue<V, M, B, R>::popChainMarked(
+        size_type count) noexcept {
+        pointer_type const first = lockHead();
+
+        if (nullptr == first)
+            return chain_type();
+
+        // m_head is marked (locked): nodes from head are not popped by others
+        pointer_type last = first;
+        size_type size = 1;
+        pointer_type next = NAtomic::load(&first->m_next, std::memory_order_acquire);
+        while (size < count && nullptr != next) {
+            last = next;
+            ++size;
+            next = NAtomic::load(&last->m_next, std::memory_order_acquire);
+        }
+
+        if (nullptr == next) {
+            // last node of queue: same as in popMarked
+            pointer_type tail = last;
+            if (!(m_tail.compare_exchange_strong(tail, nullptr, std::memory_order_relaxed))) {
+                do {
+                    CPU_PAUSE();
+                    next = NAtomic::load(&last->m_next, std::memory_order_acquire);
+                } while (nullptr == next);
+
+                m_head.store(next, std::memory_order_release);
+            }
+            else {
+                pointer_type marked_head = marked(first);
+                m_head.compare_exchange_strong(marked_head, nullptr, std::memory_order_relaxed);
+            }
+        }
+        else {
+            m_head.store(next, std::memory_order_release);
+        }
+
+        // head is unlocked
+        B::notify(m_backoff);
+
+        m_size.fetch_sub(size, std::memory_order_relaxed);
+
+        return chain_type(first, last, size);
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    typename IntrusiveMutexFreeQueue<V, M, B, R>::chain_type IntrusiveMutexFreeQueue<V, M, B, R>::popChainLockFree(
+        size_type count) noexcept {
+        // one guard for the whole walk: node read below is reachable from head while tag of head is the same
+        guard_type guard;
+        pointer_type head = m_head.load(std::memory_order_acquire);
+
+        while (true) {
+            pointer_type const first = untagged(head);
+            if (nullptr == first)
+                return chain_type();
+
+            if (!guard.protect(first, m_head, head))
+                continue;
+
+            pointer_type next = NAtomic::load(&first->m_next, std::memory_order_acquire);
+            if (nullptr == next) {
+                guard.reset();
+                // the last node needs tail detach of popLockFree
+                pointer_type const node = popLockFree();
+                return (nullptr == node) ? chain_type() : chain_type(node, node, 1);
+            }
+
+            // nodes may be already popped by other thread: walk is checked by tag of head.
+            // The last node of queue is left: new head is never empty
+            pointer_type last = first;
+            size_type size = 1;
+            bool reachable = true;
+            while (size < count) {
+                if (!guard.protect(next, m_head, head)) {
+                    reachable = false;
+                    break;
+                }
+
+                pointer_type const after = NAtomic::load(&next->m_next, std::memory_order_acquire);
+                if (nullptr == after)
+                    break;
+
+                last = next;
+                next = after;
+                ++size;
+            }
+
+            if (reachable && m_head.compare_exchange_weak(head,
+                                                          tagged(next, tagOf(head) + 1),
+                                                          std::memory_order_acq_rel,
+                                                          std::memory_order_acquire)) {
+                m_size.fetch_sub(size, std::memory_order_relaxed);
+                return chain_type(first, last, size);
+            }
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    inline bool IntrusiveMutexFreeQueue<V, M, B, R>::pop(pointer_type& ptr) noexcept {
         ptr = pop();
         return (nullptr != ptr);
     }
 
     //--------------------------------------------------------------//
-    template<Chainable V>
-    inline void IntrusiveMutexFreeQueue<V>::clear() noexcept {
-        while (pop())
-            ;
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    typename IntrusiveMutexFreeQueue<V, M, B, R>::pointer_type IntrusiveMutexFreeQueue<V, M, B, R>::spinPop()
+        noexcept {
+        for (uint32_t i = 0; i < m_wait_spin_cnt; ++i) {
+            pointer_type const ptr = pop();
+            if (nullptr != ptr)
+                return ptr;
+
+            CPU_PAUSE();
+        }
+
+        return nullptr;
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    typename IntrusiveMutexFreeQueue<V, M, B, R>::pointer_type IntrusiveMutexFreeQueue<V, M, B, R>::pop_wait()
+        noexcept {
+        pointer_type ptr = spinPop();
+
+        while (nullptr == ptr) {
+            const int32_t key = m_event.prepareWait();
+
+            // size is increased after node is linked
+            if (0 == m_size.load(std::memory_order_seq_cst))
+                m_event.commitWait(key);
+            else
+                m_event.cancelWait();
+
+            ptr = pop();
+        }
+
+        return ptr;
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    template<class Rep, class Period>
+    typename IntrusiveMutexFreeQueue<V, M, B, R>::pointer_type IntrusiveMutexFreeQueue<V, M, B, R>::pop_wait_for(
+        const std::chrono::duration<Rep, Period>& timeout) noexcept {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        pointer_type ptr = spinPop();
+
+        while (nullptr == ptr) {
+            const int32_t key = m_event.prepareWait();
+
+            bool in_time = true;
+            if (0 == m_size.load(std::memory_order_seq_cst))
+                in_time = m_event.commitWaitUntil(key, deadline);
+            else
+                m_event.cancelWait();
+
+            ptr = pop();
+            if (!in_time)
+                break;
+        }
+
+        return ptr;
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    typename IntrusiveMutexFreeQueue<V, M, B, R>::chain_type IntrusiveMutexFreeQueue<V, M, B, R>::pop_all()
+        noexcept {
+        pointer_type first = nullptr;
+
+        if constexpr (EPopMode::LockFree == M) {
+            pointer_type head = m_head.load(std::memory_order_acquire);
+            do {
+                first = untagged(head);
+                if (nullptr == first)
+                    return chain_type();
+            } while (!m_head.compare_exchange_weak(head,
+                                                   tagged(nullptr, tagOf(head) + 1),
+                                                   std::memory_order_acq_rel,
+                                                   std::memory_order_acquire));
+        }
+        else {
+            first = lockHead();
+            if (nullptr == first)
+                return chain_type();
+        }
+
+        // head is detached (marked or empty): only owner of head resets tail
+        pointer_type const last = m_tail.exchange(nullptr, std::memory_order_acq_rel);
+        assert(nullptr != last);
+
+        if constexpr (EPopMode::Marked == M) {
+            // new head may be already pushed by other thread
+            pointer_type marked_head = marked(first);
+            m_head.compare_exchange_strong(marked_head, nullptr, std::memory_order_relaxed);
+
+            B::notify(m_backoff);
+        }
+
+        chain_type chain = completeChain(first, last);
+
+        m_size.fetch_sub(chain.size(), std::memory_order_relaxed);
+
+        return chain;
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    typename IntrusiveMutexFreeQueue<V, M, B, R>::chain_type IntrusiveMutexFreeQueue<V, M, B, R>::completeChain(
+        pointer_type first,
+        pointer_type last) noexcept {
+        size_type count = 1;
+        pointer_type node = first;
+        while (last != node) {
+            // producer may be between tail exchange and link
+            pointer_type next = NAtomic::load(&node->m_next, std::memory_order_acquire);
+            while (nullptr == next) {
+                CPU_PAUSE();
+                next = NAtomic::load(&node->m_next, std::memory_order_acquire);
+            }
+
+            node = next;
+            ++count;
+        }
+
+        return chain_type(first, last, count);
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, EPopMode M, BackoffPolicy B, EReclaim R>
+    inline void IntrusiveMutexFreeQueue<V, M, B, R>::clear() noexcept {
+        pop_all();
     }
 
     //--------------------------------------------------------------//
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
+#include <span>
+
+#include "alloc/node_pool.h"
 #include "intrusive_queue.h"
 
 namespace Relax {
@@ -7,8 +12,17 @@ namespace Relax {
 #pragma region MutexFreeQueue
 
     //////////////////////////////////////////////////////////////////
-    // TODO: Alloc
-    template<class T>
+    /*
+     * Alloc - node allocator. Default NodePoolAllocator<T> keeps popped nodes readable (type-stable).
+     * PopMode::LockFree with Reclaim == TypeStable needs type-stable Alloc.
+     * PopMode, Reclaim - see IntrusiveMutexFreeQueue. Reclaim != TypeStable: popped nodes are retired and freed
+     * by reclamation domain, any stateless Alloc (e.g. std::allocator) is allowed.
+     */
+    template<class T,
+             class Alloc = NodePoolAllocator<T>,
+             BackoffPolicy Backoff = TAdaptiveBackoff,
+             EPopMode PopMode = EPopMode::Marked,
+             EReclaim Reclaim = EReclaim::TypeStable>
     class MutexFreeQueue {
         struct Node : TChainableBase<Node> {
             Node() = delete;
@@ -22,14 +36,19 @@ namespace Relax {
             T m_value;
         };
 
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node> node_allocator_type;
+        typedef std::allocator_traits<node_allocator_type> node_allocator_traits;
+
     public:
         typedef T value_type;
         typedef T& reference;
         typedef const T& const_reference;
-        typedef typename IntrusiveMutexFreeQueue<Node>::size_type size_type;
+        typedef Alloc allocator_type;
+        typedef typename IntrusiveMutexFreeQueue<Node, PopMode, Backoff, Reclaim>::size_type size_type;
 
     public:
         MutexFreeQueue();
+        explicit MutexFreeQueue(const allocator_type& alloc);
         ~MutexFreeQueue();
 
         MutexFreeQueue(const MutexFreeQueue& other) = delete;
@@ -48,98 +67,266 @@ namespace Relax {
         template<typename... Args>
         void emplace(Args&&... args);
 
+        // all values are pushed by single splice (one tail exchange)
+        template<class InputIt>
+        void push_range(InputIt begin, InputIt end);
+
         bool pop(value_type& ref);
 
+        // moves up to out.size() values to out by single head acquisition, returns their count
+        size_type pop_bulk(std::span<value_type> out);
+
+        // spins briefly, then parks until push
+        void pop_wait(value_type& ref);
+
+        // false on timeout
+        template<class Rep, class Period>
+        bool pop_wait_for(value_type& ref, const std::chrono::duration<Rep, Period>& timeout);
+
         // TODO: void swap(MutexFreeQueue& queue) noexcept;
 
         void clear();
 
     private:
-        IntrusiveMutexFreeQueue<Node> m_queue;
+        template<typename... Args>
+        Node* createNode(Args&&... args);
+
+        // node was never pushed
+        void destroyNode(Node* node) noexcept;
+
+        // popped node: may be still read by concurrent guarded poppers
+        void releaseNode(Node* node) noexcept;
+
+        // deleter of retired node: queue may be already destroyed
+        static void reclaimNode(void* ptr) noexcept;
+
+        // moves value of popped node to ref
+        void extractNode(Node* node, value_type& ref);
+
+    private:
+        IntrusiveMutexFreeQueue<Node, PopMode, Backoff, Reclaim> m_queue;
+
+        node_allocator_type m_alloc;
+
+        static_assert(EReclaim::TypeStable == Reclaim || node_allocator_traits::is_always_equal::value,
+                      "retired nodes are freed by default constructed allocator");
+
+        // lock-free pop reads m_next of node popped and freed by other consumer
+        static_assert(EPopMode::LockFree != PopMode || EReclaim::TypeStable != Reclaim ||
+                          IsTypeStable<node_allocator_type>,
+                      "LockFree pop WO reclamation needs type-stable Alloc (NodePoolAllocator)");
     };
 
     //--------------------------------------------------------------//
-    template<class T>
-    MutexFreeQueue<T>::MutexFreeQueue()
-      : m_queue() { }
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    MutexFreeQueue<T, A, B, M, R>::MutexFreeQueue()
+      : m_queue()
+      , m_alloc() { }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    MutexFreeQueue<T, A, B, M, R>::MutexFreeQueue(const allocator_type& alloc)
+      : m_queue()
+      , m_alloc(alloc) { }
 
     //--------------------------------------------------------------//
-    template<class T>
-    MutexFreeQueue<T>::~MutexFreeQueue() {
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    MutexFreeQueue<T, A, B, M, R>::~MutexFreeQueue() {
         clear();
     }
 
     //--------------------------------------------------------------//
-    template<class T>
-    inline bool MutexFreeQueue<T>::empty() const noexcept {
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    inline bool MutexFreeQueue<T, A, B, M, R>::empty() const noexcept {
         return m_queue.empty();
     }
 
     //--------------------------------------------------------------//
-    template<class T>
-    inline typename MutexFreeQueue<T>::size_type MutexFreeQueue<T>::size() const noexcept {
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    inline typename MutexFreeQueue<T, A, B, M, R>::size_type MutexFreeQueue<T, A, B, M, R>::size() const noexcept {
         return m_queue.size();
     }
 
     //--------------------------------------------------------------//
-    template<class T>
-    inline void MutexFreeQueue<T>::push(const value_type& value) {
-        Node* node = new Node(value);
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    inline void MutexFreeQueue<T, A, B, M, R>::push(const value_type& value) {
+        Node* node = createNode(value);
         return m_queue.push(node);
     }
 
     //--------------------------------------------------------------//
-    template<class T>
-    inline void MutexFreeQueue<T>::push(value_type&& value) {
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    inline void MutexFreeQueue<T, A, B, M, R>::push(value_type&& value) {
         return emplace(std::move(value));
     }
 
     //--------------------------------------------------------------//
-    template<class T>
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
     template<typename... Args>
-    inline void MutexFreeQueue<T>::emplace(Args&&... args) {
-        Node* node = new Node(std::forward<Args>(args)...);
+    inline void MutexFreeQueue<T, A, B, M, R>::emplace(Args&&... args) {
+        Node* node = createNode(std::forward<Args>(args)...);
         return m_queue.push(node);
     }
 
     //--------------------------------------------------------------//
-    template<class T>
-    bool MutexFreeQueue<T>::pop(value_type& ref) {
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    template<class InputIt>
+    void MutexFreeQueue<T, A, B, M, R>::push_range(InputIt begin, InputIt end) {
+        Node* first = nullptr;
+        Node* last = nullptr;
+        size_type count = 0;
+
+        try {
+            for (; begin != end; ++begin) {
+                Node* const node = createNode(*begin);
+                if (nullptr == last)
+                    first = node;
+                else
+                    last->m_next = node;
+
+                last = node;
+                ++count;
+            }
+        }
+        catch (...) {
+            while (nullptr != first) {
+                Node* const next = (first == last) ? nullptr : first->m_next;
+                destroyNode(first);
+                first = next;
+            }
+            throw;
+        }
+
+        m_queue.push_chain(first, last, count);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    bool MutexFreeQueue<T, A, B, M, R>::pop(value_type& ref) {
         Node* node = m_queue.pop();
         if (nullptr == node)
             return false;
 
+        extractNode(node, ref);
+        return true;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    typename MutexFreeQueue<T, A, B, M, R>::size_type MutexFreeQueue<T, A, B, M, R>::pop_bulk(
+        std::span<value_type> out) {
+        auto chain = m_queue.pop_chain(out.size());
+
+        size_type count = 0;
         try {
-            new (&ref) value_type(std::move(node->m_value));
+            while (Node* const node = chain.front()) {
+                out[count] = std::move(node->m_value);
+                chain.pop_front();
+                releaseNode(node);
+                ++count;
+            }
         }
         catch (...) {
-            m_queue.push(node);
+            // not moved values are returned to queue
+            m_queue.push_chain(chain.front(), chain.back(), chain.size());
             throw;
         }
 
-        delete node;
+        return count;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    void MutexFreeQueue<T, A, B, M, R>::pop_wait(value_type& ref) {
+        extractNode(m_queue.pop_wait(), ref);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    template<class Rep, class Period>
+    bool MutexFreeQueue<T, A, B, M, R>::pop_wait_for(value_type& ref,
+                                                  const std::chrono::duration<Rep, Period>& timeout) {
+        Node* node = m_queue.pop_wait_for(timeout);
+        if (nullptr == node)
+            return false;
+
+        extractNode(node, ref);
         return true;
     }
 
     //--------------------------------------------------------------//
-    template<class T>
-    void MutexFreeQueue<T>::clear() {
-        Node* val = m_queue.pop();
-        while (val) {
-            delete val;
-            val = m_queue.pop();
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    void MutexFreeQueue<T, A, B, M, R>::clear() {
+        auto chain = m_queue.pop_all();
+        while (Node* const node = chain.pop_front()) {
+            releaseNode(node);
         }
     }
 
     //--------------------------------------------------------------//
-    template<class T>
-    MutexFreeQueue<T>::Node::Node(const T& value)
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    template<typename... Args>
+    typename MutexFreeQueue<T, A, B, M, R>::Node* MutexFreeQueue<T, A, B, M, R>::createNode(Args&&... args) {
+        Node* const node = node_allocator_traits::allocate(m_alloc, 1);
+        try {
+            node_allocator_traits::construct(m_alloc, node, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            node_allocator_traits::deallocate(m_alloc, node, 1);
+            throw;
+        }
+
+        return node;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    void MutexFreeQueue<T, A, B, M, R>::destroyNode(Node* node) noexcept {
+        node_allocator_traits::destroy(m_alloc, node);
+        node_allocator_traits::deallocate(m_alloc, node, 1);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    inline void MutexFreeQueue<T, A, B, M, R>::releaseNode(Node* node) noexcept {
+        if constexpr (EReclaim::TypeStable == R)
+            destroyNode(node);
+        else
+            TReclaim<R>::retire(node, &reclaimNode);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    void MutexFreeQueue<T, A, B, M, R>::reclaimNode(void* ptr) noexcept {
+        node_allocator_type alloc;
+        Node* const node = static_cast<Node*>(ptr);
+        node_allocator_traits::destroy(alloc, node);
+        node_allocator_traits::deallocate(alloc, node, 1);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    void MutexFreeQueue<T, A, B, M, R>::extractNode(Node* node, value_type& ref) {
+        try {
+            new (&ref) value_type(std::move(node->m_value));
+        }
+        catch (...) {
+            m_queue.push(node);
+            throw;
+        }
+
+        releaseNode(node);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
+    MutexFreeQueue<T, A, B, M, R>::Node::Node(const T& value)
       : m_value(value) { }
 
     //--------------------------------------------------------------//
-    template<class T>
+    template<class T, class A, BackoffPolicy B, EPopMode M, EReclaim R>
     template<typename... Args>
-    MutexFreeQueue<T>::Node::Node(Args&&... args)
+    MutexFreeQueue<T, A, B, M, R>::Node::Node(Args&&... args)
       : m_value(std::forward<Args>(args)...) { }
 
     //////////////////////////////////////////////////////////////////
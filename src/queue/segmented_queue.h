@@ -0,0 +1,588 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <new>
+#include <type_traits>
+
+#include "common.h"
+#include "intrusive_queue.h"
+#include "sync/backoff.h"
+#include "sync/event.h"
+#include "types.h"
+
+namespace Relax {
+
+#pragma region SegmentedMutexFreeQueue
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Unbounded queue of linked segments, SegmentSize slots each.
+     *  * Producers claim slots by fetch_add of segment index, no allocation per value
+     *  * Consumers take values sequentially under head lock (Backoff - policy of its spin)
+     *  * Consumed segments are reused by producers, freed by destructor only
+     *
+     * Segment/slot generations make stale claims of reused segment harmless:
+     * claim is written only if slot isn't touched in claimed generation yet.
+     * Consumer poisons claimed but unwritten slot (producer retries with new claim).
+     */
+    template<class T, size_t SegmentSize = 256, BackoffPolicy Backoff = TAdaptiveBackoff>
+    class SegmentedMutexFreeQueue {
+        static_assert(1 < SegmentSize && SegmentSize < ((size_t)1 << 31), "");
+        static_assert(std::is_nothrow_move_constructible_v<T>, "");
+        static_assert(std::is_nothrow_destructible_v<T>, "");
+
+        // slot state: 0bGGG...GGSS, G - generation of segment, S - ESlotState
+        enum ESlotState : uint64_t {
+            Empty = 0,
+            Writing = 1,
+            Ready = 2,
+            Taken = 3
+        };
+
+        struct Slot {
+            std::atomic<uint64_t> m_state = 0;
+            alignas(T) unsigned char m_storage[sizeof(T)];
+
+            T* value() noexcept { return std::launder(reinterpret_cast<T*>(m_storage)); }
+        };
+
+        // m_next - link in list of free segments
+        struct Segment : TChainableBase<Segment> {
+            // 0bGGG...GGIII...II, G - generation (32 bit), I - claimed index (32 bit)
+            alignas(CACHELINE_SIZE) std::atomic<uint64_t> m_enqueue = 0;
+
+            // kept after consumption: stale producers can't append to consumed segment
+            alignas(CACHELINE_SIZE) std::atomic<Segment*> m_successor = nullptr;
+
+            Slot m_slots[SegmentSize];
+        };
+
+    public:
+        typedef T value_type;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef size_t size_type;
+
+    public:
+        SegmentedMutexFreeQueue();
+        ~SegmentedMutexFreeQueue();
+
+        SegmentedMutexFreeQueue(const SegmentedMutexFreeQueue& other) = delete;
+        SegmentedMutexFreeQueue(SegmentedMutexFreeQueue&& other) noexcept = delete;
+        SegmentedMutexFreeQueue& operator=(const SegmentedMutexFreeQueue& other) = delete;
+        SegmentedMutexFreeQueue& operator=(SegmentedMutexFreeQueue&& other) noexcept = delete;
+
+        bool empty() const noexcept;
+
+        size_type size() const noexcept;
+
+        void push(const value_type& value);
+
+        void push(value_type&& value);
+
+        template<typename... Args>
+        void emplace(Args&&... args);
+
+        template<class InputIt>
+        void push_range(InputIt begin, InputIt end);
+
+        bool pop(value_type& ref);
+
+        // spins briefly, then parks until push
+        void pop_wait(value_type& ref);
+
+        // false on timeout
+        template<class Rep, class Period>
+        bool pop_wait_for(value_type& ref, const std::chrono::duration<Rep, Period>& timeout);
+
+        void clear();
+
+    private:
+        // false if claim is poisoned or stale
+        template<typename... Args>
+        static bool tryWrite(Slot& slot, uint64_t generation, Args&&... args);
+
+        // tail is full: value goes to slot 0 of new segment
+        void appendSegment(Segment* tail, value_type&& value);
+
+        Segment* acquireSegment();
+
+        bool popLocked(value_type& ref);
+
+        bool spinPop(value_type& ref);
+
+        void lockHead() noexcept;
+
+        void unlockHead() noexcept;
+
+        static inline uint64_t state(uint64_t generation, ESlotState slot_state);
+
+        static inline uint64_t generationOf(uint64_t enqueue);
+
+        static inline uint64_t indexOf(uint64_t enqueue);
+
+        // tail: 0bTTTTTTTTTTTTTTTTXXX...XXX, T - ABA tag, X - 48-bit address
+        static inline Segment* tagged(Segment* ptr, uint64_t tag);
+
+        static inline Segment* untagged(Segment* ptr);
+
+        static inline uint64_t tagOf(Segment* ptr);
+
+    private:
+        static constexpr uint32_t m_tag_shift = 48;
+
+        static constexpr uintptr_t m_address_mask = ((uintptr_t)1 << m_tag_shift) - 1;
+
+        static constexpr uint64_t m_index_mask = ((uint64_t)1 << 32) - 1;
+
+        // consumer waits for producer between claim and write before poisoning
+        static constexpr uint32_t m_poison_spin_cnt = 64;
+
+        static constexpr uint32_t m_wait_spin_cnt = 128;
+
+    private:
+        alignas(CACHELINE_SIZE) std::atomic<Segment*> m_tail;
+
+        // consumer's line
+        alignas(CACHELINE_SIZE) std::atomic<bool> m_head_lock;
+
+        Segment* m_head;
+
+        size_type m_dequeue_index;
+
+        [[no_unique_address]] typename Backoff::TShared m_backoff;
+
+        alignas(CACHELINE_SIZE) std::atomic<size_type> m_size;
+
+        IntrusiveMutexFreeQueue<Segment> m_free_segments;
+
+        // consumers parked in pop_wait
+        TEventCount m_event;
+    };
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    uint64_t SegmentedMutexFreeQueue<T, S, B>::state(uint64_t generation, ESlotState slot_state) {
+        return (generation << 2) | slot_state;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    uint64_t SegmentedMutexFreeQueue<T, S, B>::generationOf(uint64_t enqueue) {
+        return enqueue >> 32;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    uint64_t SegmentedMutexFreeQueue<T, S, B>::indexOf(uint64_t enqueue) {
+        return enqueue & m_index_mask;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    typename SegmentedMutexFreeQueue<T, S, B>::Segment* SegmentedMutexFreeQueue<T, S, B>::tagged(Segment* ptr,
+                                                                                                 uint64_t tag) {
+        assert(0 == (reinterpret_cast<uintptr_t>(ptr) & ~m_address_mask));
+        return reinterpret_cast<Segment*>(reinterpret_cast<uintptr_t>(ptr) | (tag << m_tag_shift));
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    typename SegmentedMutexFreeQueue<T, S, B>::Segment* SegmentedMutexFreeQueue<T, S, B>::untagged(Segment* ptr) {
+        return reinterpret_cast<Segment*>(reinterpret_cast<uintptr_t>(ptr) & m_address_mask);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    uint64_t SegmentedMutexFreeQueue<T, S, B>::tagOf(Segment* ptr) {
+        return reinterpret_cast<uintptr_t>(ptr) >> m_tag_shift;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    SegmentedMutexFreeQueue<T, S, B>::SegmentedMutexFreeQueue()
+      : m_tail(nullptr)
+      , m_head_lock(false)
+      , m_head(new Segment())
+      , m_dequeue_index(0)
+      , m_size(0)
+      , m_free_segments()
+      , m_event() {
+        // generation 0 is state of untouched slots
+        m_head->m_enqueue.store((uint64_t)1 << 32, std::memory_order_relaxed);
+        m_tail.store(m_head, std::memory_order_release);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    SegmentedMutexFreeQueue<T, S, B>::~SegmentedMutexFreeQueue() {
+        clear();
+
+        Segment* segment = m_head;
+        while (nullptr != segment) {
+            Segment* const next = segment->m_successor.load(std::memory_order_relaxed);
+            delete segment;
+            segment = next;
+        }
+
+        while (Segment* const free_segment = m_free_segments.pop()) {
+            delete free_segment;
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    inline bool SegmentedMutexFreeQueue<T, S, B>::empty() const noexcept {
+        return 0 == m_size.load(std::memory_order_relaxed);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    inline typename SegmentedMutexFreeQueue<T, S, B>::size_type SegmentedMutexFreeQueue<T, S, B>::size()
+        const noexcept {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    inline void SegmentedMutexFreeQueue<T, S, B>::push(const value_type& value) {
+        emplace(value);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    inline void SegmentedMutexFreeQueue<T, S, B>::push(value_type&& value) {
+        emplace(std::move(value));
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    template<typename... Args>
+    void SegmentedMutexFreeQueue<T, S, B>::emplace(Args&&... args) {
+        // before claim: concurrent pop never takes size below zero.
+        // seq_cst: pairs with size check of parking consumer (free on x86 - locked op anyway)
+        m_size.fetch_add(1, std::memory_order_seq_cst);
+
+        try {
+            while (true) {
+                Segment* const tail = m_tail.load(std::memory_order_acquire);
+                Segment* const segment = untagged(tail);
+
+                const uint64_t enqueue = segment->m_enqueue.fetch_add(1, std::memory_order_relaxed);
+                const uint64_t index = indexOf(enqueue);
+
+                if (index < S) {
+                    // args are used by successful write only
+                    if (tryWrite(segment->m_slots[index], generationOf(enqueue), std::forward<Args>(args)...))
+                        break;
+
+                    continue;
+                }
+
+                Segment* const successor = segment->m_successor.load(std::memory_order_acquire);
+                if (nullptr != successor) {
+                    Segment* expected = tail;
+                    m_tail.compare_exchange_strong(expected,
+                                                   tagged(successor, tagOf(tail) + 1),
+                                                   std::memory_order_acq_rel,
+                                                   std::memory_order_relaxed);
+                    continue;
+                }
+
+                appendSegment(tail, value_type(std::forward<Args>(args)...));
+                break;
+            }
+        }
+        catch (...) {
+            // value is not published
+            m_size.fetch_sub(1, std::memory_order_relaxed);
+            throw;
+        }
+
+        // after write: woken consumer finds the value
+        m_event.notify(1);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    template<class InputIt>
+    void SegmentedMutexFreeQueue<T, S, B>::push_range(InputIt begin, InputIt end) {
+        for (; begin != end; ++begin) {
+            emplace(*begin);
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    template<typename... Args>
+    bool SegmentedMutexFreeQueue<T, S, B>::tryWrite(Slot& slot, uint64_t generation, Args&&... args) {
+        uint64_t slot_state = slot.m_state.load(std::memory_order_acquire);
+
+        // touched in claimed generation (poisoned) or claim is older than segment
+        if ((slot_state >> 2) >= generation)
+            return false;
+
+        if (!slot.m_state.compare_exchange_strong(slot_state,
+                                                  state(generation, Writing),
+                                                  std::memory_order_acquire,
+                                                  std::memory_order_relaxed))
+            return false;
+
+        try {
+            new (slot.m_storage) value_type(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            slot.m_state.store(state(generation, Taken), std::memory_order_release);
+            throw;
+        }
+
+        slot.m_state.store(state(generation, Ready), std::memory_order_release);
+        return true;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    void SegmentedMutexFreeQueue<T, S, B>::appendSegment(Segment* tail, value_type&& value) {
+        Segment* const segment = acquireSegment();
+        const uint64_t generation = generationOf(segment->m_enqueue.load(std::memory_order_relaxed));
+
+        // segment is closed: nobody else claims slot 0
+        new (segment->m_slots[0].m_storage) value_type(std::move(value));
+        segment->m_slots[0].m_state.store(state(generation, Ready), std::memory_order_relaxed);
+
+        while (true) {
+            Segment* const last = untagged(tail);
+            Segment* successor = nullptr;
+
+            if (last->m_successor.compare_exchange_strong(successor,
+                                                          segment,
+                                                          std::memory_order_release,
+                                                          std::memory_order_acquire)) {
+                m_tail.compare_exchange_strong(tail,
+                                               tagged(segment, tagOf(tail) + 1),
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_relaxed);
+                break;
+            }
+
+            // appended by other thread: help to move tail and retry at new one
+            Segment* expected = tail;
+            m_tail.compare_exchange_strong(expected,
+                                           tagged(successor, tagOf(tail) + 1),
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_relaxed);
+            tail = m_tail.load(std::memory_order_acquire);
+        }
+
+        // open for claims unless closed by consumer or touched by stale claims
+        uint64_t closed = ((generation << 32) | S);
+        segment->m_enqueue.compare_exchange_strong(closed,
+                                                   (generation << 32) | 1,
+                                                   std::memory_order_release,
+                                                   std::memory_order_relaxed);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    typename SegmentedMutexFreeQueue<T, S, B>::Segment* SegmentedMutexFreeQueue<T, S, B>::acquireSegment() {
+        Segment* segment = m_free_segments.pop();
+        if (nullptr == segment)
+            segment = new Segment();
+
+        // stale claims of previous generation see closed segment
+        const uint64_t generation = generationOf(segment->m_enqueue.load(std::memory_order_relaxed)) + 1;
+        segment->m_enqueue.store((generation << 32) | S, std::memory_order_relaxed);
+        segment->m_successor.store(nullptr, std::memory_order_relaxed);
+
+        return segment;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    bool SegmentedMutexFreeQueue<T, S, B>::pop(value_type& ref) {
+        if (empty())
+            return false;
+
+        // for simple remove of lock by optimizer
+        lockHead();
+        const bool result = popLocked(ref);
+        unlockHead();
+
+        return result;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    bool SegmentedMutexFreeQueue<T, S, B>::spinPop(value_type& ref) {
+        for (uint32_t i = 0; i < m_wait_spin_cnt; ++i) {
+            if (pop(ref))
+                return true;
+
+            CPU_PAUSE();
+        }
+
+        return false;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    void SegmentedMutexFreeQueue<T, S, B>::pop_wait(value_type& ref) {
+        bool result = spinPop(ref);
+
+        while (!result) {
+            const int32_t key = m_event.prepareWait();
+
+            // size is increased before value is written, push notifies after write
+            if (0 == m_size.load(std::memory_order_seq_cst))
+                m_event.commitWait(key);
+            else
+                m_event.cancelWait();
+
+            result = pop(ref);
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    template<class Rep, class Period>
+    bool SegmentedMutexFreeQueue<T, S, B>::pop_wait_for(value_type& ref,
+                                                        const std::chrono::duration<Rep, Period>& timeout) {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        bool result = spinPop(ref);
+
+        while (!result) {
+            const int32_t key = m_event.prepareWait();
+
+            bool in_time = true;
+            if (0 == m_size.load(std::memory_order_seq_cst))
+                in_time = m_event.commitWaitUntil(key, deadline);
+            else
+                m_event.cancelWait();
+
+            result = pop(ref);
+            if (!in_time)
+                break;
+        }
+
+        return result;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    bool SegmentedMutexFreeQueue<T, S, B>::popLocked(value_type& ref) {
+        while (true) {
+            Segment* const segment = m_head;
+
+            if (m_dequeue_index < S) {
+                uint64_t enqueue = segment->m_enqueue.load(std::memory_order_acquire);
+                uint64_t claimed = std::min<uint64_t>(indexOf(enqueue), S);
+
+                if (m_dequeue_index >= claimed) {
+                    if (nullptr == segment->m_successor.load(std::memory_order_acquire))
+                        return false;
+
+                    // left not full by concurrent appends: close it
+                    enqueue = segment->m_enqueue.fetch_add(S, std::memory_order_acq_rel);
+                    claimed = std::min<uint64_t>(indexOf(enqueue), S);
+                    if (m_dequeue_index >= claimed) {
+                        m_dequeue_index = S;
+                        continue;
+                    }
+                }
+
+                const uint64_t generation = generationOf(enqueue);
+                Slot& slot = segment->m_slots[m_dequeue_index];
+                uint64_t slot_state = slot.m_state.load(std::memory_order_acquire);
+                uint32_t spin_cnt = 0;
+
+                while (true) {
+                    if (state(generation, Ready) == slot_state) {
+                        value_type* const value = slot.value();
+                        new (&ref) value_type(std::move(*value));
+                        value->~value_type();
+
+                        ++m_dequeue_index;
+                        m_size.fetch_sub(1, std::memory_order_relaxed);
+                        return true;
+                    }
+
+                    if (state(generation, Taken) == slot_state)
+                        break;
+
+                    // producer is between claim and write
+                    if (state(generation, Writing) == slot_state || spin_cnt < m_poison_spin_cnt) {
+                        ++spin_cnt;
+                        CPU_PAUSE();
+                        slot_state = slot.m_state.load(std::memory_order_acquire);
+                        continue;
+                    }
+
+                    // poison: producer retries with new claim
+                    if (slot.m_state.compare_exchange_weak(slot_state,
+                                                           state(generation, Taken),
+                                                           std::memory_order_acquire,
+                                                           std::memory_order_acquire))
+                        break;
+                }
+
+                ++m_dequeue_index;
+                continue;
+            }
+
+            Segment* const successor = segment->m_successor.load(std::memory_order_acquire);
+            if (nullptr == successor)
+                return false;
+
+            // tail must leave segment before its reuse
+            Segment* tail = m_tail.load(std::memory_order_acquire);
+            while (untagged(tail) == segment) {
+                m_tail.compare_exchange_weak(tail,
+                                             tagged(successor, tagOf(tail) + 1),
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire);
+            }
+
+            m_head = successor;
+            m_dequeue_index = 0;
+            m_free_segments.push(segment);
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    void SegmentedMutexFreeQueue<T, S, B>::clear() {
+        lockHead();
+
+        alignas(value_type) unsigned char storage[sizeof(value_type)];
+        while (popLocked(*reinterpret_cast<value_type*>(storage))) {
+            std::launder(reinterpret_cast<value_type*>(storage))->~value_type();
+        }
+
+        unlockHead();
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    void SegmentedMutexFreeQueue<T, S, B>::lockHead() noexcept {
+        B backoff(m_backoff);
+        while (m_head_lock.load(std::memory_order_relaxed) ||
+               m_head_lock.exchange(true, std::memory_order_acquire)) {
+            backoff.pause([this] { return !m_head_lock.load(std::memory_order_relaxed); });
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t S, BackoffPolicy B>
+    void SegmentedMutexFreeQueue<T, S, B>::unlockHead() noexcept {
+        m_head_lock.store(false, std::memory_order_release);
+        B::notify(m_backoff);
+    }
+
+    //--------------------------------------------------------------//
+
+#pragma endregion SegmentedMutexFreeQueue
+
+}  // namespace Relax
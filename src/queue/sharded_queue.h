@@ -0,0 +1,171 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include "common.h"
+#include "intrusive_queue.h"
+#include "types.h"
+
+namespace Relax {
+
+#pragma region ShardedMutexFreeQueue
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * NShards IntrusiveMutexFreeQueue's under one facade.
+     *  * Thread pushes to its own home shard: producers don't share one tail
+     *  * Pop takes home shard first, then scans other shards from random one
+     *  * FIFO per shard only (relaxed globally): values of one producer are popped in push order
+     */
+    template<Chainable V,
+             size_t NShards = 16,
+             EPopMode PopMode = EPopMode::Marked,
+             BackoffPolicy Backoff = TAdaptiveBackoff>
+    class ShardedMutexFreeQueue {
+        static_assert(0 < NShards, "");
+
+        typedef IntrusiveMutexFreeQueue<V, PopMode, Backoff> shard_type;
+
+    public:
+        typedef V* pointer_type;
+        typedef V value_type;
+        typedef V& reference;
+        typedef const V& const_reference;
+        typedef size_t size_type;
+
+        static constexpr size_type m_nshards = NShards;
+
+    public:
+        ShardedMutexFreeQueue() = default;
+
+        ShardedMutexFreeQueue(const ShardedMutexFreeQueue& other) = delete;
+        ShardedMutexFreeQueue(ShardedMutexFreeQueue&& other) noexcept = delete;
+        ShardedMutexFreeQueue& operator=(const ShardedMutexFreeQueue& other) = delete;
+        ShardedMutexFreeQueue& operator=(ShardedMutexFreeQueue&& other) noexcept = delete;
+
+        bool empty() const noexcept;
+
+        size_type size() const noexcept;
+
+        void push(pointer_type ptr) noexcept;
+
+        // whole chain goes to home shard
+        void push_chain(pointer_type first, pointer_type last, size_type count) noexcept;
+
+        pointer_type pop() noexcept;
+
+        bool pop(pointer_type& ptr) noexcept;
+
+        void clear() noexcept;
+
+    private:
+        // thread-affine: threads are spread over shards by first use
+        static size_type homeShard() noexcept;
+
+        static uint32_t nextRandom() noexcept;
+
+    private:
+        std::array<shard_type, NShards> m_shards;
+    };
+
+    //--------------------------------------------------------------//
+    template<Chainable V, size_t N, EPopMode M, BackoffPolicy B>
+    typename ShardedMutexFreeQueue<V, N, M, B>::size_type ShardedMutexFreeQueue<V, N, M, B>::homeShard() noexcept {
+        static std::atomic<size_type> next_shard = 0;
+        static thread_local const size_type shard = next_shard.fetch_add(1, std::memory_order_relaxed) % N;
+        return shard;
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, size_t N, EPopMode M, BackoffPolicy B>
+    uint32_t ShardedMutexFreeQueue<V, N, M, B>::nextRandom() noexcept {
+        // xorshift32, seed must be non-zero
+        static thread_local uint32_t state = (uint32_t)((homeShard() + 1) * 2654435761u) | 1;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, size_t N, EPopMode M, BackoffPolicy B>
+    inline bool ShardedMutexFreeQueue<V, N, M, B>::empty() const noexcept {
+        for (const shard_type& shard : m_shards) {
+            if (!shard.empty())
+                return false;
+        }
+
+        return true;
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, size_t N, EPopMode M, BackoffPolicy B>
+    inline typename ShardedMutexFreeQueue<V, N, M, B>::size_type ShardedMutexFreeQueue<V, N, M, B>::size()
+        const noexcept {
+        size_type size = 0;
+        for (const shard_type& shard : m_shards) {
+            size += shard.size();
+        }
+
+        return size;
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, size_t N, EPopMode M, BackoffPolicy B>
+    inline void ShardedMutexFreeQueue<V, N, M, B>::push(pointer_type ptr) noexcept {
+        m_shards[homeShard()].push(ptr);
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, size_t N, EPopMode M, BackoffPolicy B>
+    inline void ShardedMutexFreeQueue<V, N, M, B>::push_chain(pointer_type first,
+                                                           pointer_type last,
+                                                           size_type count) noexcept {
+        m_shards[homeShard()].push_chain(first, last, count);
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, size_t N, EPopMode M, BackoffPolicy B>
+    typename ShardedMutexFreeQueue<V, N, M, B>::pointer_type ShardedMutexFreeQueue<V, N, M, B>::pop() noexcept {
+        const size_type home = homeShard();
+
+        pointer_type ptr = m_shards[home].pop();
+        if (nullptr != ptr)
+            return ptr;
+
+        // steal: random start spreads consumers of empty home shards
+        const size_type start = nextRandom() % N;
+        for (size_type i = 0; i < N; ++i) {
+            const size_type index = (start + i) % N;
+            if (home == index || m_shards[index].empty())
+                continue;
+
+            ptr = m_shards[index].pop();
+            if (nullptr != ptr)
+                return ptr;
+        }
+
+        return nullptr;
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, size_t N, EPopMode M, BackoffPolicy B>
+    inline bool ShardedMutexFreeQueue<V, N, M, B>::pop(pointer_type& ptr) noexcept {
+        ptr = pop();
+        return (nullptr != ptr);
+    }
+
+    //--------------------------------------------------------------//
+    template<Chainable V, size_t N, EPopMode M, BackoffPolicy B>
+    inline void ShardedMutexFreeQueue<V, N, M, B>::clear() noexcept {
+        for (shard_type& shard : m_shards) {
+            shard.clear();
+        }
+    }
+
+    //--------------------------------------------------------------//
+
+#pragma endregion ShardedMutexFreeQueue
+
+}  // namespace Relax
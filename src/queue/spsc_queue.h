@@ -0,0 +1,218 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+#include "common.h"
+#include "types.h"
+
+namespace Relax {
+
+#pragma region SPSCQueue
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Ring of Capacity slots for single producer and single consumer.
+     *  * Capacity - power of 2
+     *  * No RMW operations, only acquire loads and release stores
+     *  * Each side caches index of the other one, rereads it on seeming full/empty
+     *  * push spins (yields) while queue is full, try_push fails instead
+     */
+    template<class T, size_t Capacity = 1024>
+    class SPSCQueue {
+        static_assert(0 < Capacity && 0 == (Capacity & (Capacity - 1)), "Capacity must be power of 2");
+        static_assert(std::is_nothrow_move_constructible_v<T>, "");
+        static_assert(std::is_nothrow_destructible_v<T>, "");
+
+        struct Slot {
+            alignas(T) unsigned char m_storage[sizeof(T)];
+
+            T* value() noexcept { return std::launder(reinterpret_cast<T*>(m_storage)); }
+        };
+
+    public:
+        typedef T value_type;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef size_t size_type;
+
+    public:
+        SPSCQueue();
+        ~SPSCQueue();
+
+        SPSCQueue(const SPSCQueue& other) = delete;
+        SPSCQueue(SPSCQueue&& other) noexcept = delete;
+        SPSCQueue& operator=(const SPSCQueue& other) = delete;
+        SPSCQueue& operator=(SPSCQueue&& other) noexcept = delete;
+
+        bool empty() const noexcept;
+
+        size_type size() const noexcept;
+
+        static constexpr size_type capacity() noexcept { return Capacity; }
+
+        // producer side
+
+        void push(const value_type& value);
+
+        void push(value_type&& value);
+
+        template<typename... Args>
+        void emplace(Args&&... args);
+
+        bool try_push(const value_type& value);
+
+        bool try_push(value_type&& value);
+
+        template<typename... Args>
+        bool try_emplace(Args&&... args);
+
+        // consumer side
+
+        bool pop(value_type& ref);
+
+        void clear();
+
+    private:
+        static constexpr size_type m_mask = Capacity - 1;
+
+        const std::unique_ptr<Slot[]> m_slots;
+
+        // consumer's line
+        alignas(CACHELINE_SIZE) std::atomic<size_type> m_head;
+
+        size_type m_cached_tail;
+
+        // producer's line
+        alignas(CACHELINE_SIZE) std::atomic<size_type> m_tail;
+
+        size_type m_cached_head;
+    };
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    SPSCQueue<T, C>::SPSCQueue()
+      : m_slots(new Slot[C])
+      , m_head(0)
+      , m_cached_tail(0)
+      , m_tail(0)
+      , m_cached_head(0) { }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    SPSCQueue<T, C>::~SPSCQueue() {
+        clear();
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline bool SPSCQueue<T, C>::empty() const noexcept {
+        return 0 == size();
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline typename SPSCQueue<T, C>::size_type SPSCQueue<T, C>::size() const noexcept {
+        const size_type head = m_head.load(std::memory_order_acquire);
+        const size_type tail = m_tail.load(std::memory_order_acquire);
+
+        // head may be loaded before tail by other side
+        return (tail > head) ? tail - head : 0;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline void SPSCQueue<T, C>::push(const value_type& value) {
+        emplace(value);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline void SPSCQueue<T, C>::push(value_type&& value) {
+        emplace(std::move(value));
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    template<typename... Args>
+    inline void SPSCQueue<T, C>::emplace(Args&&... args) {
+        // value is built once: args may be rvalues
+        value_type value(std::forward<Args>(args)...);
+        while (!try_emplace(std::move(value))) {
+            std::this_thread::yield();
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline bool SPSCQueue<T, C>::try_push(const value_type& value) {
+        return try_emplace(value);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    inline bool SPSCQueue<T, C>::try_push(value_type&& value) {
+        return try_emplace(std::move(value));
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    template<typename... Args>
+    bool SPSCQueue<T, C>::try_emplace(Args&&... args) {
+        const size_type tail = m_tail.load(std::memory_order_relaxed);
+
+        if (C == tail - m_cached_head) {
+            m_cached_head = m_head.load(std::memory_order_acquire);
+            if (C == tail - m_cached_head)
+                return false;
+        }
+
+        // tail isn't published yet: exception leaves queue unchanged
+        new (m_slots[tail & m_mask].m_storage) value_type(std::forward<Args>(args)...);
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    bool SPSCQueue<T, C>::pop(value_type& ref) {
+        const size_type head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_cached_tail) {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cached_tail)
+                return false;
+        }
+
+        value_type* const value = m_slots[head & m_mask].value();
+        new (&ref) value_type(std::move(*value));
+        value->~value_type();
+
+        m_head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, size_t C>
+    void SPSCQueue<T, C>::clear() {
+        size_type head = m_head.load(std::memory_order_relaxed);
+        const size_type tail = m_tail.load(std::memory_order_acquire);
+
+        for (; head != tail; ++head) {
+            m_slots[head & m_mask].value()->~value_type();
+        }
+
+        m_cached_tail = tail;
+        m_head.store(tail, std::memory_order_release);
+    }
+
+    //--------------------------------------------------------------//
+
+#pragma endregion SPSCQueue
+
+}  // namespace Relax
@@ -3,7 +3,11 @@
 #include <algorithm>
 #include <queue>
 
+#include "bounded_queue.h"
 #include "queue.h"
+#include "segmented_queue.h"
+#include "sharded_queue.h"
+#include "spsc_queue.h"
 #include "test/test.h"
 
 namespace Test {
@@ -19,11 +23,13 @@ namespace Test {
         TestMutexFreeQueue& operator=(const TestMutexFreeQueue& other) = delete;
         TestMutexFreeQueue& operator=(TestMutexFreeQueue&& other) noexcept = delete;
 
-        void testPushPerThreadOrder(uint64_t sample_size, uint32_t nthreads);
+        void testPushPerThreadOrder(uint64_t sample_size, uint32_t nthreads, uint32_t batch_size = 1);
 
         void testPopPerThreadOrder(uint64_t sample_size, uint32_t nthreads);
 
-        void testPushPop(uint64_t sample_size, uint32_t nthreads);
+        // bulk_size > 1: consumers use pop_bulk
+        template<class Queue = Relax::MutexFreeQueue<value_t>>
+        void testPushPop(uint64_t sample_size, uint32_t nthreads, bool use_wait = false, uint32_t bulk_size = 1);
 
         bool checkAllValues(const std::vector<std::vector<value_t>>& values, value_t min, uint64_t sample_size);
 
@@ -59,27 +65,42 @@ namespace Test {
     }
 
     //--------------------------------------------------------------//
-    void TestMutexFreeQueue::testPushPerThreadOrder(uint64_t sample_size, uint32_t nthreads) {
+    void TestMutexFreeQueue::testPushPerThreadOrder(uint64_t sample_size, uint32_t nthreads, uint32_t batch_size) {
         sample_size = sample_size - (sample_size % nthreads);
         const uint32_t per_thread_sample_size = sample_size / nthreads;
 
         Relax::MutexFreeQueue<value_t> mfqueue;
         RunThreads(
             nthreads,
-            [&mfqueue](uint32_t thread_id, uint32_t nthreads, uint32_t per_thread_sample_size) -> int {
+            [&mfqueue](uint32_t thread_id, uint32_t nthreads, uint32_t per_thread_sample_size, uint32_t batch_size)
+                -> int {
                 (void)nthreads;
 
                 const uint64_t start = thread_id * per_thread_sample_size;
                 const uint64_t end = start + per_thread_sample_size;
                 Generator<uint64_t> g(start, 1, end);
 
-                for (uint32_t i = 0; i < per_thread_sample_size; ++i) {
-                    mfqueue.push(g.nextUp());
+                if (1 == batch_size) {
+                    for (uint32_t i = 0; i < per_thread_sample_size; ++i) {
+                        mfqueue.push(g.nextUp());
+                    }
+                }
+                else {
+                    std::vector<value_t> batch;
+                    batch.reserve(batch_size);
+                    while (!g.empty()) {
+                        batch.clear();
+                        while (!g.empty() && batch.size() < batch_size) {
+                            batch.emplace_back(g.nextUp());
+                        }
+                        mfqueue.push_range(batch.begin(), batch.end());
+                    }
                 }
 
                 return 0;
             },
-            per_thread_sample_size);
+            per_thread_sample_size,
+            batch_size);
 
         std::vector<Generator<value_t>> generators;
         for (uint32_t tid = 0; tid < nthreads; ++tid) {
@@ -157,16 +178,20 @@ namespace Test {
     }
 
     //--------------------------------------------------------------//
-    void TestMutexFreeQueue::testPushPop(uint64_t sample_size, uint32_t nthreads) {
+    template<class Queue>
+    void TestMutexFreeQueue::testPushPop(uint64_t sample_size,
+                                         uint32_t nthreads,
+                                         bool use_wait,
+                                         uint32_t bulk_size) {
         sample_size = sample_size - (sample_size % nthreads);
 
-        Relax::MutexFreeQueue<value_t> mfqueue;
+        Queue mfqueue;
 
         auto run_result = RunThreads(
             nthreads,
-            [&mfqueue](uint32_t thread_id,
-                       uint32_t nthreads,
-                       uint32_t sample_size) -> std::pair<bool, std::vector<value_t>> {
+            [&mfqueue, use_wait, bulk_size](uint32_t thread_id,
+                                            uint32_t nthreads,
+                                            uint32_t sample_size) -> std::pair<bool, std::vector<value_t>> {
                 (void)nthreads;
                 (void)thread_id;
                 constexpr uint32_t generator_offset = 1;
@@ -188,10 +213,41 @@ namespace Test {
                 else {
                     values.reserve(per_thread);
                     std::vector<value_t> prev_values(nthreads / 2, 0);
+
+                    if (1 < bulk_size) {
+                        std::vector<value_t> bulk(bulk_size);
+                        uint32_t npopped = 0;
+                        while (npopped < per_thread) {
+                            const uint32_t count = std::min(bulk_size, per_thread - npopped);
+                            const size_t size = mfqueue.pop_bulk(std::span(bulk.data(), count));
+                            if (0 == size) {
+                                std::this_thread::yield();
+                                continue;
+                            }
+
+                            result &= (size <= count);
+                            for (size_t i = 0; i < size; ++i) {
+                                const value_t value = bulk[i];
+                                const uint32_t index = (value - generator_offset) / per_thread;
+                                result &= (prev_values[index] < value);
+                                values.emplace_back(value);
+                                prev_values[index] = value;
+                            }
+                            npopped += size;
+                        }
+
+                        return {result, values};
+                    }
+
                     value_t value;
                     for (uint32_t i = 0; i < per_thread; ++i) {
-                        while (!mfqueue.pop(value)) {
-                            std::this_thread::yield();
+                        if (use_wait) {
+                            mfqueue.pop_wait(value);
+                        }
+                        else {
+                            while (!mfqueue.pop(value)) {
+                                std::this_thread::yield();
+                            }
                         }
 
                         const uint32_t index = (value - generator_offset) / per_thread;
@@ -255,6 +311,15 @@ namespace Test {
         testPushPerThreadOrder(sample_size, nthreads);
     }
 
+    //--------------------------------------------------------------//
+    TEST_F(TestMutexFreeQueue, MTPushRangePerThreadOrder_8) {
+        constexpr uint32_t sample_size = m_sample_size;
+        constexpr uint32_t nthreads = 8;
+        constexpr uint32_t batch_size = 100;
+
+        testPushPerThreadOrder(sample_size, nthreads, batch_size);
+    }
+
     //////////////////////////////////////////////////////////////////
     TEST_F(TestMutexFreeQueue, MTPopPerThreadOrder_2) {
         constexpr uint32_t sample_size = m_sample_size;
@@ -319,4 +384,921 @@ namespace Test {
         testPushPop(sample_size, nthreads);
     }
 
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestMutexFreeQueue, MTPushPopWaitPerThreadOrder_8) {
+        constexpr uint32_t sample_size = m_sample_size;
+        constexpr uint32_t nthreads = 8;
+
+        testPushPop(sample_size, nthreads, true);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMutexFreeQueue, MTPushPopWaitPerThreadOrder_1024) {
+        constexpr uint32_t sample_size = m_sample_size;
+        constexpr uint32_t nthreads = 1024;
+
+        testPushPop(sample_size, nthreads, true);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMutexFreeQueue, MTPushPopBulkPerThreadOrder_8) {
+        const uint64_t sample_size = m_sample_size;
+        constexpr uint32_t nthreads = 8;
+
+        testPushPop(sample_size, nthreads, false, 64);
+    }
+
+    //--------------------------------------------------------------//
+    // nodes are freed by hazard pointer scans while other consumers may read them
+    TEST_F(TestMutexFreeQueue, MTPushPopHazardPerThreadOrder_8) {
+        using queue_t = Relax::MutexFreeQueue<value_t,
+                                              std::allocator<value_t>,
+                                              Relax::TAdaptiveBackoff,
+                                              Relax::EPopMode::LockFree,
+                                              Relax::EReclaim::HazardPointers>;
+
+        testPushPop<queue_t>(m_sample_size, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMutexFreeQueue, MTPushPopBulkHazardPerThreadOrder_8) {
+        using queue_t = Relax::MutexFreeQueue<value_t,
+                                              std::allocator<value_t>,
+                                              Relax::TAdaptiveBackoff,
+                                              Relax::EPopMode::LockFree,
+                                              Relax::EReclaim::HazardPointers>;
+
+        testPushPop<queue_t>(m_sample_size, 8, false, 64);
+    }
+
+    //--------------------------------------------------------------//
+    // nodes are freed two epochs after pop, consumers pin epoch per pop
+    TEST_F(TestMutexFreeQueue, MTPushPopEpochPerThreadOrder_8) {
+        using queue_t = Relax::MutexFreeQueue<value_t,
+                                              std::allocator<value_t>,
+                                              Relax::TAdaptiveBackoff,
+                                              Relax::EPopMode::LockFree,
+                                              Relax::EReclaim::EpochBased>;
+
+        testPushPop<queue_t>(m_sample_size, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMutexFreeQueue, MTPushPopBulkEpochPerThreadOrder_8) {
+        using queue_t = Relax::MutexFreeQueue<value_t,
+                                              std::allocator<value_t>,
+                                              Relax::TAdaptiveBackoff,
+                                              Relax::EPopMode::LockFree,
+                                              Relax::EReclaim::EpochBased>;
+
+        testPushPop<queue_t>(m_sample_size, 8, false, 64);
+    }
+
+    //--------------------------------------------------------------//
+    // nodes are cut from huge page chunks of separate pool
+    TEST_F(TestMutexFreeQueue, MTPushPopHugePagesPerThreadOrder_8) {
+        using queue_t = Relax::MutexFreeQueue<value_t, Relax::NodePoolAllocator<value_t, Relax::THugePages>>;
+
+        testPushPop<queue_t>(m_sample_size, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMutexFreeQueue, PopBulk) {
+        Relax::MutexFreeQueue<std::string> mfqueue;
+        std::vector<std::string> bulk(4);
+
+        ASSERT_EQ(0u, mfqueue.pop_bulk(bulk));
+
+        for (uint32_t i = 0; i < 10; ++i) {
+            mfqueue.push(std::to_string(i));
+        }
+
+        // full bulks, then the rest
+        uint32_t expected = 0;
+        for (size_t expected_size : {4, 4, 2, 0}) {
+            ASSERT_EQ(expected_size, mfqueue.pop_bulk(bulk));
+            for (size_t i = 0; i < expected_size; ++i) {
+                ASSERT_EQ(std::to_string(expected++), bulk[i]);
+            }
+        }
+
+        mfqueue.push("tail");
+        ASSERT_EQ(0u, mfqueue.pop_bulk(std::span(bulk.data(), 0)));
+        ASSERT_EQ(1u, mfqueue.pop_bulk(bulk));
+        ASSERT_EQ("tail", bulk[0]);
+        ASSERT_TRUE(mfqueue.empty());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestMutexFreeQueue, PopWaitFor) {
+        using namespace std::chrono_literals;
+
+        Relax::MutexFreeQueue<value_t> mfqueue;
+        value_t value = 0;
+
+        Timestamp start = Timestamp::Now();
+        ASSERT_FALSE(mfqueue.pop_wait_for(value, 20ms));
+        ASSERT_LE(20000u, (Timestamp::Now() - start).Microseconds());
+
+        // consumer parks before push
+        auto producer = std::async(std::launch::async, [&mfqueue] {
+            std::this_thread::sleep_for(20ms);
+            mfqueue.push(42);
+        });
+
+        ASSERT_TRUE(mfqueue.pop_wait_for(value, 10s));
+        ASSERT_EQ(42u, value);
+        producer.wait();
+
+        mfqueue.push(43);
+        mfqueue.pop_wait(value);
+        ASSERT_EQ(43u, value);
+        ASSERT_TRUE(mfqueue.empty());
+    }
+
+    //////////////////////////////////////////////////////////////////
+    class TestIntrusiveMutexFreeQueue : public ::testing::Test {
+    public:
+        struct Node {
+            Node* m_next = nullptr;
+            uint64_t m_value = 0;
+        };
+
+        using value_t = uint64_t;
+
+        TestIntrusiveMutexFreeQueue() { }
+
+        TestIntrusiveMutexFreeQueue(const TestIntrusiveMutexFreeQueue& other) = delete;
+        TestIntrusiveMutexFreeQueue(TestIntrusiveMutexFreeQueue&& other) noexcept = delete;
+        TestIntrusiveMutexFreeQueue& operator=(const TestIntrusiveMutexFreeQueue& other) = delete;
+        TestIntrusiveMutexFreeQueue& operator=(TestIntrusiveMutexFreeQueue&& other) noexcept = delete;
+
+        template<Relax::EPopMode PopMode,
+                 Relax::BackoffPolicy Backoff = Relax::TAdaptiveBackoff,
+                 Relax::EReclaim Reclaim = Relax::EReclaim::TypeStable>
+        void testPushPop(uint64_t sample_size,
+                         uint32_t nproducers,
+                         uint32_t nconsumers,
+                         uint32_t chain_size = 1,
+                         bool use_pop_all = false,
+                         bool use_wait = false,
+                         uint32_t pop_chain_size = 0);
+
+    public:
+        static constexpr uint32_t m_sample_size = 2000000;
+    };
+
+    //--------------------------------------------------------------//
+    template<Relax::EPopMode PopMode, Relax::BackoffPolicy Backoff, Relax::EReclaim Reclaim>
+    void TestIntrusiveMutexFreeQueue::testPushPop(uint64_t sample_size,
+                                                  uint32_t nproducers,
+                                                  uint32_t nconsumers,
+                                                  uint32_t chain_size,
+                                                  bool use_pop_all,
+                                                  bool use_wait,
+                                                  uint32_t pop_chain_size) {
+        sample_size = sample_size - (sample_size % nproducers);
+        const uint64_t per_producer = sample_size / nproducers;
+
+        // nodes outlive the queue: type-stable memory for LockFree mode
+        std::vector<Node> nodes(sample_size);
+        for (uint64_t i = 0; i < sample_size; ++i) {
+            nodes[i].m_value = i;
+        }
+
+        Relax::IntrusiveMutexFreeQueue<Node, PopMode, Backoff, Reclaim> queue;
+        std::atomic<uint64_t> npopped = 0;
+
+        auto run_result = RunThreads(
+            nproducers + nconsumers,
+            [&](uint32_t thread_id, uint32_t nthreads) -> std::pair<bool, std::vector<value_t>> {
+                (void)nthreads;
+                bool result = true;
+                std::vector<value_t> values;
+
+                if (thread_id < nproducers) {
+                    const uint64_t start = thread_id * per_producer;
+                    const uint64_t end = start + per_producer;
+                    for (uint64_t i = start; i < end; i += chain_size) {
+                        const uint64_t count = std::min<uint64_t>(chain_size, end - i);
+                        for (uint64_t j = i + 1; j < i + count; ++j) {
+                            nodes[j - 1].m_next = &nodes[j];
+                        }
+                        queue.push_chain(&nodes[i], &nodes[i + count - 1], count);
+                    }
+                }
+                else {
+                    std::vector<value_t> prev_values(nproducers, 0);
+                    std::vector<bool> is_first(nproducers, true);
+                    auto consume = [&](Node* node) {
+                        const value_t value = node->m_value;
+                        const uint64_t index = value / per_producer;
+                        result &= (is_first[index] || prev_values[index] < value);
+                        is_first[index] = false;
+                        prev_values[index] = value;
+                        values.emplace_back(value);
+                    };
+
+                    while (npopped.load(std::memory_order_relaxed) < sample_size) {
+                        if (use_pop_all || 0 < pop_chain_size) {
+                            auto chain = use_pop_all ? queue.pop_all() : queue.pop_chain(pop_chain_size);
+                            if (chain.empty()) {
+                                std::this_thread::yield();
+                                continue;
+                            }
+
+                            npopped.fetch_add(chain.size(), std::memory_order_relaxed);
+
+                            size_t count = 0;
+                            for (Node* node : chain) {
+                                consume(node);
+                                ++count;
+                            }
+                            result &= (count == chain.size());
+                            result &= (use_pop_all || chain.size() <= pop_chain_size);
+                            continue;
+                        }
+
+                        // bounded wait: the last items may be taken by other consumers
+                        Node* node = use_wait ? queue.pop_wait_for(std::chrono::milliseconds(10)) : queue.pop();
+                        if (nullptr == node) {
+                            std::this_thread::yield();
+                            continue;
+                        }
+
+                        npopped.fetch_add(1, std::memory_order_relaxed);
+                        consume(node);
+                    }
+                }
+
+                return {result, values};
+            });
+
+        ASSERT_EQ(nullptr, queue.pop());
+        ASSERT_TRUE(queue.empty());
+
+        std::vector<value_t> all_values;
+        for (auto& thread_return : run_result.first) {
+            ASSERT_TRUE(thread_return.first);
+            all_values.insert(all_values.end(), thread_return.second.begin(), thread_return.second.end());
+        }
+
+        ASSERT_EQ(sample_size, all_values.size());
+        std::sort(all_values.begin(), all_values.end());
+        for (uint64_t i = 0; i < sample_size; ++i) {
+            ASSERT_EQ(i, all_values[i]);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopMarked_2_2) {
+        testPushPop<Relax::EPopMode::Marked>(m_sample_size, 2, 2);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopLockFree_1_1) {
+        testPushPop<Relax::EPopMode::LockFree>(m_sample_size, 1, 1);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopLockFree_2_8) {
+        testPushPop<Relax::EPopMode::LockFree>(m_sample_size, 2, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopLockFree_8_32) {
+        testPushPop<Relax::EPopMode::LockFree>(m_sample_size, 8, 32);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopHazard_2_8) {
+        testPushPop<Relax::EPopMode::LockFree, Relax::TAdaptiveBackoff, Relax::EReclaim::HazardPointers>(
+            m_sample_size, 2, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopEpoch_2_8) {
+        testPushPop<Relax::EPopMode::LockFree, Relax::TAdaptiveBackoff, Relax::EReclaim::EpochBased>(
+            m_sample_size, 2, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushChainPopMarked_8_8) {
+        testPushPop<Relax::EPopMode::Marked>(m_sample_size, 8, 8, 64);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushChainPopLockFree_8_8) {
+        testPushPop<Relax::EPopMode::LockFree>(m_sample_size, 8, 8, 64);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopAllMarked_8_4) {
+        testPushPop<Relax::EPopMode::Marked>(m_sample_size, 8, 4, 1, true);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopAllLockFree_8_4) {
+        testPushPop<Relax::EPopMode::LockFree>(m_sample_size, 8, 4, 1, true);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopChainMarked_8_4) {
+        testPushPop<Relax::EPopMode::Marked>(m_sample_size, 8, 4, 1, false, false, 32);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushChainPopChainLockFree_8_4) {
+        testPushPop<Relax::EPopMode::LockFree>(m_sample_size, 8, 4, 16, false, false, 32);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushChainPopChainHazard_8_4) {
+        testPushPop<Relax::EPopMode::LockFree, Relax::TAdaptiveBackoff, Relax::EReclaim::HazardPointers>(
+            m_sample_size, 8, 4, 16, false, false, 32);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopWaitMarked_2_8) {
+        testPushPop<Relax::EPopMode::Marked>(m_sample_size, 2, 8, 1, false, true);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopWaitLockFree_2_8) {
+        testPushPop<Relax::EPopMode::LockFree>(m_sample_size, 2, 8, 1, false, true);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushChainPopWaitLockFree_8_8) {
+        testPushPop<Relax::EPopMode::LockFree>(m_sample_size, 8, 8, 64, false, true);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopExpBackoff_8_8) {
+        testPushPop<Relax::EPopMode::Marked, Relax::TExpBackoff<>>(m_sample_size, 8, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopYieldBackoff_8_8) {
+        testPushPop<Relax::EPopMode::Marked, Relax::TYieldBackoff<>>(m_sample_size, 8, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopParkBackoff_8_32) {
+        testPushPop<Relax::EPopMode::Marked, Relax::TParkBackoff<>>(m_sample_size, 8, 32);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeQueue, MTPushPopAllParkBackoff_8_8) {
+        testPushPop<Relax::EPopMode::Marked, Relax::TParkBackoff<1>>(m_sample_size, 8, 8, 1, true);
+    }
+
+    //////////////////////////////////////////////////////////////////
+    class TestBoundedMutexFreeQueue : public ::testing::Test {
+    public:
+        using value_t = uint64_t;
+
+        TestBoundedMutexFreeQueue() { }
+
+        TestBoundedMutexFreeQueue(const TestBoundedMutexFreeQueue& other) = delete;
+        TestBoundedMutexFreeQueue(TestBoundedMutexFreeQueue&& other) noexcept = delete;
+        TestBoundedMutexFreeQueue& operator=(const TestBoundedMutexFreeQueue& other) = delete;
+        TestBoundedMutexFreeQueue& operator=(TestBoundedMutexFreeQueue&& other) noexcept = delete;
+
+        template<size_t Capacity>
+        void testPushPop(uint64_t sample_size, uint32_t nproducers, uint32_t nconsumers);
+
+    public:
+        static constexpr uint32_t m_sample_size = 2000000;
+    };
+
+    //--------------------------------------------------------------//
+    template<size_t Capacity>
+    void TestBoundedMutexFreeQueue::testPushPop(uint64_t sample_size, uint32_t nproducers, uint32_t nconsumers) {
+        sample_size = sample_size - (sample_size % nproducers);
+        const uint64_t per_producer = sample_size / nproducers;
+
+        Relax::BoundedMutexFreeQueue<value_t, Capacity> queue;
+        std::atomic<uint64_t> npopped = 0;
+
+        auto run_result = RunThreads(
+            nproducers + nconsumers,
+            [&](uint32_t thread_id, uint32_t nthreads) -> std::pair<bool, std::vector<value_t>> {
+                (void)nthreads;
+                bool result = true;
+                std::vector<value_t> values;
+
+                if (thread_id < nproducers) {
+                    const uint64_t start = thread_id * per_producer;
+                    const uint64_t end = start + per_producer;
+                    for (uint64_t i = start; i < end; ++i) {
+                        // mix blocking and failing pushes
+                        if (i & 1) {
+                            queue.push(i);
+                        }
+                        else {
+                            while (!queue.try_push(i)) {
+                                std::this_thread::yield();
+                            }
+                        }
+                    }
+                }
+                else {
+                    std::vector<value_t> prev_values(nproducers, 0);
+                    std::vector<bool> is_first(nproducers, true);
+
+                    value_t value;
+                    while (npopped.load(std::memory_order_relaxed) < sample_size) {
+                        if (!queue.pop(value)) {
+                            std::this_thread::yield();
+                            continue;
+                        }
+
+                        npopped.fetch_add(1, std::memory_order_relaxed);
+
+                        const uint64_t index = value / per_producer;
+                        result &= (is_first[index] || prev_values[index] < value);
+                        is_first[index] = false;
+                        prev_values[index] = value;
+                        values.emplace_back(value);
+                    }
+                }
+
+                return {result, values};
+            });
+
+        value_t value;
+        ASSERT_FALSE(queue.pop(value));
+        ASSERT_TRUE(queue.empty());
+
+        std::vector<value_t> all_values;
+        for (auto& thread_return : run_result.first) {
+            ASSERT_TRUE(thread_return.first);
+            all_values.insert(all_values.end(), thread_return.second.begin(), thread_return.second.end());
+        }
+
+        ASSERT_EQ(sample_size, all_values.size());
+        std::sort(all_values.begin(), all_values.end());
+        for (uint64_t i = 0; i < sample_size; ++i) {
+            ASSERT_EQ(i, all_values[i]);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestBoundedMutexFreeQueue, TryPushFull) {
+        Relax::BoundedMutexFreeQueue<std::string, 8> queue;
+        std::string value;
+
+        // several rounds to wrap slot sequences
+        for (uint32_t round = 0; round < 3; ++round) {
+            for (uint32_t i = 0; i < queue.capacity(); ++i) {
+                ASSERT_TRUE(queue.try_push(std::to_string(i)));
+            }
+            ASSERT_EQ(queue.capacity(), queue.size());
+            ASSERT_FALSE(queue.try_push("overflow"));
+
+            for (uint32_t i = 0; i < queue.capacity(); ++i) {
+                ASSERT_TRUE(queue.pop(value));
+                ASSERT_EQ(std::to_string(i), value);
+            }
+            ASSERT_FALSE(queue.pop(value));
+            ASSERT_TRUE(queue.empty());
+        }
+
+        // left for destructor
+        queue.emplace(3, 'x');
+        queue.push("tail");
+        ASSERT_EQ(2u, queue.size());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestBoundedMutexFreeQueue, MTPushPop_1_1) {
+        testPushPop<1024>(m_sample_size, 1, 1);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestBoundedMutexFreeQueue, MTPushPop_8_8) {
+        testPushPop<1024>(m_sample_size, 8, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestBoundedMutexFreeQueue, MTPushPopSmall_8_8) {
+        testPushPop<4>(m_sample_size / 8, 8, 8);
+    }
+
+    //////////////////////////////////////////////////////////////////
+    class TestSPSCQueue : public ::testing::Test {
+    public:
+        using value_t = uint64_t;
+
+        TestSPSCQueue() { }
+
+        TestSPSCQueue(const TestSPSCQueue& other) = delete;
+        TestSPSCQueue(TestSPSCQueue&& other) noexcept = delete;
+        TestSPSCQueue& operator=(const TestSPSCQueue& other) = delete;
+        TestSPSCQueue& operator=(TestSPSCQueue&& other) noexcept = delete;
+
+        template<size_t Capacity>
+        void testPushPop(uint64_t sample_size);
+
+    public:
+        static constexpr uint32_t m_sample_size = 5000000;
+    };
+
+    //--------------------------------------------------------------//
+    template<size_t Capacity>
+    void TestSPSCQueue::testPushPop(uint64_t sample_size) {
+        Relax::SPSCQueue<value_t, Capacity> queue;
+
+        auto run_result = RunThreads(2, [&](uint32_t thread_id, uint32_t nthreads) -> bool {
+            (void)nthreads;
+            bool result = true;
+
+            if (0 == thread_id) {
+                for (value_t i = 0; i < sample_size; ++i) {
+                    // mix blocking and failing pushes
+                    if (i & 1) {
+                        queue.push(i);
+                    }
+                    else {
+                        while (!queue.try_push(i)) {
+                            std::this_thread::yield();
+                        }
+                    }
+                }
+            }
+            else {
+                value_t value;
+                for (value_t i = 0; i < sample_size; ++i) {
+                    while (!queue.pop(value)) {
+                        std::this_thread::yield();
+                    }
+                    result &= (i == value);
+                }
+            }
+
+            return result;
+        });
+
+        for (bool thread_result : run_result.first) {
+            ASSERT_TRUE(thread_result);
+        }
+
+        value_t value;
+        ASSERT_FALSE(queue.pop(value));
+        ASSERT_TRUE(queue.empty());
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestSPSCQueue, TryPushFull) {
+        Relax::SPSCQueue<std::string, 8> queue;
+        std::string value;
+
+        // several rounds to wrap indices
+        for (uint32_t round = 0; round < 3; ++round) {
+            for (uint32_t i = 0; i < queue.capacity(); ++i) {
+                ASSERT_TRUE(queue.try_push(std::to_string(i)));
+            }
+            ASSERT_EQ(queue.capacity(), queue.size());
+            ASSERT_FALSE(queue.try_push("overflow"));
+
+            for (uint32_t i = 0; i < queue.capacity(); ++i) {
+                ASSERT_TRUE(queue.pop(value));
+                ASSERT_EQ(std::to_string(i), value);
+            }
+            ASSERT_FALSE(queue.pop(value));
+            ASSERT_TRUE(queue.empty());
+        }
+
+        // left for destructor
+        queue.emplace(3, 'x');
+        queue.push("tail");
+        ASSERT_EQ(2u, queue.size());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestSPSCQueue, MTPushPop) {
+        testPushPop<1024>(m_sample_size);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestSPSCQueue, MTPushPopSmall) {
+        testPushPop<2>(m_sample_size / 8);
+    }
+
+    //////////////////////////////////////////////////////////////////
+    class TestShardedMutexFreeQueue : public ::testing::Test {
+    public:
+        struct Node {
+            Node* m_next = nullptr;
+            uint64_t m_value = 0;
+        };
+
+        using value_t = uint64_t;
+
+        TestShardedMutexFreeQueue() { }
+
+        TestShardedMutexFreeQueue(const TestShardedMutexFreeQueue& other) = delete;
+        TestShardedMutexFreeQueue(TestShardedMutexFreeQueue&& other) noexcept = delete;
+        TestShardedMutexFreeQueue& operator=(const TestShardedMutexFreeQueue& other) = delete;
+        TestShardedMutexFreeQueue& operator=(TestShardedMutexFreeQueue&& other) noexcept = delete;
+
+        template<size_t NShards, Relax::EPopMode PopMode>
+        void testPushPop(uint64_t sample_size, uint32_t nproducers, uint32_t nconsumers);
+
+    public:
+        static constexpr uint32_t m_sample_size = 2000000;
+    };
+
+    //--------------------------------------------------------------//
+    template<size_t NShards, Relax::EPopMode PopMode>
+    void TestShardedMutexFreeQueue::testPushPop(uint64_t sample_size, uint32_t nproducers, uint32_t nconsumers) {
+        sample_size = sample_size - (sample_size % nproducers);
+        const uint64_t per_producer = sample_size / nproducers;
+
+        std::vector<Node> nodes(sample_size);
+        for (uint64_t i = 0; i < sample_size; ++i) {
+            nodes[i].m_value = i;
+        }
+
+        Relax::ShardedMutexFreeQueue<Node, NShards, PopMode> queue;
+        std::atomic<uint64_t> npopped = 0;
+
+        auto run_result = RunThreads(
+            nproducers + nconsumers,
+            [&](uint32_t thread_id, uint32_t nthreads) -> std::pair<bool, std::vector<value_t>> {
+                (void)nthreads;
+                bool result = true;
+                std::vector<value_t> values;
+
+                if (thread_id < nproducers) {
+                    const uint64_t start = thread_id * per_producer;
+                    const uint64_t end = start + per_producer;
+                    for (uint64_t i = start; i < end; ++i) {
+                        queue.push(&nodes[i]);
+                    }
+                }
+                else {
+                    // producer's values share shard: order is kept per producer
+                    std::vector<value_t> prev_values(nproducers, 0);
+                    std::vector<bool> is_first(nproducers, true);
+
+                    while (npopped.load(std::memory_order_relaxed) < sample_size) {
+                        Node* node = queue.pop();
+                        if (nullptr == node) {
+                            std::this_thread::yield();
+                            continue;
+                        }
+
+                        npopped.fetch_add(1, std::memory_order_relaxed);
+
+                        const value_t value = node->m_value;
+                        const uint64_t index = value / per_producer;
+                        result &= (is_first[index] || prev_values[index] < value);
+                        is_first[index] = false;
+                        prev_values[index] = value;
+                        values.emplace_back(value);
+                    }
+                }
+
+                return {result, values};
+            });
+
+        ASSERT_EQ(nullptr, queue.pop());
+        ASSERT_TRUE(queue.empty());
+
+        std::vector<value_t> all_values;
+        for (auto& thread_return : run_result.first) {
+            ASSERT_TRUE(thread_return.first);
+            all_values.insert(all_values.end(), thread_return.second.begin(), thread_return.second.end());
+        }
+
+        ASSERT_EQ(sample_size, all_values.size());
+        std::sort(all_values.begin(), all_values.end());
+        for (uint64_t i = 0; i < sample_size; ++i) {
+            ASSERT_EQ(i, all_values[i]);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestShardedMutexFreeQueue, MTPushPopMarked_4_8_8) {
+        testPushPop<4, Relax::EPopMode::Marked>(m_sample_size, 8, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestShardedMutexFreeQueue, MTPushPopLockFree_16_8_2) {
+        testPushPop<16, Relax::EPopMode::LockFree>(m_sample_size, 8, 2);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestShardedMutexFreeQueue, MTPushPopLockFree_16_64_64) {
+        testPushPop<16, Relax::EPopMode::LockFree>(m_sample_size, 64, 64);
+    }
+
+    //////////////////////////////////////////////////////////////////
+    class TestSegmentedMutexFreeQueue : public ::testing::Test {
+    public:
+        using value_t = uint64_t;
+
+        TestSegmentedMutexFreeQueue() { }
+
+        TestSegmentedMutexFreeQueue(const TestSegmentedMutexFreeQueue& other) = delete;
+        TestSegmentedMutexFreeQueue(TestSegmentedMutexFreeQueue&& other) noexcept = delete;
+        TestSegmentedMutexFreeQueue& operator=(const TestSegmentedMutexFreeQueue& other) = delete;
+        TestSegmentedMutexFreeQueue& operator=(TestSegmentedMutexFreeQueue&& other) noexcept = delete;
+
+        template<size_t SegmentSize>
+        void testPushPop(uint64_t sample_size, uint32_t nproducers, uint32_t nconsumers, bool use_wait = false);
+
+    public:
+        static constexpr uint32_t m_sample_size = 2000000;
+    };
+
+    //--------------------------------------------------------------//
+    template<size_t SegmentSize>
+    void TestSegmentedMutexFreeQueue::testPushPop(uint64_t sample_size,
+                                                  uint32_t nproducers,
+                                                  uint32_t nconsumers,
+                                                  bool use_wait) {
+        sample_size = sample_size - (sample_size % nproducers);
+        const uint64_t per_producer = sample_size / nproducers;
+
+        Relax::SegmentedMutexFreeQueue<value_t, SegmentSize> queue;
+        std::atomic<uint64_t> npopped = 0;
+
+        auto run_result = RunThreads(
+            nproducers + nconsumers,
+            [&](uint32_t thread_id, uint32_t nthreads) -> std::pair<bool, std::vector<value_t>> {
+                (void)nthreads;
+                bool result = true;
+                std::vector<value_t> values;
+
+                if (thread_id < nproducers) {
+                    const uint64_t start = thread_id * per_producer;
+                    const uint64_t end = start + per_producer;
+                    for (uint64_t i = start; i < end; ++i) {
+                        queue.push(i);
+                    }
+                }
+                else {
+                    std::vector<value_t> prev_values(nproducers, 0);
+                    std::vector<bool> is_first(nproducers, true);
+
+                    value_t value;
+                    while (npopped.load(std::memory_order_relaxed) < sample_size) {
+                        // timeout: all values may be taken by other consumers
+                        if (use_wait && !queue.pop_wait_for(value, std::chrono::milliseconds(10)))
+                            continue;
+
+                        if (!use_wait && !queue.pop(value)) {
+                            std::this_thread::yield();
+                            continue;
+                        }
+
+                        npopped.fetch_add(1, std::memory_order_relaxed);
+
+                        const uint64_t index = value / per_producer;
+                        result &= (is_first[index] || prev_values[index] < value);
+                        is_first[index] = false;
+                        prev_values[index] = value;
+                        values.emplace_back(value);
+                    }
+                }
+
+                return {result, values};
+            });
+
+        value_t value;
+        ASSERT_FALSE(queue.pop(value));
+        ASSERT_TRUE(queue.empty());
+
+        std::vector<value_t> all_values;
+        for (auto& thread_return : run_result.first) {
+            ASSERT_TRUE(thread_return.first);
+            all_values.insert(all_values.end(), thread_return.second.begin(), thread_return.second.end());
+        }
+
+        ASSERT_EQ(sample_size, all_values.size());
+        std::sort(all_values.begin(), all_values.end());
+        for (uint64_t i = 0; i < sample_size; ++i) {
+            ASSERT_EQ(i, all_values[i]);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestSegmentedMutexFreeQueue, PushPopSegments) {
+        Relax::SegmentedMutexFreeQueue<std::string, 4> queue;
+        std::string value;
+
+        // several rounds to reuse consumed segments
+        for (uint32_t round = 0; round < 3; ++round) {
+            for (uint32_t i = 0; i < 10; ++i) {
+                queue.push(std::to_string(i));
+            }
+            ASSERT_EQ(10u, queue.size());
+
+            for (uint32_t i = 0; i < 10; ++i) {
+                ASSERT_TRUE(queue.pop(value));
+                ASSERT_EQ(std::to_string(i), value);
+            }
+            ASSERT_FALSE(queue.pop(value));
+            ASSERT_TRUE(queue.empty());
+        }
+
+        // left for destructor
+        queue.emplace(3, 'x');
+        queue.push("tail");
+        ASSERT_EQ(2u, queue.size());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestSegmentedMutexFreeQueue, MTPushPop_1_1) {
+        testPushPop<256>(m_sample_size, 1, 1);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestSegmentedMutexFreeQueue, MTPushPop_8_8) {
+        testPushPop<256>(m_sample_size, 8, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestSegmentedMutexFreeQueue, MTPushPopSmall_32_8) {
+        testPushPop<2>(m_sample_size / 8, 32, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestSegmentedMutexFreeQueue, MTPushPopWait_2_8) {
+        testPushPop<256>(m_sample_size / 8, 2, 8, true);
+    }
+
+    //--------------------------------------------------------------//
+    // value is counted before it is published: concurrent pops never wrap size below zero
+    TEST_F(TestSegmentedMutexFreeQueue, MTSizeBound_8_8) {
+        constexpr uint32_t nproducers = 8;
+        constexpr uint32_t nconsumers = 8;
+        constexpr uint64_t per_producer = m_sample_size / 16;
+        constexpr uint64_t sample_size = nproducers * per_producer;
+
+        Relax::SegmentedMutexFreeQueue<value_t, 4> queue;
+        std::atomic<uint64_t> npopped = 0;
+
+        auto run_result = RunThreads(nproducers + nconsumers, [&](uint32_t thread_id, uint32_t nthreads) -> bool {
+            (void)nthreads;
+            bool result = true;
+
+            if (thread_id < nproducers) {
+                for (uint64_t i = 0; i < per_producer; ++i) {
+                    queue.push(i);
+                    result &= (queue.size() <= sample_size);
+                }
+                return result;
+            }
+
+            value_t value;
+            while (npopped.load(std::memory_order_relaxed) < sample_size) {
+                if (queue.pop(value))
+                    npopped.fetch_add(1, std::memory_order_relaxed);
+                else
+                    std::this_thread::yield();
+
+                result &= (queue.size() <= sample_size);
+            }
+
+            return result;
+        });
+
+        for (bool result : run_result.first) {
+            ASSERT_TRUE(result);
+        }
+        ASSERT_EQ(0u, queue.size());
+        ASSERT_TRUE(queue.empty());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestSegmentedMutexFreeQueue, PopWaitFor) {
+        using namespace std::chrono_literals;
+
+        Relax::SegmentedMutexFreeQueue<value_t> queue;
+        value_t value = 0;
+
+        Timestamp start = Timestamp::Now();
+        ASSERT_FALSE(queue.pop_wait_for(value, 20ms));
+        ASSERT_LE(20000u, (Timestamp::Now() - start).Microseconds());
+
+        // consumer parks before push
+        auto producer = std::async(std::launch::async, [&queue] {
+            std::this_thread::sleep_for(20ms);
+            queue.push(42);
+        });
+
+        ASSERT_TRUE(queue.pop_wait_for(value, 10s));
+        ASSERT_EQ(42u, value);
+        producer.wait();
+
+        queue.push(43);
+        queue.pop_wait(value);
+        ASSERT_EQ(43u, value);
+        ASSERT_TRUE(queue.empty());
+    }
+
 }  // namespace Test
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "reclaim.h"
+#include "test/test.h"
+
+namespace Test {
+    //////////////////////////////////////////////////////////////////
+    class BenchMemoryReclaim : public ::testing::Test {
+    public:
+        struct Object {
+            explicit Object(uint64_t value)
+              : m_value(value) { }
+
+            static void destroy(void* ptr) noexcept { delete static_cast<Object*>(ptr); }
+
+            uint64_t m_value;
+        };
+
+        // shared object read by all threads of bench iteration
+        struct TShared {
+            TShared()
+              : m_object(new Object(1)) { }
+
+            ~TShared() { delete m_object.load(std::memory_order_relaxed); }
+
+            std::atomic<Object*> m_object;
+        };
+
+        BenchMemoryReclaim() { }
+
+        BenchMemoryReclaim(const BenchMemoryReclaim& other) = delete;
+        BenchMemoryReclaim(BenchMemoryReclaim&& other) noexcept = delete;
+        BenchMemoryReclaim& operator=(const BenchMemoryReclaim& other) = delete;
+        BenchMemoryReclaim& operator=(BenchMemoryReclaim&& other) noexcept = delete;
+
+        // one guarded read of shared object: the whole reader fast path
+        template<Relax::EReclaim Reclaim>
+        static inline uint64_t readSection(const std::atomic<Object*>& shared) noexcept;
+
+        // threads only read: cost of guard without contention of writers
+        template<Relax::EReclaim Reclaim>
+        static std::pair<Duration, Duration> benchRead(uint64_t sample_size,
+                                                       uint32_t nthreads,
+                                                       uint32_t niterations);
+
+        // writers replace and retire shared object, reader reads it or (stall) holds one guard until they finish.
+        // Returns time and peak number of retired, not reclaimed objects
+        template<Relax::EReclaim Reclaim>
+        static std::pair<Duration, uint64_t> benchStall(uint64_t sample_size, uint32_t nwriters, bool stall);
+
+        static Relax::TReclaimStats& stats(Relax::EReclaim reclaim);
+
+        static void reportRead(Duration time, Duration base_time, uint64_t nreads, const char* name);
+
+        static void reportStall(std::pair<Duration, uint64_t> stat, const char* name);
+
+    public:
+        static constexpr uint32_t m_sample_size = 1000000;
+
+        static constexpr uint32_t m_nsamples = 5;
+
+        static constexpr std::array<uint32_t, 4> m_nthread_modes = {1, 2, 8, 32};
+    };
+
+    //--------------------------------------------------------------//
+    template<Relax::EReclaim Reclaim>
+    inline uint64_t BenchMemoryReclaim::readSection(const std::atomic<Object*>& shared) noexcept {
+        typename Relax::TReclaim<Reclaim>::guard_type guard;
+
+        Object* object = shared.load(std::memory_order_acquire);
+        while (!guard.protect(object, shared, object))
+            ;
+
+        return object->m_value;
+    }
+
+    //--------------------------------------------------------------//
+    template<Relax::EReclaim Reclaim>
+    std::pair<Duration, Duration> BenchMemoryReclaim::benchRead(uint64_t sample_size,
+                                                                uint32_t nthreads,
+                                                                uint32_t niterations) {
+        return BenchThreads<TShared>(
+            nthreads,
+            niterations,
+            [](uint32_t thread_id, uint32_t nthreads, TShared& shared, uint64_t sample_size) -> uint64_t {
+                (void)thread_id;
+                const uint64_t per_thread = sample_size / nthreads;
+
+                uint64_t sum = 0;
+                for (uint64_t i = 0; i < per_thread; ++i) {
+                    sum += readSection<Reclaim>(shared.m_object);
+                }
+
+                return sum;
+            },
+            sample_size);
+    }
+
+    //--------------------------------------------------------------//
+    template<Relax::EReclaim Reclaim>
+    std::pair<Duration, uint64_t> BenchMemoryReclaim::benchStall(uint64_t sample_size,
+                                                                 uint32_t nwriters,
+                                                                 bool stall) {
+        Relax::TReclaimStats& domain_stats = stats(Reclaim);
+        const uint64_t unreclaimed = domain_stats.m_unreclaimed.load(std::memory_order_relaxed);
+        domain_stats.m_peak_unreclaimed.store(unreclaimed, std::memory_order_relaxed);
+
+        TShared shared;
+        std::atomic<uint32_t> nwriting = nwriters;
+        const uint64_t per_writer = sample_size / nwriters;
+
+        auto run_result = RunThreads(nwriters + 1, [&](uint32_t thread_id, uint32_t nthreads) -> uint64_t {
+            (void)nthreads;
+            if (thread_id < nwriters) {
+                for (uint64_t i = 0; i < per_writer; ++i) {
+                    Object* const old = shared.m_object.exchange(new Object(i), std::memory_order_acq_rel);
+                    Relax::TReclaim<Reclaim>::retire(old, &Object::destroy);
+                }
+
+                nwriting.fetch_sub(1, std::memory_order_release);
+                return 0;
+            }
+
+            uint64_t sum = 0;
+            if (stall) {
+                typename Relax::TReclaim<Reclaim>::guard_type guard;
+                Object* object = shared.m_object.load(std::memory_order_acquire);
+                while (!guard.protect(object, shared.m_object, object))
+                    ;
+
+                sum = object->m_value;
+                while (0 < nwriting.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+
+                return sum;
+            }
+
+            while (0 < nwriting.load(std::memory_order_acquire)) {
+                sum += readSection<Reclaim>(shared.m_object);
+            }
+
+            return sum;
+        });
+
+        const uint64_t peak = domain_stats.m_peak_unreclaimed.load(std::memory_order_relaxed);
+        return {run_result.second, peak - unreclaimed};
+    }
+
+    //--------------------------------------------------------------//
+    Relax::TReclaimStats& BenchMemoryReclaim::stats(Relax::EReclaim reclaim) {
+        if (Relax::EReclaim::EpochBased == reclaim)
+            return Relax::EpochStats();
+
+        return Relax::HazardStats();
+    }
+
+    //--------------------------------------------------------------//
+    void BenchMemoryReclaim::reportRead(Duration time, Duration base_time, uint64_t nreads, const char* name) {
+        std::cout << std::fixed << std::setprecision(2);
+        const auto width = std::setw(15);
+
+        const double read_ns = (double)time.Microseconds() * 1000 / nreads;
+        const double overhead_ns = ((double)time.Microseconds() - (double)base_time.Microseconds()) * 1000 / nreads;
+
+        std::cout << std::string(name) + " ns/read: " << width << read_ns << "   overhead: " << width << overhead_ns
+                  << std::endl;
+    }
+
+    //--------------------------------------------------------------//
+    void BenchMemoryReclaim::reportStall(std::pair<Duration, uint64_t> stat, const char* name) {
+        std::cout << std::fixed << std::setprecision(2);
+        const auto width = std::setw(15);
+
+        std::cout << std::string(name) + " time: " << width << stat.first.StrMilli() << "   peak unreclaimed: "
+                  << width << stat.second << " objects, " << (double)(stat.second * sizeof(Object)) / 1024 << " KiB"
+                  << std::endl;
+    }
+
+    //////////////////////////////////////////////////////////////////
+    // reader fast path: plain load vs hazard pointer publish + fence + reload vs epoch pin/unpin
+    TEST_F(BenchMemoryReclaim, read_fast_path) {
+        for (uint32_t nthreads : m_nthread_modes) {
+            std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
+            const uint64_t size = m_sample_size - (m_sample_size % nthreads);
+
+            auto base_stat = benchRead<Relax::EReclaim::TypeStable>(size, nthreads, m_nsamples);
+            auto hp_stat = benchRead<Relax::EReclaim::HazardPointers>(size, nthreads, m_nsamples);
+            auto ebr_stat = benchRead<Relax::EReclaim::EpochBased>(size, nthreads, m_nsamples);
+
+            reportRead(base_stat.first, base_stat.first, size, "TS ");
+            reportRead(hp_stat.first, base_stat.first, size, "HP ");
+            reportRead(ebr_stat.first, base_stat.first, size, "EBR");
+        }
+    }
+
+    //--------------------------------------------------------------//
+    // retired memory held while one reader stalls in its read section: bounded for HP, everything for EBR
+    TEST_F(BenchMemoryReclaim, stalled_reader) {
+        for (uint32_t nwriters : m_nthread_modes) {
+            std::cout << "NWriters: " << std::setw(8) << nwriters << std::endl;
+            const uint64_t size = m_sample_size - (m_sample_size % nwriters);
+
+            reportStall(benchStall<Relax::EReclaim::HazardPointers>(size, nwriters, false), "HP          ");
+            reportStall(benchStall<Relax::EReclaim::HazardPointers>(size, nwriters, true), "HP  stalled ");
+            reportStall(benchStall<Relax::EReclaim::EpochBased>(size, nwriters, false), "EBR         ");
+            reportStall(benchStall<Relax::EReclaim::EpochBased>(size, nwriters, true), "EBR stalled ");
+        }
+
+        Relax::THazardDomain::reclaim();
+        Relax::TEpochDomain::reclaim();
+    }
+
+}  // namespace Test
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <vector>
+
+#include "common.h"
+#include "stats.h"
+#include "types.h"
+
+namespace Relax {
+
+#pragma region TEpochDomain
+
+    //////////////////////////////////////////////////////////////////
+    inline TReclaimStats& EpochStats() {
+        static TReclaimStats stats;
+        return stats;
+    }
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Global epoch-based reclamation domain.
+     *  * Reader pins: announces global epoch in its record (one RMW per outermost TEpochGuard), no cost
+     *    per read node
+     *  * Epoch advances when all pinned threads announce the current one: nodes retired two epochs ago
+     *    are unreachable for all readers
+     *  * retire - node goes to limbo list of its epoch (3 lists per thread, indexed by epoch % 3).
+     *    Each m_advance_period retires thread tries to advance epoch and frees its expired limbo lists
+     *    (piggy-backed reclamation), reclaim() does the same on demand (e.g. by background thread)
+     *  * Stalled pinned thread stops advance: retired nodes of all threads stay in limbo
+     *  * Record is reused after thread exit with its not reclaimed nodes
+     */
+    class TEpochDomain {
+        friend class TEpochGuard;
+
+    public:
+        typedef void (*deleter_type)(void*) noexcept;
+
+        // retires between attempts to advance epoch
+        static constexpr uint32_t m_advance_period = 64;
+
+    private:
+        struct TRetired {
+            void* m_ptr;
+
+            deleter_type m_deleter;
+        };
+
+        struct TLimbo {
+            uint64_t m_epoch = 0;
+
+            std::vector<TRetired> m_nodes;
+        };
+
+        struct alignas(CACHELINE_SIZE) Record {
+            // epoch announced by pinned owner, m_unpinned otherwise
+            std::atomic<uint64_t> m_pinned;
+
+            // immutable after record is published
+            Record* m_next = nullptr;
+
+            std::atomic<bool> m_active = true;
+
+            // owner only: depth of nested guards
+            uint32_t m_nesting = 0;
+
+            // retired since last advance attempt
+            uint32_t m_nretired = 0;
+
+            // retired since last stats update
+            uint64_t m_nunaccounted = 0;
+
+            std::array<TLimbo, 3> m_limbo;
+
+            // spare buffer: drained limbo list
+            std::vector<TRetired> m_reclaimed;
+        };
+
+        struct Owner {
+            ~Owner();
+
+            Record* m_record = nullptr;
+        };
+
+    public:
+        TEpochDomain(const TEpochDomain& other) = delete;
+        TEpochDomain(TEpochDomain&& other) noexcept = delete;
+        TEpochDomain& operator=(const TEpochDomain& other) = delete;
+        TEpochDomain& operator=(TEpochDomain&& other) noexcept = delete;
+
+        // ptr must be unreachable for new readers: it is freed when all current readers unpin
+        static void retire(void* ptr, deleter_type deleter);
+
+        template<class T>
+        static void retire(T* ptr);
+
+        // tries to advance epoch, frees expired limbo lists of current thread
+        static void reclaim();
+
+        static uint64_t epoch() noexcept;
+
+    private:
+        TEpochDomain() = default;
+
+        // never destroyed: retired nodes outlive static objects
+        static TEpochDomain& instance();
+
+        static Record& record();
+
+        Record& acquireRecord();
+
+        inline void pin(Record& owned) noexcept;
+
+        inline void unpin(Record& owned) noexcept;
+
+        // returns global epoch after attempt
+        uint64_t tryAdvance() noexcept;
+
+        // frees limbo lists retired two epochs before epoch
+        void collect(Record& owned, uint64_t epoch);
+
+        void freeLimbo(Record& owned, TLimbo& limbo);
+
+    private:
+        static constexpr uint64_t m_unpinned = UINT64_MAX;
+
+        alignas(CACHELINE_SIZE) std::atomic<uint64_t> m_epoch = 0;
+
+        alignas(CACHELINE_SIZE) std::atomic<Record*> m_records = nullptr;
+
+        static thread_local Owner m_owner;
+    };
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Pin of current thread (RAII), nests: only the outermost guard announces epoch.
+     * Nodes reachable after pin are not freed until guard is destroyed.
+     * protect - interface of THazardPointer, always succeeds: the whole critical section is protected.
+     */
+    class TEpochGuard {
+    public:
+        TEpochGuard() noexcept;
+        ~TEpochGuard();
+
+        TEpochGuard(const TEpochGuard& other) = delete;
+        TEpochGuard(TEpochGuard&& other) noexcept = delete;
+        TEpochGuard& operator=(const TEpochGuard& other) = delete;
+        TEpochGuard& operator=(TEpochGuard&& other) noexcept = delete;
+
+        template<class T>
+        inline bool protect(const void*, const std::atomic<T*>&, T*&) noexcept {
+            return true;
+        }
+
+        inline void reset() noexcept { }
+
+    private:
+        TEpochDomain::Record& m_record;
+    };
+
+    //--------------------------------------------------------------//
+    inline thread_local TEpochDomain::Owner TEpochDomain::m_owner;
+
+    //--------------------------------------------------------------//
+    inline TEpochDomain& TEpochDomain::instance() {
+        static TEpochDomain* const domain = new TEpochDomain();
+        return *domain;
+    }
+
+    //--------------------------------------------------------------//
+    inline TEpochDomain::Owner::~Owner() {
+        if (nullptr == m_record)
+            return;
+
+        assert(0 == m_record->m_nesting);
+
+        // retired nodes are inherited by the next owner of record
+        m_record->m_active.store(false, std::memory_order_release);
+    }
+
+    //--------------------------------------------------------------//
+    inline TEpochDomain::Record& TEpochDomain::record() {
+        Owner& owner = m_owner;
+        if (nullptr == owner.m_record)
+            owner.m_record = &instance().acquireRecord();
+
+        return *owner.m_record;
+    }
+
+    //--------------------------------------------------------------//
+    inline TEpochDomain::Record& TEpochDomain::acquireRecord() {
+        for (Record* record = m_records.load(std::memory_order_acquire); nullptr != record;
+             record = record->m_next) {
+            bool active = false;
+            if (!record->m_active.load(std::memory_order_relaxed) &&
+                record->m_active.compare_exchange_strong(active,
+                                                         true,
+                                                         std::memory_order_acquire,
+                                                         std::memory_order_relaxed))
+                return *record;
+        }
+
+        Record* const record = new Record();
+        record->m_pinned.store(m_unpinned, std::memory_order_relaxed);
+
+        Record* head = m_records.load(std::memory_order_relaxed);
+        do {
+            record->m_next = head;
+        } while (!m_records.compare_exchange_weak(head,
+                                                  record,
+                                                  std::memory_order_release,
+                                                  std::memory_order_relaxed));
+
+        return *record;
+    }
+
+    //--------------------------------------------------------------//
+    inline uint64_t TEpochDomain::epoch() noexcept {
+        return instance().m_epoch.load(std::memory_order_relaxed);
+    }
+
+    //--------------------------------------------------------------//
+    void TEpochDomain::pin(Record& owned) noexcept {
+        if (0 != owned.m_nesting++)
+            return;
+
+        // seq_cst RMW: either tryAdvance sees the pin, or this thread sees nodes unlinked before advance.
+        // Epoch older than global one only delays next advance
+        const uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+        owned.m_pinned.exchange(epoch, std::memory_order_seq_cst);
+    }
+
+    //--------------------------------------------------------------//
+    void TEpochDomain::unpin(Record& owned) noexcept {
+        assert(0 < owned.m_nesting);
+
+        if (0 == --owned.m_nesting)
+            owned.m_pinned.store(m_unpinned, std::memory_order_release);
+    }
+
+    //--------------------------------------------------------------//
+    inline uint64_t TEpochDomain::tryAdvance() noexcept {
+        uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+
+        for (Record* record = m_records.load(std::memory_order_acquire); nullptr != record;
+             record = record->m_next) {
+            // acquire: pairs with release of unpin, reads of unpinned reader happen before frees
+            const uint64_t pinned = record->m_pinned.load(std::memory_order_seq_cst);
+            if (m_unpinned != pinned && epoch != pinned)
+                return epoch;
+        }
+
+        // fails if advanced by other thread: epoch is reloaded
+        if (m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst))
+            ++epoch;
+
+        return epoch;
+    }
+
+    //--------------------------------------------------------------//
+    inline void TEpochDomain::retire(void* ptr, deleter_type deleter) {
+        assert(nullptr != ptr);
+
+        TEpochDomain& domain = instance();
+        Record& owned = record();
+
+        // read after ptr is unlinked: readers that see ptr announce this epoch or older one
+        const uint64_t epoch = domain.m_epoch.load(std::memory_order_seq_cst);
+
+        TLimbo& limbo = owned.m_limbo[epoch % owned.m_limbo.size()];
+        if (epoch != limbo.m_epoch) {
+            // list of epoch - 3 or older: expired
+            domain.freeLimbo(owned, limbo);
+            limbo.m_epoch = epoch;
+        }
+
+        limbo.m_nodes.push_back(TRetired{ptr, deleter});
+        ++owned.m_nunaccounted;
+
+        if (m_advance_period <= ++owned.m_nretired) {
+            owned.m_nretired = 0;
+            domain.collect(owned, domain.tryAdvance());
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class T>
+    void TEpochDomain::retire(T* ptr) {
+        retire(ptr, [](void* node) noexcept { delete static_cast<T*>(node); });
+    }
+
+    //--------------------------------------------------------------//
+    inline void TEpochDomain::reclaim() {
+        TEpochDomain& domain = instance();
+        domain.collect(record(), domain.tryAdvance());
+    }
+
+    //--------------------------------------------------------------//
+    inline void TEpochDomain::collect(Record& owned, uint64_t epoch) {
+        EpochStats().onRetired(owned.m_nunaccounted);
+        owned.m_nunaccounted = 0;
+
+        for (TLimbo& limbo : owned.m_limbo) {
+            if (limbo.m_epoch + 2 <= epoch)
+                freeLimbo(owned, limbo);
+        }
+    }
+
+    //--------------------------------------------------------------//
+    inline void TEpochDomain::freeLimbo(Record& owned, TLimbo& limbo) {
+        if (limbo.m_nodes.empty())
+            return;
+
+        // deleter may retire: list is moved out before frees, limbo takes spare buffer
+        std::vector<TRetired> nodes;
+        nodes.swap(limbo.m_nodes);
+        limbo.m_nodes.swap(owned.m_reclaimed);
+
+        for (const TRetired& node : nodes) {
+            node.m_deleter(node.m_ptr);
+        }
+
+        EpochStats().onReclaimed(nodes.size());
+
+        nodes.clear();
+        owned.m_reclaimed.swap(nodes);
+    }
+
+    //--------------------------------------------------------------//
+    inline TEpochGuard::TEpochGuard() noexcept
+      : m_record(TEpochDomain::record()) {
+        TEpochDomain::instance().pin(m_record);
+    }
+
+    //--------------------------------------------------------------//
+    inline TEpochGuard::~TEpochGuard() {
+        TEpochDomain::instance().unpin(m_record);
+    }
+
+#pragma endregion TEpochDomain
+
+}  // namespace Relax
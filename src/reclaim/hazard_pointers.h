@@ -0,0 +1,316 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <vector>
+
+#include "common.h"
+#include "stats.h"
+#include "types.h"
+
+namespace Relax {
+
+#pragma region THazardDomain
+
+    //////////////////////////////////////////////////////////////////
+    inline TReclaimStats& HazardStats() {
+        static TReclaimStats stats;
+        return stats;
+    }
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Global hazard pointer domain.
+     *  * Thread owns record of m_nslots hazard slots and retire list. Record is reused after thread exit
+     *    with its not reclaimed nodes: no scan at exit, deleters may use destroyed thread-locals
+     *  * retire - node is appended to retire list of thread, list is scanned when it exceeds twice number
+     *    of all slots: scan frees at least half of list (amortized O(1) per retire)
+     *  * scan - collects all published hazards, frees not protected nodes
+     */
+    class THazardDomain {
+        friend class THazardPointer;
+
+    public:
+        typedef void (*deleter_type)(void*) noexcept;
+
+        // hazard slots per thread
+        static constexpr uint32_t m_nslots = 4;
+
+        // min retire list length to scan
+        static constexpr size_t m_min_scan = 64;
+
+    private:
+        struct TRetired {
+            void* m_ptr;
+
+            deleter_type m_deleter;
+        };
+
+        struct alignas(CACHELINE_SIZE) Record {
+            std::array<std::atomic<const void*>, m_nslots> m_slots = {};
+
+            // immutable after record is published
+            Record* m_next = nullptr;
+
+            std::atomic<bool> m_active = true;
+
+            // owner only: bit per acquired slot
+            uint32_t m_used = 0;
+
+            std::vector<TRetired> m_retired;
+
+            // retired since last scan
+            uint64_t m_nretired = 0;
+
+            // buffers of scan
+            std::vector<const void*> m_hazards;
+
+            std::vector<TRetired> m_reclaimed;
+
+            // deleter of scan retires: no nested scan
+            bool m_scanning = false;
+        };
+
+        struct Owner {
+            ~Owner();
+
+            Record* m_record = nullptr;
+        };
+
+    public:
+        THazardDomain(const THazardDomain& other) = delete;
+        THazardDomain(THazardDomain&& other) noexcept = delete;
+        THazardDomain& operator=(const THazardDomain& other) = delete;
+        THazardDomain& operator=(THazardDomain&& other) noexcept = delete;
+
+        // ptr is freed by deleter when no hazard pointer protects it
+        static void retire(void* ptr, deleter_type deleter);
+
+        template<class T>
+        static void retire(T* ptr);
+
+        // scans retire list of current thread now
+        static void reclaim();
+
+    private:
+        THazardDomain() = default;
+
+        // never destroyed: retired nodes outlive static objects
+        static THazardDomain& instance();
+
+        static Record& record();
+
+        Record& acquireRecord();
+
+        void scan(Record& record);
+
+        size_t scanThreshold() const noexcept;
+
+    private:
+        alignas(CACHELINE_SIZE) std::atomic<Record*> m_records = nullptr;
+
+        std::atomic<size_t> m_nrecords = 0;
+
+        static thread_local Owner m_owner;
+    };
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Hazard slot of current thread (RAII), at most THazardDomain::m_nslots per thread:
+     *    while (!hazard.protect(node_of(head), m_head, head)) ;   // node_of(head) is safe to read now
+     */
+    class THazardPointer {
+    public:
+        THazardPointer() noexcept;
+        ~THazardPointer();
+
+        THazardPointer(const THazardPointer& other) = delete;
+        THazardPointer(THazardPointer&& other) noexcept = delete;
+        THazardPointer& operator=(const THazardPointer& other) = delete;
+        THazardPointer& operator=(THazardPointer&& other) noexcept = delete;
+
+        // publishes ptr, then checks that src still holds expected (ptr was reachable after publish).
+        // false: expected is reloaded, ptr is not protected
+        template<class T>
+        inline bool protect(const void* ptr, const std::atomic<T*>& src, T*& expected) noexcept;
+
+        inline void reset() noexcept;
+
+    private:
+        THazardDomain::Record& m_record;
+
+        uint32_t m_index;
+    };
+
+    //--------------------------------------------------------------//
+    inline thread_local THazardDomain::Owner THazardDomain::m_owner;
+
+    //--------------------------------------------------------------//
+    inline THazardDomain& THazardDomain::instance() {
+        static THazardDomain* const domain = new THazardDomain();
+        return *domain;
+    }
+
+    //--------------------------------------------------------------//
+    inline THazardDomain::Owner::~Owner() {
+        if (nullptr == m_record)
+            return;
+
+        assert(0 == m_record->m_used);
+
+        // retired nodes are inherited by the next owner of record
+        m_record->m_active.store(false, std::memory_order_release);
+    }
+
+    //--------------------------------------------------------------//
+    inline THazardDomain::Record& THazardDomain::record() {
+        Owner& owner = m_owner;
+        if (nullptr == owner.m_record)
+            owner.m_record = &instance().acquireRecord();
+
+        return *owner.m_record;
+    }
+
+    //--------------------------------------------------------------//
+    inline THazardDomain::Record& THazardDomain::acquireRecord() {
+        for (Record* record = m_records.load(std::memory_order_acquire); nullptr != record;
+             record = record->m_next) {
+            bool active = false;
+            if (!record->m_active.load(std::memory_order_relaxed) &&
+                record->m_active.compare_exchange_strong(active,
+                                                         true,
+                                                         std::memory_order_acquire,
+                                                         std::memory_order_relaxed))
+                return *record;
+        }
+
+        Record* const record = new Record();
+        m_nrecords.fetch_add(1, std::memory_order_relaxed);
+
+        Record* head = m_records.load(std::memory_order_relaxed);
+        do {
+            record->m_next = head;
+        } while (!m_records.compare_exchange_weak(head,
+                                                  record,
+                                                  std::memory_order_release,
+                                                  std::memory_order_relaxed));
+
+        return *record;
+    }
+
+    //--------------------------------------------------------------//
+    inline size_t THazardDomain::scanThreshold() const noexcept {
+        return std::max<size_t>(m_min_scan, 2 * m_nslots * m_nrecords.load(std::memory_order_relaxed));
+    }
+
+    //--------------------------------------------------------------//
+    inline void THazardDomain::retire(void* ptr, deleter_type deleter) {
+        assert(nullptr != ptr);
+
+        THazardDomain& domain = instance();
+        Record& owned = record();
+
+        owned.m_retired.push_back(TRetired{ptr, deleter});
+        ++owned.m_nretired;
+
+        if (domain.scanThreshold() <= owned.m_retired.size() && !owned.m_scanning)
+            domain.scan(owned);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T>
+    void THazardDomain::retire(T* ptr) {
+        retire(ptr, [](void* node) noexcept { delete static_cast<T*>(node); });
+    }
+
+    //--------------------------------------------------------------//
+    inline void THazardDomain::reclaim() {
+        instance().scan(record());
+    }
+
+    //--------------------------------------------------------------//
+    inline void THazardDomain::scan(Record& owned) {
+        TReclaimStats& stats = HazardStats();
+        stats.onRetired(owned.m_nretired);
+        owned.m_nretired = 0;
+
+        if (owned.m_retired.empty() || owned.m_scanning)
+            return;
+
+        // retired nodes are unreachable: hazard published before this point is seen below,
+        // later protect fails its check of source
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        owned.m_hazards.clear();
+        for (Record* record = m_records.load(std::memory_order_acquire); nullptr != record;
+             record = record->m_next) {
+            for (const std::atomic<const void*>& slot : record->m_slots) {
+                // acquire: pairs with release of reset, reads of node by protector happen before its free
+                const void* const hazard = slot.load(std::memory_order_acquire);
+                if (nullptr != hazard)
+                    owned.m_hazards.push_back(hazard);
+            }
+        }
+
+        std::sort(owned.m_hazards.begin(), owned.m_hazards.end());
+
+        // protected nodes stay in list
+        const auto is_protected = [&](const TRetired& node) {
+            return std::binary_search(owned.m_hazards.begin(), owned.m_hazards.end(), node.m_ptr);
+        };
+        const auto reclaimed = std::partition(owned.m_retired.begin(), owned.m_retired.end(), is_protected);
+        owned.m_reclaimed.assign(reclaimed, owned.m_retired.end());
+        owned.m_retired.erase(reclaimed, owned.m_retired.end());
+
+        owned.m_scanning = true;
+        for (const TRetired& node : owned.m_reclaimed) {
+            node.m_deleter(node.m_ptr);
+        }
+        owned.m_scanning = false;
+
+        stats.onReclaimed(owned.m_reclaimed.size());
+    }
+
+    //--------------------------------------------------------------//
+    inline THazardPointer::THazardPointer() noexcept
+      : m_record(THazardDomain::record())
+      , m_index(0) {
+        // lowest free slot
+        assert(m_record.m_used != (1u << THazardDomain::m_nslots) - 1);
+        while (m_record.m_used & (1u << m_index)) {
+            ++m_index;
+        }
+
+        m_record.m_used |= 1u << m_index;
+    }
+
+    //--------------------------------------------------------------//
+    inline THazardPointer::~THazardPointer() {
+        reset();
+        m_record.m_used &= ~(1u << m_index);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T>
+    bool THazardPointer::protect(const void* ptr, const std::atomic<T*>& src, T*& expected) noexcept {
+        // seq_cst store then load: either scan sees hazard, or this check sees that ptr is unlinked
+        m_record.m_slots[m_index].store(ptr, std::memory_order_seq_cst);
+
+        T* const actual = src.load(std::memory_order_seq_cst);
+        if (actual == expected)
+            return true;
+
+        expected = actual;
+        return false;
+    }
+
+    //--------------------------------------------------------------//
+    void THazardPointer::reset() noexcept {
+        m_record.m_slots[m_index].store(nullptr, std::memory_order_release);
+    }
+
+#pragma endregion THazardDomain
+
+}  // namespace Relax
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+
+#include "epoch.h"
+#include "hazard_pointers.h"
+
+namespace Relax {
+
+#pragma region Reclaim
+
+    //////////////////////////////////////////////////////////////////
+    // memory reclamation of lock-free container nodes
+    enum class EReclaim {
+        // popped nodes are never freed while container is in use (e.g. NodePoolAllocator)
+        TypeStable,
+        // popped node is freed by scan of retire list when no hazard pointer protects it: fence per read node
+        HazardPointers,
+        // popped node is freed two epochs later: one RMW per read section, stalled reader holds all retired nodes
+        EpochBased,
+    };
+
+    //////////////////////////////////////////////////////////////////
+    // guard of type-stable nodes: protects nothing, costs nothing
+    struct TNoReclaimGuard {
+        template<class T>
+        inline bool protect(const void*, const std::atomic<T*>&, T*&) noexcept {
+            return true;
+        }
+
+        inline void reset() noexcept { }
+    };
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Reclamation policy of container read path:
+     *    typename TReclaim<R>::guard_type guard;
+     *    while (!guard.protect(node_of(head), m_head, head)) ;     // node is safe to read until guard dies
+     *    TReclaim<R>::retire(node, deleter);                      // after node is unlinked
+     */
+    template<EReclaim Reclaim>
+    struct TReclaim;
+
+    //--------------------------------------------------------------//
+    template<>
+    struct TReclaim<EReclaim::TypeStable> {
+        typedef TNoReclaimGuard guard_type;
+
+        // nobody reads unlinked node: freed at once
+        static inline void retire(void* ptr, void (*deleter)(void*) noexcept) { deleter(ptr); }
+    };
+
+    //--------------------------------------------------------------//
+    template<>
+    struct TReclaim<EReclaim::HazardPointers> {
+        typedef THazardPointer guard_type;
+
+        static inline void retire(void* ptr, void (*deleter)(void*) noexcept) {
+            THazardDomain::retire(ptr, deleter);
+        }
+    };
+
+    //--------------------------------------------------------------//
+    template<>
+    struct TReclaim<EReclaim::EpochBased> {
+        typedef TEpochGuard guard_type;
+
+        static inline void retire(void* ptr, void (*deleter)(void*) noexcept) {
+            TEpochDomain::retire(ptr, deleter);
+        }
+    };
+
+#pragma endregion Reclaim
+
+}  // namespace Relax
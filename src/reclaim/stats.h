@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+
+#include "types.h"
+
+namespace Relax {
+
+    //////////////////////////////////////////////////////////////////
+    // counters of reclamation domain, updated in batches by reclamation passes
+    struct TReclaimStats {
+        // nodes passed to retire
+        std::atomic<uint64_t> m_retired = 0;
+
+        std::atomic<uint64_t> m_reclaimed = 0;
+
+        // reclamation passes: hazard scans, epoch collections
+        std::atomic<uint64_t> m_scans = 0;
+
+        // retired, not reclaimed
+        std::atomic<uint64_t> m_unreclaimed = 0;
+
+        // max of m_unreclaimed, sampled by passes
+        std::atomic<uint64_t> m_peak_unreclaimed = 0;
+
+        inline void onRetired(uint64_t count) noexcept;
+
+        inline void onReclaimed(uint64_t count) noexcept;
+    };
+
+    //--------------------------------------------------------------//
+    void TReclaimStats::onRetired(uint64_t count) noexcept {
+        if (0 == count)
+            return;
+
+        m_retired.fetch_add(count, std::memory_order_relaxed);
+        const uint64_t unreclaimed = m_unreclaimed.fetch_add(count, std::memory_order_relaxed) + count;
+
+        uint64_t peak = m_peak_unreclaimed.load(std::memory_order_relaxed);
+        while (peak < unreclaimed &&
+               !m_peak_unreclaimed.compare_exchange_weak(peak, unreclaimed, std::memory_order_relaxed))
+            ;
+    }
+
+    //--------------------------------------------------------------//
+    void TReclaimStats::onReclaimed(uint64_t count) noexcept {
+        m_reclaimed.fetch_add(count, std::memory_order_relaxed);
+        m_unreclaimed.fetch_sub(count, std::memory_order_relaxed);
+        m_scans.fetch_add(1, std::memory_order_relaxed);
+    }
+
+}  // namespace Relax
@@ -0,0 +1,322 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+#include "epoch.h"
+#include "hazard_pointers.h"
+#include "test/test.h"
+
+namespace Test {
+    //////////////////////////////////////////////////////////////////
+    class TestHazardPointers : public ::testing::Test {
+    public:
+        struct Object {
+            explicit Object(uint64_t value)
+              : m_value(value) { }
+
+            ~Object() {
+                m_alive.store(false, std::memory_order_relaxed);
+                m_nfreed.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            uint64_t m_value;
+
+            std::atomic<bool> m_alive = true;
+
+            static inline std::atomic<uint64_t> m_nfreed = 0;
+        };
+
+        TestHazardPointers() { }
+
+        TestHazardPointers(const TestHazardPointers& other) = delete;
+        TestHazardPointers(TestHazardPointers&& other) noexcept = delete;
+        TestHazardPointers& operator=(const TestHazardPointers& other) = delete;
+        TestHazardPointers& operator=(TestHazardPointers&& other) noexcept = delete;
+
+        // writers replace shared object and retire the old one, readers protect and read it
+        void testReplace(uint32_t nwriters, uint32_t nreaders, uint32_t nrounds);
+
+    public:
+        static constexpr uint32_t m_nrounds = 200000;
+    };
+
+    //--------------------------------------------------------------//
+    void TestHazardPointers::testReplace(uint32_t nwriters, uint32_t nreaders, uint32_t nrounds) {
+        std::atomic<Object*> shared = new Object(0);
+        std::atomic<uint32_t> nwriting = nwriters;
+        const uint64_t nfreed = Object::m_nfreed.load();
+
+        auto run_result = RunThreads(nwriters + nreaders, [&](uint32_t thread_id, uint32_t nthreads) -> bool {
+            (void)nthreads;
+            bool result = true;
+
+            if (thread_id < nwriters) {
+                for (uint32_t i = 1; i <= nrounds; ++i) {
+                    Object* const old = shared.exchange(new Object(i), std::memory_order_acq_rel);
+                    Relax::THazardDomain::retire(old);
+                }
+
+                Relax::THazardDomain::reclaim();
+                nwriting.fetch_sub(1, std::memory_order_release);
+                return result;
+            }
+
+            Relax::THazardPointer hazard;
+            while (0 < nwriting.load(std::memory_order_acquire)) {
+                Object* object = shared.load(std::memory_order_acquire);
+                while (!hazard.protect(object, shared, object))
+                    ;
+
+                // freed object is never seen
+                result &= object->m_alive.load(std::memory_order_relaxed);
+                result &= (object->m_value <= nrounds);
+                hazard.reset();
+            }
+
+            return result;
+        });
+
+        for (bool thread_result : run_result.first) {
+            ASSERT_TRUE(thread_result);
+        }
+
+        // last reclaim of writer keeps at most one node per reader
+        ASSERT_LE(nfreed + (uint64_t)nwriters * (nrounds - nreaders), Object::m_nfreed.load());
+        delete shared.load();
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestHazardPointers, RetireReclaim) {
+        const uint64_t nfreed = Object::m_nfreed.load();
+
+        Relax::THazardDomain::retire(new Object(1));
+        Relax::THazardDomain::retire(new Object(2));
+        Relax::THazardDomain::reclaim();
+
+        ASSERT_EQ(nfreed + 2, Object::m_nfreed.load());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestHazardPointers, ProtectedIsNotReclaimed) {
+        const uint64_t nfreed = Object::m_nfreed.load();
+        Object* const object = new Object(1);
+        std::atomic<Object*> shared = object;
+
+        Relax::THazardPointer hazard;
+        Object* expected = object;
+        ASSERT_TRUE(hazard.protect(object, shared, expected));
+
+        shared.store(nullptr);
+        Relax::THazardDomain::retire(object);
+        Relax::THazardDomain::reclaim();
+        ASSERT_EQ(nfreed, Object::m_nfreed.load());
+        ASSERT_TRUE(object->m_alive.load());
+
+        hazard.reset();
+        Relax::THazardDomain::reclaim();
+        ASSERT_EQ(nfreed + 1, Object::m_nfreed.load());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestHazardPointers, ProtectFailsOnChangedSource) {
+        Object first(1);
+        Object second(2);
+        std::atomic<Object*> shared = &second;
+
+        Relax::THazardPointer hazard;
+        Object* expected = &first;
+        ASSERT_FALSE(hazard.protect(&first, shared, expected));
+        ASSERT_EQ(&second, expected);
+        ASSERT_TRUE(hazard.protect(&second, shared, expected));
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestHazardPointers, AmortizedScan) {
+        const Relax::TReclaimStats& stats = Relax::HazardStats();
+        const uint64_t nscans = stats.m_scans.load();
+        const uint64_t nreclaimed = stats.m_reclaimed.load();
+
+        constexpr uint32_t nretired = 100000;
+        for (uint32_t i = 0; i < nretired; ++i) {
+            Relax::THazardDomain::retire(new Object(i));
+        }
+
+        // at most one scan per m_min_scan retires, not scanned tail is shorter than scan threshold
+        ASSERT_LT(0u, stats.m_scans.load() - nscans);
+        ASSERT_GE(nretired / Relax::THazardDomain::m_min_scan, stats.m_scans.load() - nscans);
+        ASSERT_LE(nretired / 2, stats.m_reclaimed.load() - nreclaimed);
+
+        Relax::THazardDomain::reclaim();
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestHazardPointers, MTReplace_1_8) {
+        testReplace(1, 8, m_nrounds);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestHazardPointers, MTReplace_8_8) {
+        testReplace(8, 8, m_nrounds);
+    }
+
+
+    //////////////////////////////////////////////////////////////////
+    class TestEpochReclaim : public ::testing::Test {
+    public:
+        using Object = TestHazardPointers::Object;
+
+        // record of current thread may be inherited with retired nodes of exited thread: they are freed first
+        TestEpochReclaim() {
+            Relax::TEpochDomain::reclaim();
+            Relax::TEpochDomain::reclaim();
+        }
+
+        TestEpochReclaim(const TestEpochReclaim& other) = delete;
+        TestEpochReclaim(TestEpochReclaim&& other) noexcept = delete;
+        TestEpochReclaim& operator=(const TestEpochReclaim& other) = delete;
+        TestEpochReclaim& operator=(TestEpochReclaim&& other) noexcept = delete;
+
+        // writers replace shared object and retire the old one, readers pin and read it several times
+        void testReplace(uint32_t nwriters, uint32_t nreaders, uint32_t nrounds);
+
+    public:
+        static constexpr uint32_t m_nrounds = 200000;
+    };
+
+    //--------------------------------------------------------------//
+    void TestEpochReclaim::testReplace(uint32_t nwriters, uint32_t nreaders, uint32_t nrounds) {
+        std::atomic<Object*> shared = new Object(0);
+        std::atomic<uint32_t> nwriting = nwriters;
+        const uint64_t nfreed = Object::m_nfreed.load();
+
+        auto run_result = RunThreads(nwriters + nreaders, [&](uint32_t thread_id, uint32_t nthreads) -> bool {
+            (void)nthreads;
+            bool result = true;
+
+            if (thread_id < nwriters) {
+                for (uint32_t i = 1; i <= nrounds; ++i) {
+                    Object* const old = shared.exchange(new Object(i), std::memory_order_acq_rel);
+                    Relax::TEpochDomain::retire(old);
+                }
+
+                nwriting.fetch_sub(1, std::memory_order_release);
+                return result;
+            }
+
+            while (0 < nwriting.load(std::memory_order_acquire)) {
+                Relax::TEpochGuard guard;
+
+                // objects seen inside of one pin are never freed, even when replaced
+                for (uint32_t i = 0; i < 4; ++i) {
+                    Object* const object = shared.load(std::memory_order_acquire);
+                    result &= object->m_alive.load(std::memory_order_relaxed);
+                    result &= (object->m_value <= nrounds);
+                }
+            }
+
+            return result;
+        });
+
+        for (bool thread_result : run_result.first) {
+            ASSERT_TRUE(thread_result);
+        }
+
+        // epochs advanced while writers were retiring
+        ASSERT_LT(nfreed, Object::m_nfreed.load());
+        delete shared.load();
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestEpochReclaim, RetireReclaim) {
+        const uint64_t nfreed = Object::m_nfreed.load();
+        const uint64_t epoch = Relax::TEpochDomain::epoch();
+
+        Relax::TEpochDomain::retire(new Object(1));
+        Relax::TEpochDomain::retire(new Object(2));
+
+        // nothing is pinned: each reclaim advances epoch, nodes are freed two epochs after retire
+        Relax::TEpochDomain::reclaim();
+        Relax::TEpochDomain::reclaim();
+
+        ASSERT_LE(epoch + 2, Relax::TEpochDomain::epoch());
+        ASSERT_EQ(nfreed + 2, Object::m_nfreed.load());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestEpochReclaim, PinnedIsNotReclaimed) {
+        const uint64_t nfreed = Object::m_nfreed.load();
+        Object* const object = new Object(1);
+
+        {
+            Relax::TEpochGuard guard;
+            const uint64_t epoch = Relax::TEpochDomain::epoch();
+
+            Relax::TEpochDomain::retire(object);
+            for (uint32_t i = 0; i < 4; ++i) {
+                Relax::TEpochDomain::reclaim();
+            }
+
+            // pinned epoch stops advance after one step
+            ASSERT_GE(epoch + 1, Relax::TEpochDomain::epoch());
+            ASSERT_EQ(nfreed, Object::m_nfreed.load());
+            ASSERT_TRUE(object->m_alive.load());
+        }
+
+        Relax::TEpochDomain::reclaim();
+        Relax::TEpochDomain::reclaim();
+        ASSERT_EQ(nfreed + 1, Object::m_nfreed.load());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestEpochReclaim, NestedGuards) {
+        const uint64_t nfreed = Object::m_nfreed.load();
+
+        {
+            Relax::TEpochGuard outer;
+            {
+                Relax::TEpochGuard inner;
+            }
+
+            // destroyed inner guard does not unpin
+            Relax::TEpochDomain::retire(new Object(1));
+            for (uint32_t i = 0; i < 4; ++i) {
+                Relax::TEpochDomain::reclaim();
+            }
+            ASSERT_EQ(nfreed, Object::m_nfreed.load());
+        }
+
+        Relax::TEpochDomain::reclaim();
+        Relax::TEpochDomain::reclaim();
+        ASSERT_EQ(nfreed + 1, Object::m_nfreed.load());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestEpochReclaim, AmortizedAdvance) {
+        const Relax::TReclaimStats& stats = Relax::EpochStats();
+        const uint64_t nreclaimed = stats.m_reclaimed.load();
+        const uint64_t epoch = Relax::TEpochDomain::epoch();
+
+        constexpr uint32_t nretired = 100000;
+        for (uint32_t i = 0; i < nretired; ++i) {
+            Relax::TEpochDomain::retire(new Object(i));
+        }
+
+        // one advance per m_advance_period retires, limbo keeps at most 3 periods
+        ASSERT_LE(epoch + nretired / Relax::TEpochDomain::m_advance_period - 1, Relax::TEpochDomain::epoch());
+        ASSERT_LE(nretired - 3 * Relax::TEpochDomain::m_advance_period, stats.m_reclaimed.load() - nreclaimed);
+
+        Relax::TEpochDomain::reclaim();
+        Relax::TEpochDomain::reclaim();
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestEpochReclaim, MTReplace_1_8) {
+        testReplace(1, 8, m_nrounds);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestEpochReclaim, MTReplace_8_8) {
+        testReplace(8, 8, m_nrounds);
+    }
+
+}  // namespace Test
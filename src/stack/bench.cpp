@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+
+#include <mutex>
+
+#include "stack.h"
+#include "test/test.h"
+
+namespace Test {
+    //////////////////////////////////////////////////////////////////
+    template<class T>
+    class SillyMutexStack {
+        struct Node {
+            Node* m_next;
+            T m_value;
+
+            template<typename... Args>
+            Node(Args&&... args)
+              : m_next(nullptr)
+              , m_value(std::forward<Args>(args)...) { }
+        };
+
+    public:
+        typedef T value_type;
+
+        SillyMutexStack()
+          : m_head(nullptr)
+          , m_mutex() { }
+        ~SillyMutexStack() { clear(); }
+
+        template<typename... Args>
+        void push(Args&&... args) {
+            Node* node = new Node(std::forward<Args>(args)...);
+            std::unique_lock<std::mutex> g(m_mutex);
+            node->m_next = m_head;
+            m_head = node;
+        }
+
+        bool pop(T& ref) {
+            std::unique_lock<std::mutex> g(m_mutex);
+            if (nullptr == m_head)
+                return false;
+
+            Node* node = m_head;
+            m_head = m_head->m_next;
+            g.unlock();
+
+            new (&ref) T(std::move(node->m_value));
+            delete node;
+            return true;
+        }
+
+        void clear() {
+            T ret;
+            while (pop(ret))
+                ;
+        }
+
+    private:
+        Node* m_head;
+
+        std::mutex m_mutex;
+    };
+
+    //////////////////////////////////////////////////////////////////
+    class BenchMutexFreeStack : public ::testing::Test {
+    public:
+        using value_t = uint32_t;
+
+        using stack_t = Relax::MutexFreeStack<value_t>;
+
+        using no_elimination_stack_t =
+            Relax::MutexFreeStack<value_t, Relax::NodePoolAllocator<value_t>, Relax::TAdaptiveBackoff, 0>;
+
+        BenchMutexFreeStack() { }
+
+        BenchMutexFreeStack(const BenchMutexFreeStack& other) = delete;
+        BenchMutexFreeStack(BenchMutexFreeStack&& other) noexcept = delete;
+        BenchMutexFreeStack& operator=(const BenchMutexFreeStack& other) = delete;
+        BenchMutexFreeStack& operator=(BenchMutexFreeStack&& other) noexcept = delete;
+
+        // Pop: each thread pops its pushes after all of them
+        template<class T, bool Pop>
+        static std::pair<Duration, Duration> benchSeq(uint64_t sample_size, uint32_t nthreads, uint32_t niterations);
+
+        // each thread pushes and pops by turns: stack stays nearly empty
+        template<class T>
+        static std::pair<Duration, Duration> benchMixed(uint64_t sample_size,
+                                                        uint32_t nthreads,
+                                                        uint32_t niterations);
+
+        static void report(std::pair<Duration, Duration> lfstat,
+                           std::pair<Duration, Duration> std_stat,
+                           const char* lf_name = "MF   ",
+                           const char* std_name = "Mutex");
+
+    public:
+        static constexpr uint32_t m_sample_size = 1000000;
+
+        static constexpr uint32_t m_nsamples = 5;
+
+        static constexpr std::array<uint32_t, 5> m_nthread_modes = {1, 2, 8, 32, 1024};
+    };
+
+    //--------------------------------------------------------------//
+    template<class T, bool Pop>
+    std::pair<Duration, Duration> BenchMutexFreeStack::benchSeq(uint64_t sample_size,
+                                                                uint32_t nthreads,
+                                                                uint32_t niterations) {
+        return BenchThreads<T>(
+            nthreads,
+            niterations,
+            [](uint32_t thread_id, uint32_t nthreads, T& stack, uint32_t sample_size) -> int {
+                const uint32_t per_thread = sample_size / nthreads;
+
+                const uint32_t start = thread_id * per_thread;
+                Generator<uint32_t> g(start, 1, start + per_thread);
+
+                while (!g.empty()) {
+                    stack.push(g.get());
+                }
+
+                if constexpr (Pop) {
+                    value_t ret;
+                    for (uint32_t i = 0; i < per_thread; ++i) {
+                        stack.pop(ret);
+                    }
+                }
+
+                return 0;
+            },
+            sample_size);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T>
+    std::pair<Duration, Duration> BenchMutexFreeStack::benchMixed(uint64_t sample_size,
+                                                                  uint32_t nthreads,
+                                                                  uint32_t niterations) {
+        return BenchThreads<T>(
+            nthreads,
+            niterations,
+            [](uint32_t thread_id, uint32_t nthreads, T& stack, uint32_t sample_size) -> int {
+                const uint32_t per_thread = sample_size / nthreads;
+
+                const uint32_t start = thread_id * per_thread;
+                Generator<uint32_t> g(start, 1, start + per_thread);
+
+                value_t ret;
+                while (!g.empty()) {
+                    stack.push(g.get());
+                    stack.pop(ret);
+                }
+
+                return 0;
+            },
+            sample_size);
+    }
+
+    //--------------------------------------------------------------//
+    void BenchMutexFreeStack::report(std::pair<Duration, Duration> lfstat,
+                                     std::pair<Duration, Duration> std_stat,
+                                     const char* lf_name,
+                                     const char* std_name) {
+        std::cout << std::fixed << std::setprecision(2) << std::setw(6);
+        const auto width = std::setw(15);
+
+        const double lf_time_μs = (double)lfstat.first.Microseconds();
+        const double std_time_μs = (double)std_stat.first.Microseconds();
+        const double std_diff = ((std_time_μs / lf_time_μs) - 1) * 100;
+
+        std::cout << std::string(lf_name) + " time: " << width << lfstat.first.StrMilli() << "   dev: " << width
+                  << lfstat.second.StrMilli() << std::endl;
+        std::cout << std::string(std_name) + " time: " << width << std_stat.first.StrMilli() << "   dev: " << width
+                  << std_stat.second.StrMilli() << width << " rel imp: " << (std_diff > 0 ? '+' : ' ')
+                  << std::setprecision(2) << std_diff << "%" << std::endl;
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(BenchMutexFreeStack, seq_push) {
+        for (uint32_t nthreads : m_nthread_modes) {
+            std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
+            const uint64_t size = m_sample_size - (m_sample_size % nthreads);
+
+            auto lfstat = benchSeq<stack_t, false>(size, nthreads, m_nsamples);
+            auto std_stat = benchSeq<SillyMutexStack<value_t>, false>(size, nthreads, m_nsamples);
+
+            report(lfstat, std_stat);
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchMutexFreeStack, seq_push_pop) {
+        for (uint32_t nthreads : m_nthread_modes) {
+            std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
+            const uint64_t size = m_sample_size - (m_sample_size % nthreads);
+
+            auto lfstat = benchSeq<stack_t, true>(size, nthreads, m_nsamples);
+            auto std_stat = benchSeq<SillyMutexStack<value_t>, true>(size, nthreads, m_nsamples);
+
+            report(lfstat, std_stat);
+        }
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(BenchMutexFreeStack, mixed_push_pop) {
+        for (uint32_t nthreads : m_nthread_modes) {
+            std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
+            const uint64_t size = m_sample_size - (m_sample_size % nthreads);
+
+            auto lfstat = benchMixed<stack_t>(size, nthreads, m_nsamples);
+            auto std_stat = benchMixed<SillyMutexStack<value_t>>(size, nthreads, m_nsamples);
+
+            report(lfstat, std_stat);
+        }
+    }
+
+    //--------------------------------------------------------------//
+    // elimination vs plain CAS retry of head
+    TEST_F(BenchMutexFreeStack, mixed_push_pop_elimination) {
+        for (uint32_t nthreads : m_nthread_modes) {
+            std::cout << "NThread: " << std::setw(9) << nthreads << std::endl;
+            const uint64_t size = m_sample_size - (m_sample_size % nthreads);
+
+            auto elim_stat = benchMixed<stack_t>(size, nthreads, m_nsamples);
+            auto cas_stat = benchMixed<no_elimination_stack_t>(size, nthreads, m_nsamples);
+
+            report(elim_stat, cas_stat, "Elim ", "CAS  ");
+        }
+    }
+
+}  // namespace Test
@@ -1,11 +1,14 @@
 #pragma once
 
-#include <immintrin.h>
-
-#include <algorithm>
+#include <array>
 #include <atomic>
+#include <cassert>
 
 #include "common.h"
+#include "reclaim/reclaim.h"
+#include "sync/atomic.h"
+#include "sync/backoff.h"
+#include "types.h"
 
 namespace Relax {
 
@@ -13,10 +16,26 @@ namespace Relax {
 
     //////////////////////////////////////////////////////////////////
     /*
+     * Treiber stack: push and pop by CAS of ABA-tagged head, no locks.
+     * Popped nodes may still be read by concurrent poppers: node memory must stay readable
+     * (type-stable) while the stack is in use, or Reclaim != EReclaim::TypeStable: pop guards head node
+     * before it is read (see reclaim/reclaim.h), popped nodes may be freed after TReclaim<Reclaim>::retire.
+     * Backoff - policy of pause after failed CAS, see sync/backoff.h
      *
+     * Elimination: after failed CAS push offers node in random slot of NEliminationSlots and waits briefly,
+     * pop after failed CAS takes offered node from random slot. Collided push and pop don't touch head.
+     * Uncontended push/pop don't touch slots. NEliminationSlots = 0 - no elimination.
      */
-    template<Chainable V>
+    template<Chainable V,
+             BackoffPolicy Backoff = TAdaptiveBackoff,
+             size_t NEliminationSlots = 8,
+             EReclaim Reclaim = EReclaim::TypeStable>
     class IntrusiveMutexFreeStack {
+        struct TEliminationSlot {
+            // node offered by push, nullptr - empty
+            alignas(CACHELINE_SIZE) std::atomic<V*> m_offer = nullptr;
+        };
+
     public:
         typedef V* pointer_type;
         typedef V value_type;
@@ -43,284 +62,226 @@ namespace Relax {
         // TODO: void swap(IntrusiveMutexFreeStack& stack) noexcept;
 
     private:
-        inline void setPopPauseCnt(uint32_t old, uint32_t actual);
+        // true if node is taken by pop
+        bool eliminatePush(pointer_type ptr) noexcept;
+
+        pointer_type eliminatePop() noexcept;
 
-        inline bool markHead(pointer_type& head);
+        static uint32_t nextRandom() noexcept;
 
-        static inline bool isMarked(pointer_type ptr);
+        // head: 0bTTTTTTTTTTTTTTTTXXX...XXX, T - ABA tag, X - 48-bit address
+        static inline pointer_type tagged(pointer_type ptr, uint64_t tag);
 
-        static inline pointer_type marked(pointer_type ptr);
+        static inline pointer_type untagged(pointer_type ptr);
 
-        pointer_type lockHead() noexcept;
+        static inline uint64_t tagOf(pointer_type ptr);
+
+    private:
+        typedef typename TReclaim<Reclaim>::guard_type guard_type;
+
+        static constexpr uint32_t m_tag_shift = 48;
+
+        static constexpr uintptr_t m_address_mask = ((uintptr_t)1 << m_tag_shift) - 1;
+
+        static_assert(sizeof(uintptr_t) == sizeof(uint64_t), "tagged head requires 64-bit pointers");
+
+        // pauses of offered push before withdraw
+        static constexpr uint32_t m_elimination_spin_cnt = 64;
 
     private:
         alignas(CACHELINE_SIZE) std::atomic<V*> m_head;
 
+        [[no_unique_address]] typename Backoff::TShared m_backoff;
+
         // TODO:
         alignas(CACHELINE_SIZE) std::atomic<size_t> m_size;
 
-        alignas(CACHELINE_SIZE) std::atomic<uint32_t> m_pop_pause_cnt = 1;
+        std::array<TEliminationSlot, NEliminationSlots> m_elimination;
     };
 
-    //--------------------------------------------------------------//
-    template<Chainable V>
-    void IntrusiveMutexFreeStack<T>::setPopPauseCnt(uint32_t old, uint32_t actual) {
-        if (actual <= old) {
-            m_pop_pause_cnt.store(std::max(1u, old - 1), std::memory_order_relaxed);
-        }
-        else {
-            m_pop_pause_cnt.store(actual, std::memory_order_relaxed);
-        }
-    }
-
     //-----------------------------------------------------------------------//
-    template<Chainable V>
-    bool IntrusiveMutexFreeStack<T>::markHead(pointer_type& head) {
-        return m_head.compare_exchange_strong(head,
-                                              marked(head),
-                                              std::memory_order_acq_rel,
-                                              std::memory_order_relaxed);
+    template<Chainable V, BackoffPolicy B, size_t N, EReclaim R>
+    typename IntrusiveMutexFreeStack<V, B, N, R>::pointer_type IntrusiveMutexFreeStack<V, B, N, R>::tagged(
+        pointer_type ptr,
+        uint64_t tag) {
+        assert(0 == (reinterpret_cast<uintptr_t>(ptr) & ~m_address_mask));
+        return reinterpret_cast<pointer_type>(reinterpret_cast<uintptr_t>(ptr) | (tag << m_tag_shift));
     }
 
     //-----------------------------------------------------------------------//
-    template<Chainable V>
-    bool IntrusiveMutexFreeStack<T>::isMarked(pointer_type ptr) {
-        return reinterpret_cast<uintptr_t>(ptr) & 0b1;
+    template<Chainable V, BackoffPolicy B, size_t N, EReclaim R>
+    typename IntrusiveMutexFreeStack<V, B, N, R>::pointer_type IntrusiveMutexFreeStack<V, B, N, R>::untagged(
+        pointer_type ptr) {
+        return reinterpret_cast<pointer_type>(reinterpret_cast<uintptr_t>(ptr) & m_address_mask);
     }
 
     //-----------------------------------------------------------------------//
-    template<Chainable V>
-    typename IntrusiveMutexFreeStack<T>::pointer_type IntrusiveMutexFreeStack<T>::marked(pointer_type ptr) {
-        return reinterpret_cast<pointer_type>(reinterpret_cast<uintptr_t>(ptr) | 0b1);
+    template<Chainable V, BackoffPolicy B, size_t N, EReclaim R>
+    uint64_t IntrusiveMutexFreeStack<V, B, N, R>::tagOf(pointer_type ptr) {
+        return reinterpret_cast<uintptr_t>(ptr) >> m_tag_shift;
     }
 
     //--------------------------------------------------------------//
-    template<Chainable V>
-    IntrusiveMutexFreeStack<T>::IntrusiveMutexFreeStack()
+    template<Chainable V, BackoffPolicy B, size_t N, EReclaim R>
+    IntrusiveMutexFreeStack<V, B, N, R>::IntrusiveMutexFreeStack()
       : m_head(nullptr)
       , m_size(0) { }
 
     //--------------------------------------------------------------//
-    template<Chainable V>
-    inline bool IntrusiveMutexFreeStack<T>::empty() const noexcept {
-        return 0 == m_size.load(std::memory_order_relaxed);
+    template<Chainable V, BackoffPolicy B, size_t N, EReclaim R>
+    inline bool IntrusiveMutexFreeStack<V, B, N, R>::empty() const noexcept {
+        return nullptr == untagged(m_head.load(std::memory_order_relaxed));
     }
 
     //--------------------------------------------------------------//
-    template<Chainable V>
-    inline typename IntrusiveMutexFreeStack<T>::size_type IntrusiveMutexFreeStack<T>::size() const noexcept {
+    template<Chainable V, BackoffPolicy B, size_t N, EReclaim R>
+    inline typename IntrusiveMutexFreeStack<V, B, N, R>::size_type IntrusiveMutexFreeStack<V, B, N, R>::size()
+        const noexcept {
         return m_size.load(std::memory_order_relaxed);
     }
 
     //--------------------------------------------------------------//
-    template<Chainable V>
-    typename IntrusiveMutexFreeStack<T>::pointer_type IntrusiveMutexFreeStack<T>::lockHead() noexcept {
-        uint32_t pop_pause_cnt = 0;
-        const uint32_t old_pop_pause_cnt = m_pop_pause_cnt.load(std::memory_order_relaxed);
-        pointer_type head = m_head.load(std::memory_order_relaxed);
-
-        while ((nullptr != head) && (isMarked(head) || (!markHead(head)))) {
-            if (0 == pop_pause_cnt) {
-                pop_pause_cnt = old_pop_pause_cnt;
-                for (uint32_t i = 0; i < old_pop_pause_cnt; ++i)
-                    CPU_PAUSE();
-            }
-            else {
-                CPU_PAUSE();
-                ++pop_pause_cnt;
-            }
-
-            head = m_head.load(std::memory_order_relaxed);
-        }
-
-        setPopPauseCnt(old_pop_pause_cnt, pop_pause_cnt);
-
-        return head;
-    }
-
-    //--------------------------------------------------------------//
-    template<Chainable V>
-    inline void IntrusiveMutexFreeStack<T>::push(pointer_type ptr) noexcept {
+    template<Chainable V, BackoffPolicy B, size_t N, EReclaim R>
+    inline void IntrusiveMutexFreeStack<V, B, N, R>::push(pointer_type ptr) noexcept {
         if (nullptr == ptr)
             return;
 
-        // __atomic_store_n(&ptr->m_next, nullptr, __ATOMIC_RELEASE);
-
-        pointer_type const head = lockHead();
-
-        __atomic_store_n(&ptr->m_next, head, __ATOMIC_RELAXED);
-
-        m_head.store(ptr, std::memory_order_release);
+        // before node is published: concurrent pop never takes size below zero
+        m_size.fetch_add(1, std::memory_order_relaxed);
 
-        // m_size.fetch_add(1, std::memory_order_relaxed);
-    }
-
-    //--------------------------------------------------------------//
-    template<Chainable V>
-    inline typename IntrusiveMutexFreeStack<T>::pointer_type IntrusiveMutexFreeStack<T>::pop() noexcept {
-        pointer_type const head = lockHead();
-
-        if (nullptr == head)
-            return nullptr;
+        pointer_type head = m_head.load(std::memory_order_relaxed);
+        NAtomic::store(&ptr->m_next, untagged(head), std::memory_order_relaxed);
 
-        pointer_type const next = __atomic_load_n(&head->m_next, __ATOMIC_RELAXED);
+        if (m_head.compare_exchange_weak(head,
+                                         tagged(ptr, tagOf(head) + 1),
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed))
+            return;
 
-        m_head.store(next, std::memory_order_release);
+        // contention: collide with pop or pause
+        B backoff(m_backoff);
+        do {
+            if (eliminatePush(ptr))
+                return;
 
-        __atomic_store_n(&head->m_next, nullptr, __ATOMIC_RELAXED);
+            backoff.retry();
 
-        return head;
+            head = m_head.load(std::memory_order_relaxed);
+            NAtomic::store(&ptr->m_next, untagged(head), std::memory_order_relaxed);
+        } while (!m_head.compare_exchange_weak(head,
+                                               tagged(ptr, tagOf(head) + 1),
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed));
     }
 
     //--------------------------------------------------------------//
+    template<Chainable V, BackoffPolicy B, size_t N, EReclaim R>
+    inline typename IntrusiveMutexFreeStack<V, B, N, R>::pointer_type IntrusiveMutexFreeStack<V, B, N, R>::pop()
+        noexcept {
+        guard_type guard;
+        pointer_type head = m_head.load(std::memory_order_acquire);
+        B backoff(m_backoff);
+
+        while (true) {
+            pointer_type const node = untagged(head);
+            if (nullptr == node)
+                return nullptr;
+
+            if (!guard.protect(node, m_head, head))
+                continue;
+
+            // node may be already popped by other thread: value of next is checked by tag of head
+            pointer_type const next = NAtomic::load(&node->m_next, std::memory_order_relaxed);
+
+            if (m_head.compare_exchange_weak(head,
+                                             tagged(next, tagOf(head) + 1),
+                                             std::memory_order_acquire,
+                                             std::memory_order_acquire))
+                break;
+
+            // contention: collide with push or pause
+            pointer_type const offer = eliminatePop();
+            if (nullptr != offer) {
+                m_size.fetch_sub(1, std::memory_order_relaxed);
+                return offer;
+            }
 
-#pragma endregion IntrusiveMutexFreeStack
-
-#pragma region MutexFreeStack
-
-    //////////////////////////////////////////////////////////////////
-    // TODO: Alloc
-    template<class T>
-    class MutexFreeStack {
-        struct Node {
-            Node() = delete;
-
-            Node(const V& value);
-
-            template<typename... Args>
-            Node(Args&&... args);
-
-        public:
-            Node* m_next;
-            V m_value;
-        };
-
-    public:
-        typedef V value_type;
-        typedef V& reference;
-        typedef const V& const_reference;
-        typedef typename IntrusiveMutexFreeStack<T>::size_type size_type;
-
-    public:
-        MutexFreeStack();
-        ~MutexFreeStack();
-
-        MutexFreeStack(const MutexFreeStack& other) = delete;
-        MutexFreeStack(MutexFreeStack&& other) noexcept = delete;
-        MutexFreeStack& operator=(const MutexFreeStack& other) = delete;
-        MutexFreeStack& operator=(MutexFreeStack&& other) noexcept = delete;
-
-        bool empty() const noexcept;
-
-        size_type size() const noexcept;
-
-        void push(const value_type& value);
-
-        void push(value_type&& value);
-
-        template<typename... Args>
-        void emplace(Args&&... args);
-
-        bool pop(value_type& ref);
-
-        // TODO: void swap(IntrusiveMutexFreeStack& stack) noexcept;
-
-        void clear();
-
-    private:
-        IntrusiveMutexFreeStack<Node> m_stack;
-    };
+            backoff.retry();
+            head = m_head.load(std::memory_order_acquire);
+        }
 
-    //--------------------------------------------------------------//
-    template<class T>
-    MutexFreeStack<T>::MutexFreeStack()
-      : m_stack() { }
+        m_size.fetch_sub(1, std::memory_order_relaxed);
 
-    //--------------------------------------------------------------//
-    template<class T>
-    MutexFreeStack<T>::~MutexFreeStack() {
-        clear();
+        return untagged(head);
     }
 
     //--------------------------------------------------------------//
-    template<class T>
-    inline bool MutexFreeStack<T>::empty() const noexcept {
-        return m_stack.empty();
-    }
+    template<Chainable V, BackoffPolicy B, size_t N, EReclaim R>
+    bool IntrusiveMutexFreeStack<V, B, N, R>::eliminatePush(pointer_type ptr) noexcept {
+        if constexpr (0 == N) {
+            (void)ptr;
+            return false;
+        }
+        else {
+            std::atomic<V*>& offer = m_elimination[nextRandom() % N].m_offer;
 
-    //--------------------------------------------------------------//
-    template<class T>
-    inline typename MutexFreeStack<T>::size_type MutexFreeStack<T>::size() const noexcept {
-        return m_stack.size();
-    }
+            pointer_type expected = nullptr;
+            if (!offer.compare_exchange_strong(expected, ptr, std::memory_order_release, std::memory_order_relaxed))
+                return false;
 
-    //--------------------------------------------------------------//
-    template<class T>
-    inline void MutexFreeStack<T>::push(const value_type& value) {
-        Node* node = new Node(value);
-        return m_stack.push(node);
-    }
+            for (uint32_t i = 0; i < m_elimination_spin_cnt; ++i) {
+                CPU_PAUSE();
 
-    //--------------------------------------------------------------//
-    template<class T>
-    inline void MutexFreeStack<T>::push(value_type&& value) {
-        return emplace(std::move(value));
-    }
+                // taken: the same node offered again by popper is its own push, withdraw below is still correct
+                if (ptr != offer.load(std::memory_order_relaxed))
+                    return true;
+            }
 
-    //--------------------------------------------------------------//
-    template<class T>
-    template<typename... Args>
-    inline void MutexFreeStack<T>::emplace(Args&&... args) {
-        Node* node = new Node(std::forward<Args>(args)...);
-        return m_stack.push(node);
+            // withdraw, fails if taken meanwhile
+            expected = ptr;
+            return !offer.compare_exchange_strong(expected,
+                                                  nullptr,
+                                                  std::memory_order_relaxed,
+                                                  std::memory_order_relaxed);
+        }
     }
 
     //--------------------------------------------------------------//
-    template<class T>
-    bool MutexFreeStack<T>::pop(value_type& ref) {
-        Node* node = m_stack.pop();
-        if (nullptr == node)
-            return false;
-
-        try {
-            new (&ref) value_type(std::move(node->m_value));
-        }
-        catch (...) {
-            m_stack.push(node);
-            throw;
+    template<Chainable V, BackoffPolicy B, size_t N, EReclaim R>
+    typename IntrusiveMutexFreeStack<V, B, N, R>::pointer_type IntrusiveMutexFreeStack<V, B, N, R>::eliminatePop()
+        noexcept {
+        if constexpr (0 == N) {
+            return nullptr;
         }
+        else {
+            std::atomic<V*>& offer = m_elimination[nextRandom() % N].m_offer;
 
-        delete node;
-        return true;
-    }
+            pointer_type ptr = offer.load(std::memory_order_relaxed);
+            if (nullptr == ptr)
+                return nullptr;
 
-    //--------------------------------------------------------------//
-    template<class T>
-    void MutexFreeStack<T>::clear() {
-        Node* val = m_stack.pop();
-        while (val) {
-            delete val;
-            val = m_stack.pop();
+            if (!offer.compare_exchange_strong(ptr, nullptr, std::memory_order_acquire, std::memory_order_relaxed))
+                return nullptr;
+
+            return ptr;
         }
     }
 
     //--------------------------------------------------------------//
-    template<class T>
-    MutexFreeStack<T>::Node::Node(const V& value)
-      : m_next(nullptr)
-      , m_value(value) { }
+    template<Chainable V, BackoffPolicy B, size_t N, EReclaim R>
+    uint32_t IntrusiveMutexFreeStack<V, B, N, R>::nextRandom() noexcept {
+        // xorshift32, seed must be non-zero
+        static std::atomic<uint32_t> next_seed = 0;
+        static thread_local uint32_t state =
+            (next_seed.fetch_add(1, std::memory_order_relaxed) + 1) * 2654435761u | 1;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
 
     //--------------------------------------------------------------//
-    template<class T>
-    template<typename... Args>
-    MutexFreeStack<T>::Node::Node(Args&&... args)
-      : m_next(nullptr)
-      , m_value(std::forward<Args>(args)...) { }
-
-    //////////////////////////////////////////////////////////////////
 
-    //////////////////////////////////////////////////////////////////
-
-#pragma endregion MutexFreeStack
+#pragma endregion IntrusiveMutexFreeStack
 
 }  // namespace Relax
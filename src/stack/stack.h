@@ -0,0 +1,235 @@
+#pragma once
+
+#include <memory>
+
+#include "alloc/node_pool.h"
+#include "intrusive_stack.h"
+
+namespace Relax {
+
+#pragma region MutexFreeStack
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Alloc - node allocator. Default NodePoolAllocator<T> keeps popped nodes readable (type-stable),
+     * Reclaim == EReclaim::TypeStable needs type-stable Alloc.
+     * Reclaim != EReclaim::TypeStable: popped nodes are retired and freed by reclamation domain,
+     * any stateless Alloc (e.g. std::allocator) is allowed.
+     */
+    template<class T,
+             class Alloc = NodePoolAllocator<T>,
+             BackoffPolicy Backoff = TAdaptiveBackoff,
+             size_t NEliminationSlots = 8,
+             EReclaim Reclaim = EReclaim::TypeStable>
+    class MutexFreeStack {
+        struct Node : TChainableBase<Node> {
+            Node() = delete;
+
+            Node(const T& value);
+
+            template<typename... Args>
+            Node(Args&&... args);
+
+        public:
+            T m_value;
+        };
+
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node> node_allocator_type;
+        typedef std::allocator_traits<node_allocator_type> node_allocator_traits;
+
+    public:
+        typedef T value_type;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef Alloc allocator_type;
+        typedef typename IntrusiveMutexFreeStack<Node, Backoff, NEliminationSlots, Reclaim>::size_type size_type;
+
+    public:
+        MutexFreeStack();
+        explicit MutexFreeStack(const allocator_type& alloc);
+        ~MutexFreeStack();
+
+        MutexFreeStack(const MutexFreeStack& other) = delete;
+        MutexFreeStack(MutexFreeStack&& other) noexcept = delete;
+        MutexFreeStack& operator=(const MutexFreeStack& other) = delete;
+        MutexFreeStack& operator=(MutexFreeStack&& other) noexcept = delete;
+
+        bool empty() const noexcept;
+
+        size_type size() const noexcept;
+
+        void push(const value_type& value);
+
+        void push(value_type&& value);
+
+        template<typename... Args>
+        void emplace(Args&&... args);
+
+        bool pop(value_type& ref);
+
+        // TODO: void swap(MutexFreeStack& stack) noexcept;
+
+        void clear();
+
+    private:
+        template<typename... Args>
+        Node* createNode(Args&&... args);
+
+        void destroyNode(Node* node) noexcept;
+
+        // popped node: may be still read by concurrent guarded poppers
+        void releaseNode(Node* node) noexcept;
+
+        // deleter of retired node: stack may be already destroyed
+        static void reclaimNode(void* ptr) noexcept;
+
+    private:
+        IntrusiveMutexFreeStack<Node, Backoff, NEliminationSlots, Reclaim> m_stack;
+
+        node_allocator_type m_alloc;
+
+        static_assert(EReclaim::TypeStable == Reclaim || node_allocator_traits::is_always_equal::value,
+                      "retired nodes are freed by default constructed allocator");
+
+        // Treiber pop reads m_next of node popped and freed by other thread
+        static_assert(EReclaim::TypeStable != Reclaim || IsTypeStable<node_allocator_type>,
+                      "stack WO reclamation needs type-stable Alloc (NodePoolAllocator)");
+    };
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    MutexFreeStack<T, A, B, N, R>::MutexFreeStack()
+      : m_stack()
+      , m_alloc() { }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    MutexFreeStack<T, A, B, N, R>::MutexFreeStack(const allocator_type& alloc)
+      : m_stack()
+      , m_alloc(alloc) { }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    MutexFreeStack<T, A, B, N, R>::~MutexFreeStack() {
+        clear();
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    inline bool MutexFreeStack<T, A, B, N, R>::empty() const noexcept {
+        return m_stack.empty();
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    inline typename MutexFreeStack<T, A, B, N, R>::size_type MutexFreeStack<T, A, B, N, R>::size() const noexcept {
+        return m_stack.size();
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    inline void MutexFreeStack<T, A, B, N, R>::push(const value_type& value) {
+        Node* node = createNode(value);
+        return m_stack.push(node);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    inline void MutexFreeStack<T, A, B, N, R>::push(value_type&& value) {
+        return emplace(std::move(value));
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    template<typename... Args>
+    inline void MutexFreeStack<T, A, B, N, R>::emplace(Args&&... args) {
+        Node* node = createNode(std::forward<Args>(args)...);
+        return m_stack.push(node);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    bool MutexFreeStack<T, A, B, N, R>::pop(value_type& ref) {
+        Node* node = m_stack.pop();
+        if (nullptr == node)
+            return false;
+
+        try {
+            new (&ref) value_type(std::move(node->m_value));
+        }
+        catch (...) {
+            m_stack.push(node);
+            throw;
+        }
+
+        releaseNode(node);
+        return true;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    void MutexFreeStack<T, A, B, N, R>::clear() {
+        Node* node = m_stack.pop();
+        while (node) {
+            releaseNode(node);
+            node = m_stack.pop();
+        }
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    template<typename... Args>
+    typename MutexFreeStack<T, A, B, N, R>::Node* MutexFreeStack<T, A, B, N, R>::createNode(Args&&... args) {
+        Node* const node = node_allocator_traits::allocate(m_alloc, 1);
+        try {
+            node_allocator_traits::construct(m_alloc, node, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            node_allocator_traits::deallocate(m_alloc, node, 1);
+            throw;
+        }
+
+        return node;
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    void MutexFreeStack<T, A, B, N, R>::destroyNode(Node* node) noexcept {
+        node_allocator_traits::destroy(m_alloc, node);
+        node_allocator_traits::deallocate(m_alloc, node, 1);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    inline void MutexFreeStack<T, A, B, N, R>::releaseNode(Node* node) noexcept {
+        if constexpr (EReclaim::TypeStable == R)
+            destroyNode(node);
+        else
+            TReclaim<R>::retire(node, &reclaimNode);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    void MutexFreeStack<T, A, B, N, R>::reclaimNode(void* ptr) noexcept {
+        node_allocator_type alloc;
+        Node* const node = static_cast<Node*>(ptr);
+        node_allocator_traits::destroy(alloc, node);
+        node_allocator_traits::deallocate(alloc, node, 1);
+    }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    MutexFreeStack<T, A, B, N, R>::Node::Node(const T& value)
+      : m_value(value) { }
+
+    //--------------------------------------------------------------//
+    template<class T, class A, BackoffPolicy B, size_t N, EReclaim R>
+    template<typename... Args>
+    MutexFreeStack<T, A, B, N, R>::Node::Node(Args&&... args)
+      : m_value(std::forward<Args>(args)...) { }
+
+    //////////////////////////////////////////////////////////////////
+
+#pragma endregion MutexFreeStack
+
+}  // namespace Relax
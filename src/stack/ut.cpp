@@ -0,0 +1,279 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "stack.h"
+#include "test/test.h"
+
+namespace Test {
+    //////////////////////////////////////////////////////////////////
+    class TestIntrusiveMutexFreeStack : public ::testing::Test {
+    public:
+        struct Node {
+            Node* m_next = nullptr;
+            uint64_t m_value = 0;
+
+            // set while node is popped: two owners of one node - ABA
+            std::atomic<bool> m_is_owned = false;
+        };
+
+        using value_t = uint64_t;
+
+        TestIntrusiveMutexFreeStack() { }
+
+        TestIntrusiveMutexFreeStack(const TestIntrusiveMutexFreeStack& other) = delete;
+        TestIntrusiveMutexFreeStack(TestIntrusiveMutexFreeStack&& other) noexcept = delete;
+        TestIntrusiveMutexFreeStack& operator=(const TestIntrusiveMutexFreeStack& other) = delete;
+        TestIntrusiveMutexFreeStack& operator=(TestIntrusiveMutexFreeStack&& other) noexcept = delete;
+
+        // NEliminationSlots - see IntrusiveMutexFreeStack, 0 - no elimination
+        template<size_t NEliminationSlots = 8>
+        void testPushPop(uint64_t sample_size, uint32_t nproducers, uint32_t nconsumers);
+
+        template<size_t NEliminationSlots = 8, Relax::EReclaim Reclaim = Relax::EReclaim::TypeStable>
+        void testPopPush(uint32_t nnodes, uint32_t nthreads, uint32_t nrounds);
+
+        // MutexFreeStack with nodes freed by Reclaim policy
+        template<Relax::EReclaim Reclaim>
+        void testMutexFreeStack(uint32_t nthreads);
+
+    public:
+        static constexpr uint32_t m_sample_size = 2000000;
+    };
+
+    //--------------------------------------------------------------//
+    template<size_t NEliminationSlots>
+    void TestIntrusiveMutexFreeStack::testPushPop(uint64_t sample_size, uint32_t nproducers, uint32_t nconsumers) {
+        sample_size = sample_size - (sample_size % nproducers);
+        const uint64_t per_producer = sample_size / nproducers;
+
+        // nodes outlive the stack: type-stable memory
+        std::vector<Node> nodes(sample_size);
+        for (uint64_t i = 0; i < sample_size; ++i) {
+            nodes[i].m_value = i;
+        }
+
+        Relax::IntrusiveMutexFreeStack<Node, Relax::TAdaptiveBackoff, NEliminationSlots> stack;
+        std::atomic<uint64_t> npopped = 0;
+
+        auto run_result = RunThreads(nproducers + nconsumers,
+                                     [&](uint32_t thread_id, uint32_t nthreads) -> std::vector<value_t> {
+                                         (void)nthreads;
+                                         std::vector<value_t> values;
+
+                                         if (thread_id < nproducers) {
+                                             const uint64_t start = thread_id * per_producer;
+                                             for (uint64_t i = start; i < start + per_producer; ++i) {
+                                                 stack.push(&nodes[i]);
+                                             }
+
+                                             return values;
+                                         }
+
+                                         while (npopped.load(std::memory_order_relaxed) < sample_size) {
+                                             Node* const node = stack.pop();
+                                             if (nullptr == node) {
+                                                 std::this_thread::yield();
+                                                 continue;
+                                             }
+
+                                             npopped.fetch_add(1, std::memory_order_relaxed);
+                                             values.emplace_back(node->m_value);
+                                         }
+
+                                         return values;
+                                     });
+
+        ASSERT_EQ(nullptr, stack.pop());
+        ASSERT_TRUE(stack.empty());
+        ASSERT_EQ(0u, stack.size());
+
+        std::vector<value_t> all_values;
+        for (auto& thread_values : run_result.first) {
+            all_values.insert(all_values.end(), thread_values.begin(), thread_values.end());
+        }
+
+        ASSERT_EQ(sample_size, all_values.size());
+        std::sort(all_values.begin(), all_values.end());
+        for (uint64_t i = 0; i < sample_size; ++i) {
+            ASSERT_EQ(i, all_values[i]);
+        }
+    }
+
+    //--------------------------------------------------------------//
+    // few nodes circulate between threads: the same node is often pushed back under stale head of other popper
+    template<size_t NEliminationSlots, Relax::EReclaim Reclaim>
+    void TestIntrusiveMutexFreeStack::testPopPush(uint32_t nnodes, uint32_t nthreads, uint32_t nrounds) {
+        std::vector<Node> nodes(nnodes);
+        Relax::IntrusiveMutexFreeStack<Node, Relax::TAdaptiveBackoff, NEliminationSlots, Reclaim> stack;
+        for (Node& node : nodes) {
+            stack.push(&node);
+        }
+
+        auto run_result = RunThreads(nthreads, [&](uint32_t thread_id, uint32_t nthreads) -> bool {
+            (void)thread_id;
+            (void)nthreads;
+            bool result = true;
+
+            for (uint32_t i = 0; i < nrounds; ++i) {
+                Node* const node = stack.pop();
+                if (nullptr == node)
+                    continue;
+
+                result &= !node->m_is_owned.exchange(true, std::memory_order_relaxed);
+                node->m_is_owned.store(false, std::memory_order_relaxed);
+
+                stack.push(node);
+            }
+
+            return result;
+        });
+
+        for (bool thread_result : run_result.first) {
+            ASSERT_TRUE(thread_result);
+        }
+
+        ASSERT_EQ(nnodes, stack.size());
+
+        uint32_t count = 0;
+        while (nullptr != stack.pop()) {
+            ++count;
+        }
+        ASSERT_EQ(nnodes, count);
+    }
+
+    //--------------------------------------------------------------//
+    // each thread pushes and pops its own values: popped nodes are freed while other poppers may read them
+    template<Relax::EReclaim Reclaim>
+    void TestIntrusiveMutexFreeStack::testMutexFreeStack(uint32_t nthreads) {
+        const uint64_t per_thread = m_sample_size / nthreads;
+
+        Relax::MutexFreeStack<value_t, std::allocator<value_t>, Relax::TAdaptiveBackoff, 8, Reclaim> stack;
+        auto run_result = RunThreads(nthreads, [&](uint32_t thread_id, uint32_t nthreads) -> std::vector<value_t> {
+            (void)nthreads;
+            std::vector<value_t> values;
+            values.reserve(per_thread);
+
+            const uint64_t start = thread_id * per_thread;
+            value_t value;
+            for (uint64_t i = start; i < start + per_thread; ++i) {
+                stack.push(i);
+                while (!stack.pop(value)) {
+                    std::this_thread::yield();
+                }
+                values.emplace_back(value);
+            }
+
+            return values;
+        });
+
+        ASSERT_TRUE(stack.empty());
+
+        std::vector<value_t> all_values;
+        for (auto& thread_values : run_result.first) {
+            all_values.insert(all_values.end(), thread_values.begin(), thread_values.end());
+        }
+
+        ASSERT_EQ(nthreads * per_thread, all_values.size());
+        std::sort(all_values.begin(), all_values.end());
+        for (uint64_t i = 0; i < all_values.size(); ++i) {
+            ASSERT_EQ(i, all_values[i]);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestIntrusiveMutexFreeStack, PushPopOrder) {
+        std::vector<Node> nodes(16);
+        Relax::IntrusiveMutexFreeStack<Node> stack;
+
+        ASSERT_TRUE(stack.empty());
+        ASSERT_EQ(nullptr, stack.pop());
+
+        for (Node& node : nodes) {
+            stack.push(&node);
+        }
+        ASSERT_EQ(nodes.size(), stack.size());
+
+        for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+            ASSERT_EQ(&(*it), stack.pop());
+        }
+        ASSERT_TRUE(stack.empty());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeStack, MTPushPop_1_1) {
+        testPushPop(m_sample_size, 1, 1);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeStack, MTPushPop_8_8) {
+        testPushPop(m_sample_size, 8, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeStack, MTPopPush_4_32) {
+        testPopPush(4, 32, 200000);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeStack, MTPushPopNoElimination_8_8) {
+        testPushPop<0>(m_sample_size, 8, 8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeStack, MTPopPushNoElimination_4_32) {
+        testPopPush<0>(4, 32, 200000);
+    }
+
+    //--------------------------------------------------------------//
+    // single slot: offers of all threads collide
+    TEST_F(TestIntrusiveMutexFreeStack, MTPopPushElimination1_64_32) {
+        testPopPush<1>(64, 32, 200000);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeStack, MTPopPushHazard_4_32) {
+        testPopPush<8, Relax::EReclaim::HazardPointers>(4, 32, 200000);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeStack, MTPopPushEpoch_4_32) {
+        testPopPush<8, Relax::EReclaim::EpochBased>(4, 32, 200000);
+    }
+
+    //////////////////////////////////////////////////////////////////
+    TEST_F(TestIntrusiveMutexFreeStack, MutexFreeStack) {
+        Relax::MutexFreeStack<std::string> stack;
+        std::string value;
+
+        ASSERT_FALSE(stack.pop(value));
+
+        for (uint32_t i = 0; i < 10; ++i) {
+            stack.push(std::to_string(i));
+        }
+        ASSERT_EQ(10u, stack.size());
+
+        for (uint32_t i = 10; 0 < i; --i) {
+            ASSERT_TRUE(stack.pop(value));
+            ASSERT_EQ(std::to_string(i - 1), value);
+        }
+        ASSERT_FALSE(stack.pop(value));
+        ASSERT_TRUE(stack.empty());
+
+        // left for destructor
+        stack.emplace(3, 'x');
+        stack.push("tail");
+        ASSERT_EQ(2u, stack.size());
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeStack, MTMutexFreeStackHazard_8) {
+        testMutexFreeStack<Relax::EReclaim::HazardPointers>(8);
+    }
+
+    //--------------------------------------------------------------//
+    TEST_F(TestIntrusiveMutexFreeStack, MTMutexFreeStackEpoch_8) {
+        testMutexFreeStack<Relax::EReclaim::EpochBased>(8);
+    }
+
+}  // namespace Test
@@ -39,6 +39,12 @@ namespace Relax {
             return __atomic_exchange_n(ptr, value, int(mode));
         }
 
+        template<typename T>
+        inline T fetch_add(T* ptr, T value, std::memory_order mode) {
+            AssertIsAtomic(ptr);
+            return __atomic_fetch_add(ptr, value, int(mode));
+        }
+
         template<typename T>
         inline bool compare_exchange_strong(T* ptr,
                                                    T* expected,
@@ -89,6 +95,12 @@ namespace Relax {
             return _InterlockedExchange(ptr, value);
         }
 
+        template<typename T>
+        inline T fetch_add(T* ptr, T value, std::memory_order mode) {
+            AssertIsAtomic(ptr);
+            return _InterlockedExchangeAdd(ptr, value);
+        }
+
         template<typename T>
         inline bool compare_exchange_strong(T* ptr,
                                                    T* expected,
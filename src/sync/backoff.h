@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "common.h"
+#include "event.h"
+#include "types.h"
+
+namespace Relax {
+
+    template<typename T>
+    concept BackoffPolicy = requires(T backoff, typename T::TShared& shared) {
+        backoff.pause([] { return true; });
+        backoff.retry();
+        T::notify(shared);
+    };
+
+#pragma region Backoff
+
+    /*
+     * Backoff policy of contended loop:
+     *    Backoff backoff(m_backoff_shared);
+     *    while (!acquired()) backoff.pause([&] { return available(); });
+     * Owner calls Backoff::notify(m_backoff_shared) after release.
+     *  * TShared - state of one container shared by its waiters
+     *  * ready - cheap check of availability, used before parking
+     *  * retry - pause of CAS retry loop: nothing to wait for, never parks
+     */
+
+    //////////////////////////////////////////////////////////////////
+    // pause count adapts to previous waits: +1 per extra pause, -1 per wait WO contention
+    class TAdaptiveBackoff {
+    public:
+        struct TShared {
+            alignas(CACHELINE_SIZE) std::atomic<uint32_t> m_pause_cnt = 1;
+        };
+
+        explicit TAdaptiveBackoff(TShared& shared) noexcept
+          : m_shared(shared)
+          , m_old_pause_cnt(shared.m_pause_cnt.load(std::memory_order_relaxed))
+          , m_pause_cnt(0) { }
+
+        ~TAdaptiveBackoff() {
+            const uint32_t pause_cnt = (m_pause_cnt <= m_old_pause_cnt) ? std::max(1u, m_old_pause_cnt - 1)
+                                                                        : m_pause_cnt;
+            if (pause_cnt != m_old_pause_cnt)
+                m_shared.m_pause_cnt.store(pause_cnt, std::memory_order_relaxed);
+        }
+
+        TAdaptiveBackoff(const TAdaptiveBackoff& other) = delete;
+        TAdaptiveBackoff(TAdaptiveBackoff&& other) noexcept = delete;
+        TAdaptiveBackoff& operator=(const TAdaptiveBackoff& other) = delete;
+        TAdaptiveBackoff& operator=(TAdaptiveBackoff&& other) noexcept = delete;
+
+        template<typename Ready>
+        inline void pause(Ready&&) noexcept {
+            if (0 == m_pause_cnt) {
+                m_pause_cnt = m_old_pause_cnt;
+                for (uint32_t i = 0; i < m_old_pause_cnt; ++i)
+                    CPU_PAUSE();
+            }
+            else {
+                CPU_PAUSE();
+                ++m_pause_cnt;
+            }
+        }
+
+        inline void retry() noexcept {
+            pause([] { return true; });
+        }
+
+        static inline void notify(TShared&) noexcept { }
+
+    private:
+        TShared& m_shared;
+
+        const uint32_t m_old_pause_cnt;
+
+        uint32_t m_pause_cnt;
+    };
+
+    //////////////////////////////////////////////////////////////////
+    // pause count doubles from MinPauses up to MaxPauses
+    template<uint32_t MinPauses = 1, uint32_t MaxPauses = 1024>
+    class TExpBackoff {
+        static_assert(0 < MinPauses && MinPauses <= MaxPauses, "");
+
+    public:
+        struct TShared { };
+
+        explicit TExpBackoff(TShared&) noexcept
+          : m_pause_cnt(MinPauses) { }
+
+        TExpBackoff(const TExpBackoff& other) = delete;
+        TExpBackoff(TExpBackoff&& other) noexcept = delete;
+        TExpBackoff& operator=(const TExpBackoff& other) = delete;
+        TExpBackoff& operator=(TExpBackoff&& other) noexcept = delete;
+
+        template<typename Ready>
+        inline void pause(Ready&&) noexcept {
+            for (uint32_t i = 0; i < m_pause_cnt; ++i)
+                CPU_PAUSE();
+
+            m_pause_cnt = std::min(2 * m_pause_cnt, MaxPauses);
+        }
+
+        inline void retry() noexcept {
+            pause([] { return true; });
+        }
+
+        static inline void notify(TShared&) noexcept { }
+
+    private:
+        uint32_t m_pause_cnt;
+    };
+
+    //////////////////////////////////////////////////////////////////
+    // NSpins single pauses, then sched_yield: gives CPU to preempted owner
+    template<uint32_t NSpins = 64>
+    class TYieldBackoff {
+    public:
+        struct TShared { };
+
+        explicit TYieldBackoff(TShared&) noexcept
+          : m_spin_cnt(0) { }
+
+        TYieldBackoff(const TYieldBackoff& other) = delete;
+        TYieldBackoff(TYieldBackoff&& other) noexcept = delete;
+        TYieldBackoff& operator=(const TYieldBackoff& other) = delete;
+        TYieldBackoff& operator=(TYieldBackoff&& other) noexcept = delete;
+
+        template<typename Ready>
+        inline void pause(Ready&&) noexcept {
+            if (m_spin_cnt < NSpins) {
+                ++m_spin_cnt;
+                CPU_PAUSE();
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+
+        inline void retry() noexcept {
+            pause([] { return true; });
+        }
+
+        static inline void notify(TShared&) noexcept { }
+
+    private:
+        uint32_t m_spin_cnt;
+    };
+
+    //////////////////////////////////////////////////////////////////
+    // NSpins single pauses, then parks on futex until owner's notify
+    template<uint32_t NSpins = 64>
+    class TParkBackoff {
+    public:
+        struct TShared {
+            TEventCount m_event;
+        };
+
+        explicit TParkBackoff(TShared& shared) noexcept
+          : m_shared(shared)
+          , m_spin_cnt(0) { }
+
+        TParkBackoff(const TParkBackoff& other) = delete;
+        TParkBackoff(TParkBackoff&& other) noexcept = delete;
+        TParkBackoff& operator=(const TParkBackoff& other) = delete;
+        TParkBackoff& operator=(TParkBackoff&& other) noexcept = delete;
+
+        template<typename Ready>
+        inline void pause(Ready&& ready) noexcept {
+            if (m_spin_cnt < NSpins) {
+                ++m_spin_cnt;
+                CPU_PAUSE();
+                return;
+            }
+
+            const int32_t key = m_shared.m_event.prepareWait();
+            // release of owner isn't seq_cst: fences on both sides
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ready())
+                m_shared.m_event.cancelWait();
+            else
+                m_shared.m_event.commitWait(key);
+        }
+
+        // no owner's release to park for: spin, then yield WO touching event of waiters
+        inline void retry() noexcept {
+            if (m_spin_cnt < NSpins) {
+                ++m_spin_cnt;
+                CPU_PAUSE();
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+
+        static inline void notify(TShared& shared) noexcept {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            // all: woken waiter may leave WO acquire (e.g. on empty container) and not notify next one
+            shared.m_event.notify(INT32_MAX);
+        }
+
+    private:
+        TShared& m_shared;
+
+        uint32_t m_spin_cnt;
+    };
+
+#pragma endregion Backoff
+
+}  // namespace Relax
@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <cassert>
+#include <chrono>
 
 #include "atomic.h"
 #include "common.h"
@@ -10,6 +11,10 @@
 #if LIN
     #include <linux/futex.h>
     #include <sys/syscall.h>
+    #include <unistd.h>
+#else
+    #include <condition_variable>
+    #include <mutex>
 #endif
 
 namespace Relax {
@@ -22,15 +27,51 @@ namespace Relax {
 #endif
     }
 
+#if LIN
+    //---------------------------------------------------------//
+    // sleeps while *addr == expected, returns false on timeout
+    inline bool FutexWait(int32_t* addr, int32_t expected, const struct timespec* timeout)
+    {
+        const auto res = ::syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+        assert(res != -1 || EINVAL != GetOSError());
+        assert(res != -1 || ENOSYS != GetOSError());
+        // EAGAIN/EWOULDBLOCK/EINTR - ok
+        return (res != -1) || (ETIMEDOUT != GetOSError());
+    }
+
+    //---------------------------------------------------------//
+    inline void FutexWake(int32_t* addr, int32_t count)
+    {
+        const auto res = ::syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+        (void)res;
+        assert(0 <= res);
+    }
+
+    //---------------------------------------------------------//
+    // relative timeout for FUTEX_WAIT, false if deadline passed
+    inline bool FutexTimeout(std::chrono::steady_clock::time_point deadline, struct timespec& timeout)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (deadline <= now)
+            return false;
+
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+        timeout.tv_sec = ns / 1000000000;
+        timeout.tv_nsec = ns % 1000000000;
+        return true;
+    }
+#endif
+
 #pragma region IntrusiveMutexFreeQueue
 
     // TODO: win: wait on address
+    // Manual-reset event: set() makes syscall only if there are sleeping waiters
     class alignas(CACHELINE_SIZE) TEvent
     {
     public:
 
         TEvent()
-          : m_sync(0)
+          : m_sync(m_unset)
 #if !LIN
           , m_mutex()
           , m_condvar()
@@ -44,17 +85,34 @@ namespace Relax {
 
         inline void reinit();
 
-        // TODO: timed
         inline void set();
 
+        inline bool is_set() const noexcept;
+
         inline void wait();
 
+        // false on timeout
+        template<class Rep, class Period>
+        inline bool wait_for(const std::chrono::duration<Rep, Period>& timeout);
+
+    private:
+#if LIN
+        // false if event is set, otherwise marks that waiter is going to sleep
+        inline bool markWaiter(int32_t& sync) noexcept;
+#endif
+
     private:
+        static constexpr int32_t m_unset = 0;
+
+        static constexpr int32_t m_set = 1;
+
+        // unset, waiters sleep: set() must wake them
+        static constexpr int32_t m_waited = 2;
 
         int32_t m_sync;
 
 #if !LIN
-        std::mutex m_mutex;
+        mutable std::mutex m_mutex;
 
         std::condition_variable m_condvar;
 #endif
@@ -64,10 +122,10 @@ namespace Relax {
     void TEvent::reinit()
     {
 #if LIN
-        NAtomic::store(&m_sync, 0, std::memory_order_release);
+        NAtomic::store(&m_sync, m_unset, std::memory_order_release);
 #else
         std::lock_guard<std::mutex> g(m_mutex);
-        m_sync = 0;
+        m_sync = m_unset;
 #endif
     }
 
@@ -75,32 +133,208 @@ namespace Relax {
     void TEvent::set()
     {
 #if LIN
-        NAtomic::store(&m_sync, 1, std::memory_order_release);
-        const auto res = ::syscall(SYS_futex, &m_sync, FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
-        assert((decltype(res))0 <= res);
+        if (m_waited == NAtomic::exchange(&m_sync, m_set, std::memory_order_release))
+            FutexWake(&m_sync, INT32_MAX);
 #else
         std::lock_guard<std::mutex> g(m_mutex);
-        m_sync = 1;
+        m_sync = m_set;
         m_condvar.notify_all();
 #endif
     }
 
+    //---------------------------------------------------------//
+    bool TEvent::is_set() const noexcept
+    {
+#if LIN
+        return m_set == NAtomic::load(&m_sync, std::memory_order_acquire);
+#else
+        std::lock_guard<std::mutex> g(m_mutex);
+        return m_set == m_sync;
+#endif
+    }
+
+#if LIN
+    //---------------------------------------------------------//
+    bool TEvent::markWaiter(int32_t& sync) noexcept
+    {
+        while (m_set != sync) {
+            if (m_waited == sync)
+                return true;
+
+            if (NAtomic::compare_exchange_weak(&m_sync,
+                                               &sync,
+                                               m_waited,
+                                               std::memory_order_relaxed,
+                                               std::memory_order_acquire))
+                return true;
+        }
+
+        return false;
+    }
+#endif
+
     //---------------------------------------------------------//
     void TEvent::wait()
     {
 #if LIN
         int32_t sync = NAtomic::load(&m_sync, std::memory_order_acquire);
-        while (0 == sync) {
-            const auto res = ::syscall(SYS_futex, &m_sync, FUTEX_WAIT_PRIVATE, 0, nullptr, nullptr, 0);
-            assert(res != -1 || EINVAL != GetOSError());
-            assert(res != -1 || ENOSYS != GetOSError());
-            // EAGAIN/EWOULDBLOCK/EINTR - ok
+        while (markWaiter(sync)) {
+            FutexWait(&m_sync, m_waited, nullptr);
+            sync = NAtomic::load(&m_sync, std::memory_order_acquire);
+        }
+
+#else
+        std::unique_lock<std::mutex> g(m_mutex);
+        m_condvar.wait(g, [&] {return m_sync == m_set;});
+#endif
+    };
+
+    //---------------------------------------------------------//
+    template<class Rep, class Period>
+    bool TEvent::wait_for(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+#if LIN
+        struct timespec rel_timeout;
+        int32_t sync = NAtomic::load(&m_sync, std::memory_order_acquire);
+        while (markWaiter(sync)) {
+            if (!FutexTimeout(deadline, rel_timeout))
+                return false;
+
+            FutexWait(&m_sync, m_waited, &rel_timeout);
             sync = NAtomic::load(&m_sync, std::memory_order_acquire);
         }
 
+        return true;
 #else
         std::unique_lock<std::mutex> g(m_mutex);
-        m_condvar.wait(g, [&] {return m_sync == 1;});
+        return m_condvar.wait_until(g, deadline, [&] {return m_sync == m_set;});
+#endif
+    }
+
+#pragma endregion IntrusiveMutexFreeQueue
+
+#pragma region TEventCount
+
+    //////////////////////////////////////////////////////////////
+    /*
+     * Parking for waiters on external condition (e.g. non-empty queue):
+     *    key = prepareWait(); if (condition) cancelWait(); else commitWait(key);
+     * Notifier changes condition, then notify(): no syscall WO registered waiters.
+     * Condition must be changed and checked by seq_cst atomics, otherwise wake may be lost.
+     */
+    class alignas(CACHELINE_SIZE) TEventCount
+    {
+    public:
+
+        TEventCount()
+          : m_epoch(0)
+          , m_nwaiters(0)
+#if !LIN
+          , m_mutex()
+          , m_condvar()
+#endif
+        { }
+
+        TEventCount(const TEventCount& other) = delete;
+        TEventCount(TEventCount&& other) noexcept = delete;
+        TEventCount& operator=(const TEventCount& other) = delete;
+        TEventCount& operator=(TEventCount&& other) noexcept = delete;
+
+        // registers waiter, condition must be checked after it
+        inline int32_t prepareWait() noexcept;
+
+        inline void cancelWait() noexcept;
+
+        // sleeps until notify after prepareWait (or spuriously), unregisters waiter
+        inline void commitWait(int32_t key) noexcept;
+
+        // false on timeout
+        inline bool commitWaitUntil(int32_t key, std::chrono::steady_clock::time_point deadline) noexcept;
+
+        // wakes up to count waiters
+        inline void notify(int32_t count) noexcept;
+
+    private:
+
+        int32_t m_epoch;
+
+        int32_t m_nwaiters;
+
+#if !LIN
+        std::mutex m_mutex;
+
+        std::condition_variable m_condvar;
 #endif
     };
+
+    //---------------------------------------------------------//
+    int32_t TEventCount::prepareWait() noexcept
+    {
+        // either waiter sees condition or notifier sees waiter
+        NAtomic::fetch_add(&m_nwaiters, 1, std::memory_order_seq_cst);
+        return NAtomic::load(&m_epoch, std::memory_order_seq_cst);
+    }
+
+    //---------------------------------------------------------//
+    void TEventCount::cancelWait() noexcept
+    {
+        NAtomic::fetch_add(&m_nwaiters, -1, std::memory_order_relaxed);
+    }
+
+    //---------------------------------------------------------//
+    void TEventCount::commitWait(int32_t key) noexcept
+    {
+#if LIN
+        if (key == NAtomic::load(&m_epoch, std::memory_order_acquire)) {
+            FutexWait(&m_epoch, key, nullptr);
+        }
+#else
+        {
+            std::unique_lock<std::mutex> g(m_mutex);
+            m_condvar.wait(g, [&] {return key != NAtomic::load(&m_epoch, std::memory_order_acquire);});
+        }
+#endif
+        cancelWait();
+    }
+
+    //---------------------------------------------------------//
+    bool TEventCount::commitWaitUntil(int32_t key, std::chrono::steady_clock::time_point deadline) noexcept
+    {
+        bool result = true;
+#if LIN
+        struct timespec rel_timeout;
+        if (key == NAtomic::load(&m_epoch, std::memory_order_acquire)) {
+            result = FutexTimeout(deadline, rel_timeout) && FutexWait(&m_epoch, key, &rel_timeout);
+        }
+#else
+        {
+            std::unique_lock<std::mutex> g(m_mutex);
+            result = m_condvar.wait_until(g, deadline, [&] {
+                return key != NAtomic::load(&m_epoch, std::memory_order_acquire);
+            });
+        }
+#endif
+        cancelWait();
+        return result;
+    }
+
+    //---------------------------------------------------------//
+    void TEventCount::notify(int32_t count) noexcept
+    {
+        if (0 == NAtomic::load(&m_nwaiters, std::memory_order_seq_cst))
+            return;
+
+#if LIN
+        NAtomic::fetch_add(&m_epoch, 1, std::memory_order_release);
+        FutexWake(&m_epoch, count);
+#else
+        (void)count;
+        std::lock_guard<std::mutex> g(m_mutex);
+        NAtomic::fetch_add(&m_epoch, 1, std::memory_order_release);
+        m_condvar.notify_all();
+#endif
+    }
+
+#pragma endregion TEventCount
 }
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+
+#include "backoff.h"
+#include "common.h"
+#include "types.h"
+
+namespace Relax {
+
+#pragma region TSeqLock
+
+    //////////////////////////////////////////////////////////////////
+    /*
+     * Sequence lock: writers are exclusive, readers take no lock and do not write shared memory.
+     *    const uint64_t version = lock.read_begin();
+     *    ... read protected data (may be torn) ...
+     *    if (lock.read_retry(version)) ... retry
+     *  * Version is odd while writer holds the lock, each write section adds 2
+     *  * Readers must not follow what they read without bounds: data may be torn until validated
+     *  * Backoff - policy of writers waiting for writer and readers waiting for end of write section
+     */
+    template<BackoffPolicy Backoff = TYieldBackoff<>>
+    class alignas(CACHELINE_SIZE) TSeqLock {
+    public:
+        TSeqLock() = default;
+
+        TSeqLock(const TSeqLock& other) = delete;
+        TSeqLock(TSeqLock&& other) noexcept = delete;
+        TSeqLock& operator=(const TSeqLock& other) = delete;
+        TSeqLock& operator=(TSeqLock&& other) noexcept = delete;
+
+        void lock() noexcept;
+
+        bool try_lock() noexcept;
+
+        void unlock() noexcept;
+
+        // even version to validate read against: waits while writer holds the lock
+        uint64_t read_begin() const noexcept;
+
+        // true: writer ran since read_begin, data read since may be torn
+        bool read_retry(uint64_t version) const noexcept;
+
+    private:
+        std::atomic<uint64_t> m_version = 0;
+
+        mutable typename Backoff::TShared m_backoff_shared;
+    };
+
+    //--------------------------------------------------------------//
+    template<BackoffPolicy B>
+    inline bool TSeqLock<B>::try_lock() noexcept {
+        uint64_t version = m_version.load(std::memory_order_relaxed);
+        if (0 != (version & 1) ||
+            !m_version.compare_exchange_strong(version, version + 1, std::memory_order_acquire))
+            return false;
+
+        // odd version is visible before any store of write section
+        std::atomic_thread_fence(std::memory_order_release);
+        return true;
+    }
+
+    //--------------------------------------------------------------//
+    template<BackoffPolicy B>
+    void TSeqLock<B>::lock() noexcept {
+        if (try_lock())
+            return;
+
+        B backoff(m_backoff_shared);
+        do {
+            backoff.pause([this] { return 0 == (m_version.load(std::memory_order_relaxed) & 1); });
+        } while (!try_lock());
+    }
+
+    //--------------------------------------------------------------//
+    template<BackoffPolicy B>
+    inline void TSeqLock<B>::unlock() noexcept {
+        m_version.fetch_add(1, std::memory_order_release);
+        B::notify(m_backoff_shared);
+    }
+
+    //--------------------------------------------------------------//
+    template<BackoffPolicy B>
+    inline uint64_t TSeqLock<B>::read_begin() const noexcept {
+        uint64_t version = m_version.load(std::memory_order_acquire);
+        if (0 == (version & 1))
+            return version;
+
+        B backoff(m_backoff_shared);
+        do {
+            backoff.pause([this] { return 0 == (m_version.load(std::memory_order_relaxed) & 1); });
+            version = m_version.load(std::memory_order_acquire);
+        } while (0 != (version & 1));
+
+        return version;
+    }
+
+    //--------------------------------------------------------------//
+    template<BackoffPolicy B>
+    inline bool TSeqLock<B>::read_retry(uint64_t version) const noexcept {
+        // loads of read section are not reordered after the version check
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return version != m_version.load(std::memory_order_relaxed);
+    }
+
+#pragma endregion TSeqLock
+
+}  // namespace Relax
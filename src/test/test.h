@@ -1,10 +1,22 @@
 #pragma once
 
+#include <atomic>
+#include <fstream>
 #include <future>
 #include <list>
+#include <memory>
 
+#include "common.h"
 #include "utils/utils.h"
 
+#if LIN
+    #include <linux/perf_event.h>
+    #include <malloc.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
 namespace Test {
     //////////////////////////////////////////////////////////////////
     template<class T>
@@ -150,4 +162,152 @@ namespace Test {
         return {Duration(e), dev};
     }
 
-}  // namespace Test
\ No newline at end of file
+
+    //////////////////////////////////////////////////////////////////
+    // system allocations of benched containers: std::allocator counting allocations of all its rebinds
+    struct TAllocCount {
+        static inline std::atomic<uint64_t> m_nallocs = 0;
+    };
+
+    //--------------------------------------------------------------//
+    template<class T>
+    class TCountingAllocator : public std::allocator<T> {
+    public:
+        template<class U>
+        struct rebind {
+            typedef TCountingAllocator<U> other;
+        };
+
+    public:
+        TCountingAllocator() noexcept = default;
+
+        template<class U>
+        TCountingAllocator(const TCountingAllocator<U>& other) noexcept {
+            (void)other;
+        }
+
+        T* allocate(size_t n) {
+            TAllocCount::m_nallocs.fetch_add(1, std::memory_order_relaxed);
+            return std::allocator<T>::allocate(n);
+        }
+
+        static uint64_t nallocs() { return TAllocCount::m_nallocs.load(std::memory_order_relaxed); }
+    };
+
+    //////////////////////////////////////////////////////////////////
+    // resident set size of process, 0 if unknown
+    inline uint64_t ResidentKiB() {
+#if LIN
+        std::ifstream statm("/proc/self/statm");
+        uint64_t size = 0;
+        uint64_t resident = 0;
+        statm >> size >> resident;
+        return resident * (uint64_t)sysconf(_SC_PAGESIZE) / 1024;
+#else
+        return 0;
+#endif
+    }
+
+    //--------------------------------------------------------------//
+    // returns free heap memory to the system: RSS of next bench does not include memory freed by previous one
+    inline void TrimHeap() {
+#if LIN
+        malloc_trim(0);
+#endif
+    }
+
+    //--------------------------------------------------------------//
+    // anonymous memory of process backed by transparent huge pages
+    inline uint64_t AnonHugePagesKiB() {
+#if LIN
+        std::ifstream smaps("/proc/self/smaps_rollup");
+        std::string name;
+        uint64_t kib = 0;
+        while (smaps >> name) {
+            if ("AnonHugePages:" == name) {
+                smaps >> kib;
+                break;
+            }
+        }
+        return kib;
+#else
+        return 0;
+#endif
+    }
+
+    //////////////////////////////////////////////////////////////////
+    // dTLB load misses of calling thread in user space. Hardware counters may be unavailable (VM, non-Linux)
+    class TTLBMissCounter {
+    public:
+        TTLBMissCounter();
+        ~TTLBMissCounter();
+
+        TTLBMissCounter(const TTLBMissCounter& other) = delete;
+        TTLBMissCounter(TTLBMissCounter&& other) noexcept = delete;
+        TTLBMissCounter& operator=(const TTLBMissCounter& other) = delete;
+        TTLBMissCounter& operator=(TTLBMissCounter&& other) noexcept = delete;
+
+        inline bool available() const noexcept { return 0 <= m_fd; }
+
+        void start() noexcept;
+
+        // misses since start, -1 if counter is not available
+        int64_t stop() noexcept;
+
+    private:
+        int m_fd = -1;
+    };
+
+    //--------------------------------------------------------------//
+    inline TTLBMissCounter::TTLBMissCounter() {
+#if LIN
+        perf_event_attr attr = {};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        m_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    //--------------------------------------------------------------//
+    inline TTLBMissCounter::~TTLBMissCounter() {
+#if LIN
+        if (available())
+            close(m_fd);
+#endif
+    }
+
+    //--------------------------------------------------------------//
+    inline void TTLBMissCounter::start() noexcept {
+#if LIN
+        if (!available())
+            return;
+
+        ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    //--------------------------------------------------------------//
+    inline int64_t TTLBMissCounter::stop() noexcept {
+#if LIN
+        if (!available())
+            return -1;
+
+        ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t count = 0;
+        if (sizeof(count) != read(m_fd, &count, sizeof(count)))
+            return -1;
+
+        return (int64_t)count;
+#else
+        return -1;
+#endif
+    }
+
+}  // namespace Test